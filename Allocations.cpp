@@ -0,0 +1,90 @@
+#include "Allocations.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * The number of allocations so far. 
+ */
+static atomic<long> allocations(0);
+
+void Allocations::add() noexcept {
+  allocations.fetch_add(1, memory_order_relaxed);
+}
+
+long Allocations::getCount() noexcept {
+  return allocations.load(memory_order_relaxed);
+}
+
+/**
+ * Allocates and counts memory, as operator new must, trying again
+ * for as long as there is a new handler to free some up. 
+ */
+static void* allocate(size_t size) noexcept {
+  Allocations::add();
+  for (;;) {
+    void* memory = malloc(size ? size : 1);
+    if (memory) {
+      return memory;
+    }
+    new_handler handler = get_new_handler();
+    if (!handler) {
+      return nullptr;
+    }
+    handler();
+  }
+}
+
+void* operator new(size_t size) {
+  void* memory = allocate(size);
+  if (!memory) {
+    throw bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new[](size_t size) {
+  void* memory = allocate(size);
+  if (!memory) {
+    throw bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+  return allocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+  free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  free(memory);
+}
+
+void operator delete(void* memory, const nothrow_t&) noexcept {
+  free(memory);
+}
+
+void operator delete[](void* memory, const nothrow_t&) noexcept {
+  free(memory);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void* memory, size_t) noexcept {
+  free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+  free(memory);
+}
+#endif
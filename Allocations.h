@@ -0,0 +1,33 @@
+#ifndef MEDIEVAL_ALLOCATIONS_H
+#define MEDIEVAL_ALLOCATIONS_H
+
+namespace medieval {
+
+/**
+ * An allocation counter class. Linking this in replaces the global
+ * operator new so that every heap allocation the program makes is
+ * counted, and anything else that allocates, such as SDL, can add
+ * its own. Comparing the count before and after some code shows 
+ * whether it allocated. 
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Allocations {
+public:
+
+  /**
+   * Counts an allocation made outside operator new. 
+   */
+  static void add() noexcept;
+
+  /**
+   * Get the number of allocations so far, from every thread.
+   * @return the number of allocations
+   */
+  static long getCount() noexcept;
+};
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+#include "Analytics.h"
+
+#include <stdexcept>
+
+using namespace std;
+using namespace medieval;
+
+Analytics::Analytics(const string& path, uint64_t session) : blocks_(BLOCKS) {
+  file_ = fopen(path.c_str(), "wb");
+  if (!file_) {
+    throw domain_error("Unable to open " + path + " for analytics");
+  }
+  uint32_t header[] = { FILE_MAGIC, VERSION, static_cast<uint32_t>(session),
+			static_cast<uint32_t>(session >> 32) };
+  if (fwrite(header, sizeof(header), 1, file_) != 1) {
+    fclose(file_);
+    throw domain_error("Unable to write analytics to " + path);
+  }
+  writer_.start([this](int block) -> long {
+      return writeBlock(blocks_[block]) ? blocks_[block].count : -1;
+    });
+}
+
+Analytics::~Analytics() {
+  close();
+}
+
+void Analytics::close() noexcept {
+  if (!file_) {
+    return;
+  }
+  flush();
+  writer_.close();
+  fclose(file_);
+  file_ = nullptr;
+}
+
+void Analytics::flush() noexcept {
+  if (held_ < 0 || blocks_[held_].count == 0) {
+    return;
+  }
+  writer_.submit(held_);
+  held_ = -1;
+}
+
+long Analytics::getWritten() const noexcept {
+  return writer_.getWritten();
+}
+
+long Analytics::getDropped() const noexcept {
+  return dropped_;
+}
+
+bool Analytics::failed() const noexcept {
+  return writer_.failed();
+}
+
+bool Analytics::take() noexcept {
+  held_ = writer_.acquire(false);
+  if (held_ < 0) {
+    return false;
+  }
+  blocks_[held_].count = 0;
+  return true;
+}
+
+bool Analytics::writeBlock(const Block& block) noexcept {
+  size_t count = block.count;
+  uint32_t header[] = { BLOCK_MAGIC, block.count };
+  return fwrite(header, sizeof(header), 1, file_) == 1 &&
+    fwrite(block.ticks, sizeof(block.ticks[0]), count, file_) == count &&
+    fwrite(block.levels, sizeof(block.levels[0]), count, file_) == count &&
+    fwrite(block.events, sizeof(block.events[0]), count, file_) == count &&
+    fwrite(block.xs, sizeof(block.xs[0]), count, file_) == count &&
+    fwrite(block.ys, sizeof(block.ys[0]), count, file_) == count;
+}
@@ -0,0 +1,207 @@
+#ifndef MEDIEVAL_ANALYTICS_H
+#define MEDIEVAL_ANALYTICS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Writer.h"
+
+namespace medieval {
+
+/**
+ * An analytics class. This class records where things happen to the
+ * player, to find where players die, get hurt and spend their time
+ * over many games. Each record is a handful of numbers appended to a
+ * block of columns, one column for each number, so that recording is
+ * a few stores. Full blocks are handed to a writer, which writes
+ * them to a file column by column on its own thread while the game
+ * carries on, so that a tool can read just the columns it needs
+ * straight into arrays. If every block is still waiting to be
+ * written the records are dropped rather than holding up the game.
+ * Recording doesn't allocate. Only one thread may record into an
+ * analytics, so each thread that records needs its own.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Analytics {
+public:
+
+  /**
+   * What a record is of.
+   */
+  enum class Event : std::uint8_t {
+    /** Where the player is on a tick */ POSITION,
+    /** The player touched a fireball */ DAMAGE,
+    /** The player picked up health */ HEAL,
+    /** The player picked up a coin */ SCORE,
+    /** The player lost a life */ DEATH,
+    /** The number of kinds of event */ COUNT
+  };
+
+  /**
+   * The number of records in a block.
+   */
+  static const int BLOCK = 4096;
+
+  /**
+   * The number of blocks.
+   */
+  static const int BLOCKS = Writer::BUFFERS;
+
+  /**
+   * Marks the start of a file of records, and of each block in it.
+   */
+  static const std::uint32_t FILE_MAGIC = 0x4e41444d;
+  static const std::uint32_t BLOCK_MAGIC = 0x4b4c424d;
+
+  /**
+   * The version of the file's layout.
+   */
+  static const std::uint32_t VERSION = 1;
+
+  /**
+   * The columns of a block of records. In a file each block is its
+   * magic number and count, followed by that many of each column in
+   * turn, with nothing in between.
+   */
+  struct Block {
+    /** The number of records */
+    std::uint32_t count = 0;
+    /** The tick of the level each happened on */
+    std::int32_t ticks[BLOCK];
+    /** The level */
+    std::int16_t levels[BLOCK];
+    /** The event */
+    std::uint8_t events[BLOCK];
+    /** The middle of the player */
+    std::int32_t xs[BLOCK];
+    std::int32_t ys[BLOCK];
+  };
+
+  /**
+   * Construct an analytics, writing the file's header, and start its
+   * writer.
+   * @throw domain_error if the file can't be opened
+   */
+  Analytics(/** The file to write to */
+	    const std::string& path,
+	    /** A number telling this game apart from others */
+	    std::uint64_t session);
+
+  /**
+   * The writer holds a pointer to the analytics, so it can't be
+   * copied.
+   */
+  Analytics(const Analytics&) = delete;
+  Analytics& operator=(const Analytics&) = delete;
+
+  /**
+   * Close the analytics.
+   */
+  ~Analytics();
+
+  /**
+   * Writes the records still waiting, stops the writer and closes
+   * the file.
+   */
+  void close() noexcept;
+
+  /**
+   * Records something happening.
+   */
+  void record(/** The tick of the level it happened on */
+	      int tick,
+	      /** The level */
+	      int level,
+	      /** What happened */
+	      Event event,
+	      /** Where the middle of the player was */
+	      int x, int y) noexcept {
+    if (held_ < 0 && !take()) {
+      ++dropped_;
+      return;
+    }
+    Block& block = blocks_[held_];
+    std::uint32_t i = block.count++;
+    block.ticks[i] = tick;
+    block.levels[i] = static_cast<std::int16_t>(level);
+    block.events[i] = static_cast<std::uint8_t>(event);
+    block.xs[i] = x;
+    block.ys[i] = y;
+    if (block.count == BLOCK) {
+      flush();
+    }
+  }
+
+  /**
+   * Hands the records so far to the writer, even if their block
+   * isn't full.
+   */
+  void flush() noexcept;
+
+  /**
+   * Get the number of records written.
+   * @return the number of records
+   */
+  long getWritten() const noexcept;
+
+  /**
+   * Get the number of records dropped.
+   * @return the number of records
+   */
+  long getDropped() const noexcept;
+
+  /**
+   * Get whether writing a block failed, after which nothing more is
+   * written.
+   * @return whether the analytics failed
+   */
+  bool failed() const noexcept;
+
+private:
+
+  /**
+   * The file written to
+   */
+  std::FILE* file_ = nullptr;
+
+  /**
+   * The blocks
+   */
+  std::vector<Block> blocks_;
+
+  /**
+   * The block being recorded into, or -1
+   */
+  int held_ = -1;
+
+  /**
+   * The records dropped
+   */
+  long dropped_ = 0;
+
+  /**
+   * Writes the blocks, declared last so that it stops before anything
+   * it writes from goes
+   */
+  Writer writer_;
+
+  /**
+   * Takes a free block to record into.
+   * @return whether there was one
+   */
+  bool take() noexcept;
+
+  /**
+   * Writes one block.
+   * @return whether it was all written
+   */
+  bool writeBlock(/** The block */
+		  const Block& block) noexcept;
+};
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+#include "Audio.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * The shape of a wave. 
+ */
+enum class Shape { SQUARE, TRIANGLE, NOISE };
+
+/**
+ * Adds a tone to the end of some samples, sliding from one pitch to 
+ * another and fading out. 
+ */
+static void append(vector<Sint16>& samples, int frequency, Shape shape,
+		   double from, double to, double seconds, double volume) {
+  int count = static_cast<int>(seconds * frequency);
+  double phase = 0;
+  unsigned noise = 22222;
+  for (int i = 0; i < count; ++i) {
+    double t = static_cast<double>(i) / count;
+    phase += (from + (to - from) * t) / frequency;
+    phase -= floor(phase);
+    double value = 0;
+    switch (shape) {
+    case Shape::SQUARE:
+      value = phase < 0.5 ? 1 : -1;
+      break;
+    case Shape::TRIANGLE:
+      value = 4 * fabs(phase - 0.5) - 1;
+      break;
+    case Shape::NOISE:
+      noise = noise * 1103515245 + 12345;
+      value = ((noise >> 16) & 0x7fff) / 16384.0 - 1;
+      break;
+    }
+    samples.push_back(static_cast<Sint16>(value * volume * (1 - t) * 32767));
+  }
+}
+
+/**
+ * Get the pitch of a MIDI note.
+ * @return the frequency in hertz
+ */
+static double note(int number) {
+  return 440 * pow(2, (number - 69) / 12.0);
+}
+
+Audio::~Audio() {
+  close();
+}
+
+bool Audio::open() noexcept {
+  if (device_) {
+    return true;
+  }
+
+  // Start SDL's audio if it hasn't been, such as when rendering
+  // offscreen, where SDL_AUDIODRIVER can pick the dummy or disk driver
+
+  if (!SDL_WasInit(SDL_INIT_AUDIO)) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+      return false;
+    }
+    started_ = true;
+  }
+
+  // Ask for a small buffer to keep the sound close behind the game
+
+  SDL_AudioSpec wanted = {};
+  wanted.freq = 48000;
+  wanted.format = AUDIO_S16SYS;
+  wanted.channels = 1;
+  wanted.samples = 256;
+  wanted.callback = callback;
+  wanted.userdata = this;
+  SDL_AudioSpec obtained;
+  device_ = SDL_OpenAudioDevice(nullptr, 0, &wanted, &obtained,
+				SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+  if (!device_) {
+    close();
+    return false;
+  }
+  frequency_ = obtained.freq;
+  bufferSamples_ = obtained.samples;
+
+  // The sounds are ready before the audio thread starts asking for them
+
+  synthesize();
+  SDL_PauseAudioDevice(device_, 0);
+  return true;
+}
+
+void Audio::close() noexcept {
+  // Closing the device waits for the audio thread to finish
+  if (device_) {
+    SDL_CloseAudioDevice(device_);
+    device_ = 0;
+  }
+  if (started_) {
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    started_ = false;
+  }
+}
+
+bool Audio::isOpen() const noexcept {
+  return device_ != 0;
+}
+
+void Audio::play(Sound sound) noexcept {
+  Command command = { Command::PLAY, sound };
+  send(command);
+}
+
+void Audio::playMusic(bool on) noexcept {
+  if (on != musicOn_) {
+    musicOn_ = on;
+    Command command = { on ? Command::MUSIC_ON : Command::MUSIC_OFF, Sound::COUNT };
+    send(command);
+  }
+}
+
+void Audio::mix(Sint16* samples, int count) noexcept {
+  // Start whatever the game has asked for since the last mix
+
+  Command command;
+  while (commands_.pop(command)) {
+    Voice* voice = &voices_[0];
+    switch (command.type) {
+    case Command::PLAY: {
+      // Use a free voice, or cut short the sound nearest its end
+      voice = &voices_[1];
+      for (int i = 1; i < VOICES; ++i) {
+	if (!voices_[i].samples) {
+	  voice = &voices_[i];
+	  break;
+	}
+	if (voices_[i].position > voice->position) {
+	  voice = &voices_[i];
+	}
+      }
+      const vector<Sint16>& sound = sounds_[static_cast<int>(command.sound)];
+      voice->samples = sound.data();
+      voice->length = static_cast<int>(sound.size());
+      voice->position = 0;
+      voice->loop = false;
+      break;
+    }
+    case Command::MUSIC_ON:
+      voice->samples = music_.data();
+      voice->length = static_cast<int>(music_.size());
+      voice->position = 0;
+      voice->loop = true;
+      break;
+    case Command::MUSIC_OFF:
+      voice->samples = nullptr;
+      break;
+    }
+  }
+
+  // Add up the voices a chunk at a time, and clip the total
+
+  const int CHUNK = 256;
+  int sums[CHUNK];
+  for (int done = 0; done < count; done += CHUNK) {
+    int chunk = min(count - done, CHUNK);
+    fill(sums, sums + chunk, 0);
+    for (Voice& voice : voices_) {
+      for (int i = 0; i < chunk && voice.samples; ++i) {
+	sums[i] += voice.samples[voice.position++];
+	if (voice.position == voice.length) {
+	  if (voice.loop) {
+	    voice.position = 0;
+	  } else {
+	    voice.samples = nullptr;
+	  }
+	}
+      }
+    }
+    for (int i = 0; i < chunk; ++i) {
+      samples[done + i] = static_cast<Sint16>(max(-32768, min(32767, sums[i])));
+    }
+  }
+  mixed_.fetch_add(count, memory_order_relaxed);
+}
+
+int Audio::getFrequency() const noexcept {
+  return frequency_;
+}
+
+double Audio::getLatency() const noexcept {
+  return 1000.0 * bufferSamples_ / frequency_;
+}
+
+long Audio::getMixed() const noexcept {
+  return mixed_.load(memory_order_relaxed);
+}
+
+long Audio::getDropped() const noexcept {
+  return dropped_;
+}
+
+void Audio::callback(void* audio, Uint8* stream, int length) {
+  static_cast<Audio*>(audio)->mix(reinterpret_cast<Sint16*>(stream),
+				  length / static_cast<int>(sizeof(Sint16)));
+}
+
+void Audio::synthesize() {
+  for (vector<Sint16>& sound : sounds_) {
+    sound.clear();
+  }
+  music_.clear();
+
+  // A quick rising blip for a jump
+  append(sounds_[static_cast<int>(Sound::JUMP)], frequency_, Shape::SQUARE, 320, 640, 0.12, 0.25);
+
+  // A crunch of noise for damage
+  append(sounds_[static_cast<int>(Sound::DAMAGE)], frequency_, Shape::NOISE, 0, 0, 0.25, 0.35);
+
+  // Two high notes for a coin
+  vector<Sint16>& coin = sounds_[static_cast<int>(Sound::COIN)];
+  append(coin, frequency_, Shape::SQUARE, note(83), note(83), 0.06, 0.2);
+  append(coin, frequency_, Shape::SQUARE, note(88), note(88), 0.25, 0.2);
+
+  // A soft arpeggio for health
+  for (int number : { 72, 76, 79, 84 }) {
+    append(sounds_[static_cast<int>(Sound::HEALTH)], frequency_, Shape::TRIANGLE,
+	   note(number), note(number), 0.07, 0.35);
+  }
+
+  // A fanfare for the end of a level
+  vector<Sint16>& level = sounds_[static_cast<int>(Sound::LEVEL)];
+  for (int number : { 72, 76, 79 }) {
+    append(level, frequency_, Shape::SQUARE, note(number), note(number), 0.12, 0.2);
+  }
+  append(level, frequency_, Shape::SQUARE, note(84), note(84), 0.4, 0.2);
+
+  // A quiet plucked tune that loops
+  for (int number : { 57, 60, 64, 69, 67, 64, 60, 64, 53, 57, 60, 65, 64, 60, 55, 59 }) {
+    append(music_, frequency_, Shape::TRIANGLE, note(number), note(number), 0.25, 0.15);
+  }
+}
+
+void Audio::send(Command command) noexcept {
+  if (device_ && !commands_.push(command)) {
+    ++dropped_;
+  }
+}
@@ -0,0 +1,209 @@
+#ifndef MEDIEVAL_AUDIO_H
+#define MEDIEVAL_AUDIO_H
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "Ring.h"
+#include "Sound.h"
+
+namespace medieval {
+
+/**
+ * An audio class. This class plays the game's sound effects and 
+ * music. The sounds are made once, when the audio is opened, and 
+ * the game asks for them to be played through a ring that SDL's 
+ * audio thread reads from, so that the audio thread never waits 
+ * on the game and never allocates. If there is no audio device 
+ * the game carries on silently. 
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Audio {
+public:
+
+  /**
+   * The most sounds that can play at once, including the music. 
+   */
+  static const int VOICES = 16;
+
+  /**
+   * Construct audio that is not open yet. 
+   */
+  Audio() = default;
+
+  /**
+   * The audio thread holds a pointer to the audio, so it can't be
+   * copied. 
+   */
+  Audio(const Audio&) = delete;
+  Audio& operator=(const Audio&) = delete;
+
+  /**
+   * Close the audio. 
+   */
+  ~Audio();
+
+  /**
+   * Opens the audio device, using whichever driver SDL picks, and 
+   * makes the sounds. SDL must already be initialized. 
+   * @return whether there is audio
+   */
+  bool open() noexcept;
+
+  /**
+   * Closes the audio device. 
+   */
+  void close() noexcept;
+
+  /**
+   * Get whether the audio device is open.
+   * @return whether there is audio
+   */
+  bool isOpen() const noexcept;
+
+  /**
+   * Starts playing a sound. 
+   */
+  void play(/** The sound */
+	    Sound sound) noexcept;
+
+  /**
+   * Starts the music from the beginning or stops it, if it isn't
+   * already. 
+   */
+  void playMusic(/** Whether the music should be playing */
+		 bool on) noexcept;
+
+  /**
+   * Mixes the next samples of everything that is playing, taking 
+   * any new sounds from the game first. This is what the audio 
+   * thread calls, and can be called directly to check the mix 
+   * without a device. 
+   */
+  void mix(/** Where to put the mono samples */
+	   Sint16* samples,
+	   /** The number of samples */
+	   int count) noexcept;
+
+  /**
+   * Get the number of samples played per second.
+   * @return the sample rate
+   */
+  int getFrequency() const noexcept;
+
+  /**
+   * Get how far behind the game the sound is, from the size of the
+   * device's buffer.
+   * @return the latency in milliseconds
+   */
+  double getLatency() const noexcept;
+
+  /**
+   * Get the number of samples mixed so far.
+   * @return the number of samples
+   */
+  long getMixed() const noexcept;
+
+  /**
+   * Get the number of sounds that weren't played because the ring 
+   * was full.
+   * @return the number of sounds dropped
+   */
+  long getDropped() const noexcept;
+
+private:
+
+  /**
+   * A request from the game to the audio thread
+   */
+  struct Command {
+    /** What to do */
+    enum Type : std::uint8_t { PLAY, MUSIC_ON, MUSIC_OFF } type;
+    /** The sound to play */
+    Sound sound;
+  };
+
+  /**
+   * A sound being played
+   */
+  struct Voice {
+    /** The samples, or nullptr if nothing is playing */
+    const Sint16* samples = nullptr;
+    /** The number of samples */
+    int length = 0;
+    /** The next sample to play */
+    int position = 0;
+    /** Whether to start again at the end */
+    bool loop = false;
+  };
+
+  /**
+   * The device, or 0 if there is none
+   */
+  SDL_AudioDeviceID device_ = 0;
+
+  /**
+   * Whether opening started SDL's audio, so closing should stop it
+   */
+  bool started_ = false;
+
+  /**
+   * The sample rate, and the size of the device's buffer in samples
+   */
+  int frequency_ = 48000;
+  int bufferSamples_ = 0;
+
+  /**
+   * Every sound effect, and the music, made when the audio opens
+   */
+  std::vector<Sint16> sounds_[static_cast<int>(Sound::COUNT)];
+  std::vector<Sint16> music_;
+
+  /**
+   * Requests from the game waiting for the audio thread
+   */
+  Ring<Command, 64> commands_;
+
+  /**
+   * What the audio thread is playing. The music always plays in 
+   * the first voice
+   */
+  Voice voices_[VOICES];
+
+  /**
+   * Whether the game last asked for the music to play
+   */
+  bool musicOn_ = false;
+
+  /**
+   * The number of commands the ring had no room for
+   */
+  long dropped_ = 0;
+
+  /**
+   * The number of samples mixed, which the game reads
+   */
+  std::atomic<long> mixed_{0};
+
+  /**
+   * Passes SDL's request for samples on to mix. 
+   */
+  static void SDLCALL callback(void* audio, Uint8* stream, int length);
+
+  /**
+   * Makes the sound effects and the music at the device's rate. 
+   */
+  void synthesize();
+
+  /**
+   * Sends a command to the audio thread, if there is room. 
+   */
+  void send(Command command) noexcept;
+};
+
+}
+
+#endif
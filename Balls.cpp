@@ -18,19 +18,7 @@ void Balls::move() noexcept {
   // will move the ball if the image indicates
   // that it is a moving fireball
   if(imageIndex_ == 6) {
-    if(left_) {
-      x_ -= 5;
-    } else {
-      x_ += 5;
-    }
-
-    // changes direction once the ball reaches the end
-    // of its path
-    if(x_ >= end_) {
-      left_ = true;
-    } else if (x_ <= start_) {
-      left_ = false;
-    }
+    step();
     angle_ -= 20;
   } else {
 
@@ -38,4 +26,102 @@ void Balls::move() noexcept {
     // if the image is not that of a moving fireball
     angle_ += 30;
   }
+
+  // keeps the angle within a turn, as skip does, so a ball that
+  // slept is in the same state as one that didn't
+  if(angle_ < 0 || angle_ >= 360) {
+    angle_ = (angle_ % 360 + 360) % 360;
+  }
+}
+
+void Balls::skip(int ticks) noexcept {
+  Patrol patrol = getPatrol();
+  patrol.at(ticks, x_, left_);
+
+  // only the angle within a turn matters, so however many ticks are
+  // skipped it never turns past one
+  long long turned = angle_ + static_cast<long long>(patrol.spin) * (ticks % 360);
+  angle_ = static_cast<int>((turned % 360 + 360) % 360);
+}
+
+int Balls::getStart() const noexcept {
+  return start_;
+}
+
+int Balls::getEnd() const noexcept {
+  return end_;
+}
+
+Balls::Patrol Balls::getPatrol() const noexcept {
+  Patrol patrol;
+  patrol.x = x_;
+  patrol.left = left_;
+  patrol.angle = angle_;
+  patrol.early = 0;
+  if(imageIndex_ != 6) {
+    patrol.turn = x_;
+    patrol.period = 1;
+    patrol.phase = 0;
+    patrol.spin = 30;
+    return patrol;
+  }
+  patrol.spin = -20;
+
+  // the ball only ever moves 5 at a time, so it turns back at the
+  // first place it can be at on or past the end, and on the way back
+  // at the first on or before the start, which is a step further
+  // back if the path is too short to have two places
+  int end = end_ + ((x_ - end_) % 5 + 5) % 5;
+  patrol.turn = start_ - ((start_ - x_) % 5 + 5) % 5;
+  if(patrol.turn >= end) {
+    patrol.turn -= 5;
+  }
+  int half = (end - patrol.turn) / 5;
+  patrol.period = 2 * half;
+
+  // a ball on or past a turning point but going the wrong way, as
+  // one starting at an end of its path is, takes a step past it and
+  // comes back
+  if(left_ && x_ > end) {
+    patrol.early = 1;
+    patrol.phase = half - 1;
+  } else if(!left_ && x_ < patrol.turn) {
+    patrol.early = 1;
+    patrol.phase = patrol.period - 1;
+  } else if(!left_ && x_ == end) {
+    patrol.early = 2;
+    patrol.phase = (half - 2 + patrol.period) % patrol.period;
+  } else if(left_ && x_ == patrol.turn) {
+    patrol.early = 2;
+    patrol.phase = patrol.period - 2;
+  } else {
+    patrol.phase = left_ ? half + (end - x_) / 5 : (x_ - patrol.turn) / 5;
+  }
+  return patrol;
+}
+
+void Balls::save(SpriteState& state) const noexcept {
+  Sprite::save(state);
+  state.left = left_;
+}
+
+void Balls::restore(const SpriteState& state) noexcept {
+  Sprite::restore(state);
+  left_ = state.left;
+}
+
+void Balls::step() noexcept {
+  if(left_) {
+    x_ -= 5;
+  } else {
+    x_ += 5;
+  }
+
+  // changes direction once the ball reaches the end
+  // of its path
+  if(x_ >= end_) {
+    left_ = true;
+  } else if (x_ <= start_) {
+    left_ = false;
+  }
 }
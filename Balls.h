@@ -18,6 +18,51 @@ class Balls : public Sprite {
   
 public:
 
+  /**
+   * A patrol: where a ball is at any tick, worked out from a few
+   * numbers rather than by moving it there. A moving ball goes back
+   * and forth between the same two turning points forever, so after
+   * at most two ticks its position is a triangle wave of the tick.
+   */
+  struct Patrol {
+    /** Where the ball turns back by the start of its path */
+    int turn;
+    /** The number of ticks to go round the path once, which is 1
+	for a ball that doesn't move */
+    int period;
+    /** Where round the path the ball is at tick 0, counted from the
+	turn by the start, as if it were already going round */
+    int phase;
+    /** The number of ticks before the ball is going round, and
+	where it is and which way it is going on tick 0 */
+    int early;
+    int x;
+    bool left;
+    /** Its angle on tick 0 and how far it turns each tick */
+    int angle;
+    int spin;
+
+    /**
+     * Get where the ball is at a tick.
+     */
+    void at(/** The tick, from 0 */
+	    int tick,
+	    /** Set to the x coordinate and which way it is going */
+	    int& x, bool& left) const noexcept {
+      if (tick < early) {
+	// before going round it only ever takes one more step the way
+	// it was going, and the step after it turns back
+	x = this->x + (this->left ? -5 : 5) * tick;
+	left = tick == 0 ? this->left : !this->left;
+	return;
+      }
+      int half = period / 2;
+      int round = static_cast<int>((static_cast<long long>(phase) + tick) % period);
+      x = turn + 5 * (round <= half ? round : period - round);
+      left = half > 0 ? round >= half : this->left;
+    }
+  };
+
   /**
    * Construct a Ball.
    * @throw domain_error if the arguments are not valid.
@@ -35,9 +80,49 @@ public:
    * Moves the ball given the start and end coordinates
    * instantiated in the constructor. This will be done
    * differently depending on the given image index, 
-   * which will also determine the ball's rotation. 
+   * which will also determine the ball's rotation, kept 
+   * from 0 to 359. 
    */
   void move() noexcept override;
+
+  /**
+   * Moves the ball as far as that many calls to move would, which
+   * takes the same time however many ticks are skipped. Its angle 
+   * comes out from 0 to 359, at the same point in a turn as after 
+   * that many calls to move.
+   */
+  void skip(/** The number of ticks to skip */
+	    int ticks) noexcept;
+
+  /**
+   * Get the x coordinate of the start of the ball's path.
+   * @return the x coordinate
+   */
+  int getStart() const noexcept;
+
+  /**
+   * Get the x coordinate of the end of the ball's path.
+   * @return the x coordinate
+   */
+  int getEnd() const noexcept;
+
+  /**
+   * Get the ball's patrol from where it is now.
+   * @return the patrol, whose tick 0 is now
+   */
+  Patrol getPatrol() const noexcept;
+
+  /**
+   * Saves the state of the ball, including its direction. 
+   */
+  void save(/** Where to save the state */
+	    SpriteState& state) const noexcept override;
+
+  /**
+   * Restores a previously saved state of the ball. 
+   */
+  void restore(/** The state to restore */
+	       const SpriteState& state) noexcept override;
     
 private:
   
@@ -55,6 +140,11 @@ private:
    * A bool to indicate if the ball is moving left (or right)
    */
   bool left_;
+
+  /**
+   * Moves the ball one step along its path.
+   */
+  void step() noexcept;
 };
 }
 
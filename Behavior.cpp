@@ -0,0 +1,156 @@
+#include "Behavior.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * The sine of every whole degree, in 1024ths, running on past a
+ * whole turn so that a cosine can be read from 90 degrees further on.
+ */
+static int SINES[450];
+
+/**
+ * Fills in the sines before anything can run a behavior.
+ */
+static const bool FILLED = []() {
+  for (int degrees = 0; degrees < 450; ++degrees) {
+    SINES[degrees] = static_cast<int>(lround(sin(degrees * M_PI / 180) * 1024));
+  }
+  return true;
+}();
+
+Behavior::Behavior(int spin) noexcept : spin_(spin) {}
+
+Behavior& Behavior::wait(int ticks) {
+  return add(Step{Op::WAIT, 0, 0, ticks});
+}
+
+Behavior& Behavior::dash(int x, int y, int ticks) {
+  return add(Step{Op::DASH, x, y, ticks});
+}
+
+Behavior& Behavior::orbit(int radius, int degrees, int ticks) {
+  if (radius < 1 || degrees <= -360 || degrees >= 360) {
+    throw domain_error("An orbit needs a radius and less than a turn a tick");
+  }
+  return add(Step{Op::ORBIT, radius, degrees, ticks});
+}
+
+Behavior& Behavior::drop(int ticks) {
+  return add(Step{Op::DROP, 0, 0, ticks});
+}
+
+Behavior& Behavior::home(int ticks) {
+  return add(Step{Op::HOME, 0, 0, ticks});
+}
+
+int Behavior::size() const noexcept {
+  return static_cast<int>(steps_.size());
+}
+
+const Behavior::Step& Behavior::getStep(int step) const noexcept {
+  return steps_[step];
+}
+
+int Behavior::getSpin() const noexcept {
+  return spin_;
+}
+
+int Behavior::getTicks() const noexcept {
+  int ticks = 0;
+  for (const Step& step : steps_) {
+    ticks += step.ticks;
+  }
+  return ticks;
+}
+
+int Behavior::getMoves() const noexcept {
+  int moves = 0;
+  for (const Step& step : steps_) {
+    if (step.op != Op::WAIT) {
+      moves += step.ticks;
+    }
+  }
+  return moves;
+}
+
+int Behavior::getReach() const noexcept {
+  // adds up the furthest each step can go, while following where the
+  // hazard ends up since it last went home
+  int reach = 0;
+  int x = 0;
+  int y = 0;
+  bool lost = false;
+  for (const Step& step : steps_) {
+    switch (step.op) {
+    case Op::WAIT:
+      break;
+    case Op::DASH:
+      reach += max(abs(step.x), abs(step.y)) * step.ticks;
+      x += step.x * step.ticks;
+      y += step.y * step.ticks;
+      break;
+    case Op::ORBIT:
+      // only whole turns come back round to the same point
+      reach += 2 * step.x;
+      lost = lost || step.y * step.ticks % 360 != 0;
+      break;
+    case Op::DROP:
+      reach += step.ticks * (step.ticks + 1) / 2;
+      y += step.ticks * (step.ticks + 1) / 2;
+      break;
+    case Op::HOME:
+      x = 0;
+      y = 0;
+      lost = false;
+      break;
+    }
+  }
+  return x == 0 && y == 0 && !lost ? reach : -1;
+}
+
+/**
+ * Get a whole number of degrees as the same angle within one turn.
+ * @return the degrees, from 0 to 359
+ */
+static int turn(/** The angle in degrees */ int degrees) {
+  // most angles are already within a turn, so skip the division
+  return degrees >= 0 && degrees < 360 ? degrees : (degrees % 360 + 360) % 360;
+}
+
+int Behavior::sine(int degrees) noexcept {
+  return SINES[turn(degrees)];
+}
+
+int Behavior::cosine(int degrees) noexcept {
+  return SINES[turn(degrees) + 90];
+}
+
+const Behavior& Behavior::dasher() {
+  static const Behavior behavior = Behavior(-20).wait(30).dash(5, 0, 20).wait(30).dash(-5, 0, 20);
+  return behavior;
+}
+
+const Behavior& Behavior::dropper() {
+  // falls 171 pixels in 18 ticks
+  static const Behavior behavior = Behavior(-20).wait(60).drop(18).wait(20).home(40);
+  return behavior;
+}
+
+const Behavior& Behavior::orbiter() {
+  static const Behavior behavior = Behavior(-20).orbit(60, 6, 60);
+  return behavior;
+}
+
+Behavior& Behavior::add(const Step& step) {
+  if (step.ticks < 1) {
+    throw domain_error("A step must last at least a tick");
+  }
+  steps_.push_back(step);
+  return *this;
+}
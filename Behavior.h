@@ -0,0 +1,201 @@
+#ifndef MEDIEVAL_BEHAVIOR_H
+#define MEDIEVAL_BEHAVIOR_H
+
+#include <vector>
+
+namespace medieval {
+
+/**
+ * A behavior class. This class is the script a hazard follows: a
+ * list of steps, each lasting a number of ticks, that repeats from
+ * the start once the last one is done. A hazard running a behavior
+ * is resumed where it left off each tick, so a pattern like waiting,
+ * dashing and coming back is written as the steps in order rather
+ * than as a state machine in a sprite's move function. Behaviors
+ * don't change once built and are shared by every hazard that
+ * follows them.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Behavior {
+public:
+
+  /**
+   * The kinds of step.
+   */
+  enum class Op {
+    /** Stay still, without being resumed until the wait is over. */ WAIT,
+    /** Move by x and y every tick. */ DASH,
+    /** Circle with a radius of x, turning y degrees every tick. */ ORBIT,
+    /** Fall, speeding up by a pixel a tick every tick. */ DROP,
+    /** Glide back to where the hazard started. */ HOME
+  };
+
+  /**
+   * One step of a behavior.
+   */
+  struct Step {
+    /** What the step does */
+    Op op;
+    /** The numbers the step works with, as described by its kind */
+    int x;
+    int y;
+    /** How many ticks the step lasts */
+    int ticks;
+  };
+
+  /**
+   * Construct a behavior with no steps.
+   */
+  explicit Behavior(/** The degrees to turn the hazard's image every
+			tick it moves */
+		    int spin = 0) noexcept;
+
+  /**
+   * Adds a step that waits.
+   * @return this behavior
+   * @throw domain_error if ticks is less than 1.
+   */
+  Behavior& wait(/** The number of ticks to wait */
+		 int ticks);
+
+  /**
+   * Adds a step that moves in a straight line.
+   * @return this behavior
+   * @throw domain_error if ticks is less than 1.
+   */
+  Behavior& dash(/** The pixels to move every tick */
+		 int x, int y,
+		 /** The number of ticks to move for */
+		 int ticks);
+
+  /**
+   * Adds a step that moves in a circle, which the hazard starts on
+   * rather than at the centre of.
+   * @return this behavior
+   * @throw domain_error if ticks or radius is less than 1, or
+   * degrees is a whole turn or more.
+   */
+  Behavior& orbit(/** The radius of the circle */
+		  int radius,
+		  /** The degrees to go round every tick, clockwise if
+		      positive */
+		  int degrees,
+		  /** The number of ticks to circle for */
+		  int ticks);
+
+  /**
+   * Adds a step that falls from rest.
+   * @return this behavior
+   * @throw domain_error if ticks is less than 1.
+   */
+  Behavior& drop(/** The number of ticks to fall for */
+		 int ticks);
+
+  /**
+   * Adds a step that goes back to where the hazard started.
+   * @return this behavior
+   * @throw domain_error if ticks is less than 1.
+   */
+  Behavior& home(/** The number of ticks to take */
+		 int ticks);
+
+  /**
+   * Get the number of steps.
+   * @return the number of steps
+   */
+  int size() const noexcept;
+
+  /**
+   * Get a step.
+   * @return the step
+   */
+  const Step& getStep(/** The index of the step */
+		      int step) const noexcept;
+
+  /**
+   * Get how far the hazard's image turns every tick it moves.
+   * @return the degrees to turn
+   */
+  int getSpin() const noexcept;
+
+  /**
+   * Get how many ticks it takes to go through every step once.
+   * @return the number of ticks
+   */
+  int getTicks() const noexcept;
+
+  /**
+   * Get how many of those ticks the hazard moves on, and so turns.
+   * @return the number of ticks
+   */
+  int getMoves() const noexcept;
+
+  /**
+   * Get how far a hazard following the behavior can ever get from
+   * where it started, across or down. 
+   * @return the furthest in pixels, or -1 if the behavior doesn't
+   * bring the hazard back to where it started each time through, so
+   * there's no telling
+   */
+  int getReach() const noexcept;
+
+  /**
+   * Get the sine of a whole number of degrees, in 1024ths.
+   * @return the sine
+   */
+  static int sine(/** The angle in degrees */
+		  int degrees) noexcept;
+
+  /**
+   * Get the cosine of a whole number of degrees, in 1024ths.
+   * @return the cosine
+   */
+  static int cosine(/** The angle in degrees */
+		    int degrees) noexcept;
+
+  /**
+   * Get a behavior that waits, dashes right along a platform, waits
+   * and dashes back.
+   * @return the behavior
+   */
+  static const Behavior& dasher();
+
+  /**
+   * Get a behavior that hangs high up, drops to head height and
+   * floats back up again.
+   * @return the behavior
+   */
+  static const Behavior& dropper();
+
+  /**
+   * Get a behavior that circles forever.
+   * @return the behavior
+   */
+  static const Behavior& orbiter();
+
+private:
+
+  /**
+   * The steps in order
+   */
+  std::vector<Step> steps_;
+
+  /**
+   * The degrees to turn every tick the hazard moves
+   */
+  int spin_;
+
+  /**
+   * Adds a step.
+   * @return this behavior
+   * @throw domain_error if ticks is less than 1.
+   */
+  Behavior& add(/** The step */
+		const Step& step);
+};
+
+}
+
+#endif
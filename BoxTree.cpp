@@ -0,0 +1,231 @@
+#include "BoxTree.h"
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * Get the box around two boxes.
+ * @return the box
+ */
+static BoxTree::Box combine(const BoxTree::Box& a, const BoxTree::Box& b) {
+  return BoxTree::Box{min(a.left, b.left), min(a.top, b.top),
+      max(a.right, b.right), max(a.bottom, b.bottom)};
+}
+
+/**
+ * Get the perimeter of a box, which is what putting a leaf somewhere
+ * costs.
+ * @return the perimeter
+ */
+static long perimeter(const BoxTree::Box& box) {
+  return 2L * (box.right - box.left) + 2L * (box.bottom - box.top);
+}
+
+void BoxTree::reserve(int count) {
+  // every leaf but the first brings a node with two children
+  nodes_.reserve(max(0, 2 * count - 1));
+}
+
+int BoxTree::insert(const Box& box, int id, int margin) {
+  int leaf = allocate();
+  Node& node = nodes_[leaf];
+  node.box = Box{box.left - margin, box.top - margin, box.right + margin, box.bottom + margin};
+  node.child1 = -1;
+  node.child2 = -1;
+  node.height = 0;
+  node.id = id;
+  insertLeaf(leaf);
+  ++count_;
+  return leaf;
+}
+
+void BoxTree::remove(int proxy) noexcept {
+  removeLeaf(proxy);
+  release(proxy);
+  --count_;
+}
+
+bool BoxTree::move(int proxy, const Box& box, int margin) noexcept {
+  const Box& fat = nodes_[proxy].box;
+  if (fat.left <= box.left && fat.top <= box.top && fat.right >= box.right &&
+      fat.bottom >= box.bottom) {
+    return false;
+  }
+
+  // taking the leaf out frees a node, which putting it back takes
+  // again, so this never allocates
+  removeLeaf(proxy);
+  nodes_[proxy].box = Box{box.left - margin, box.top - margin, box.right + margin,
+			  box.bottom + margin};
+  insertLeaf(proxy);
+  return true;
+}
+
+int BoxTree::size() const noexcept {
+  return count_;
+}
+
+int BoxTree::getHeight() const noexcept {
+  return root_ < 0 ? -1 : nodes_[root_].height;
+}
+
+int BoxTree::allocate() {
+  if (free_ < 0) {
+    Node node = {};
+    node.height = -1;
+    node.parent = -1;
+    nodes_.push_back(node);
+    free_ = static_cast<int>(nodes_.size()) - 1;
+  }
+  int node = free_;
+  free_ = nodes_[node].parent;
+  nodes_[node].parent = -1;
+  nodes_[node].height = 0;
+  return node;
+}
+
+void BoxTree::release(int node) noexcept {
+  nodes_[node].parent = free_;
+  nodes_[node].height = -1;
+  free_ = node;
+}
+
+void BoxTree::insertLeaf(int leaf) {
+  if (root_ < 0) {
+    root_ = leaf;
+    nodes_[leaf].parent = -1;
+    return;
+  }
+
+  // walks down towards the sibling that would grow the boxes least,
+  // stopping where making a new parent here is cheaper than going on
+  Box box = nodes_[leaf].box;
+  int index = root_;
+  while (nodes_[index].child1 >= 0) {
+    const Node& node = nodes_[index];
+    long combined = perimeter(combine(node.box, box));
+    long cost = 2 * combined;
+    long inheritance = 2 * (combined - perimeter(node.box));
+    long costs[2];
+    int children[2] = {node.child1, node.child2};
+    for (int i = 0; i < 2; ++i) {
+      const Node& child = nodes_[children[i]];
+      costs[i] = perimeter(combine(box, child.box)) + inheritance;
+      if (child.child1 >= 0) {
+	costs[i] -= perimeter(child.box);
+      }
+    }
+    if (cost < costs[0] && cost < costs[1]) {
+      break;
+    }
+    index = costs[0] < costs[1] ? children[0] : children[1];
+  }
+
+  // gives the sibling and the leaf a new parent
+  int sibling = index;
+  int oldParent = nodes_[sibling].parent;
+  int parent = allocate();
+  Node& node = nodes_[parent];
+  node.parent = oldParent;
+  node.box = combine(box, nodes_[sibling].box);
+  node.height = nodes_[sibling].height + 1;
+  node.child1 = sibling;
+  node.child2 = leaf;
+  node.id = -1;
+  if (oldParent < 0) {
+    root_ = parent;
+  } else if (nodes_[oldParent].child1 == sibling) {
+    nodes_[oldParent].child1 = parent;
+  } else {
+    nodes_[oldParent].child2 = parent;
+  }
+  nodes_[sibling].parent = parent;
+  nodes_[leaf].parent = parent;
+  refit(parent);
+}
+
+void BoxTree::removeLeaf(int leaf) noexcept {
+  if (leaf == root_) {
+    root_ = -1;
+    return;
+  }
+
+  // the leaf's sibling takes its parent's place
+  int parent = nodes_[leaf].parent;
+  int grandParent = nodes_[parent].parent;
+  int sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+  nodes_[sibling].parent = grandParent;
+  release(parent);
+  if (grandParent < 0) {
+    root_ = sibling;
+    return;
+  }
+  if (nodes_[grandParent].child1 == parent) {
+    nodes_[grandParent].child1 = sibling;
+  } else {
+    nodes_[grandParent].child2 = sibling;
+  }
+  refit(grandParent);
+}
+
+void BoxTree::refit(int node) noexcept {
+  while (node >= 0) {
+    node = balance(node);
+    Node& n = nodes_[node];
+    const Node& child1 = nodes_[n.child1];
+    const Node& child2 = nodes_[n.child2];
+    n.height = 1 + max(child1.height, child2.height);
+    n.box = combine(child1.box, child2.box);
+    node = n.parent;
+  }
+}
+
+int BoxTree::balance(int a) noexcept {
+  Node& A = nodes_[a];
+  if (A.child1 < 0 || A.height < 2) {
+    return a;
+  }
+  int b = A.child1;
+  int c = A.child2;
+  Node& B = nodes_[b];
+  Node& C = nodes_[c];
+  int difference = C.height - B.height;
+  if (difference >= -1 && difference <= 1) {
+    return a;
+  }
+
+  // the taller child goes up in the node's place, and the node takes
+  // the shorter of that child's children
+  int up = difference > 1 ? c : b;
+  int stays = difference > 1 ? b : c;
+  Node& U = nodes_[up];
+  Node& S = nodes_[stays];
+  int f = U.child1;
+  int g = U.child2;
+  Node& F = nodes_[f];
+  Node& G = nodes_[g];
+  U.child1 = a;
+  U.parent = A.parent;
+  A.parent = up;
+  if (U.parent < 0) {
+    root_ = up;
+  } else if (nodes_[U.parent].child1 == a) {
+    nodes_[U.parent].child1 = up;
+  } else {
+    nodes_[U.parent].child2 = up;
+  }
+  int taller = F.height > G.height ? f : g;
+  int shorter = F.height > G.height ? g : f;
+  U.child2 = taller;
+  if (up == c) {
+    A.child2 = shorter;
+  } else {
+    A.child1 = shorter;
+  }
+  nodes_[shorter].parent = a;
+  A.box = combine(S.box, nodes_[shorter].box);
+  A.height = 1 + max(S.height, nodes_[shorter].height);
+  U.box = combine(A.box, nodes_[taller].box);
+  U.height = 1 + max(A.height, nodes_[taller].height);
+  return up;
+}
@@ -0,0 +1,287 @@
+#ifndef MEDIEVAL_BOXTREE_H
+#define MEDIEVAL_BOXTREE_H
+
+#include <algorithm>
+#include <vector>
+
+namespace medieval {
+
+/**
+ * A box tree class. This class is a dynamic bounding box tree of
+ * things that move: each is kept in the tree by a box a margin
+ * bigger than it, so that it is only put back in somewhere else once
+ * it moves out of that box, and the tree is rebalanced as things go
+ * in and out so that finding what is near a box or along a line
+ * stays quick however things move. The tree only answers which
+ * boxes might be hit, and the caller looks at what is really in
+ * them. Moving something doesn't allocate once the tree has been
+ * reserved for everything in it.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class BoxTree {
+public:
+
+  /**
+   * A box, which takes in the left and top but not the right and
+   * bottom.
+   */
+  struct Box {
+    int left;
+    int top;
+    int right;
+    int bottom;
+  };
+
+  /**
+   * Makes room for a number of things, so that adding them and
+   * moving them doesn't allocate.
+   */
+  void reserve(/** The number of things */
+	       int count);
+
+  /**
+   * Adds something to the tree.
+   * @return the proxy to move or remove it by
+   */
+  int insert(/** Where it is */
+	     const Box& box,
+	     /** The number to find it by */
+	     int id,
+	     /** How far it can move before it is put back in the tree */
+	     int margin);
+
+  /**
+   * Removes something from the tree.
+   */
+  void remove(/** Its proxy */
+	      int proxy) noexcept;
+
+  /**
+   * Moves something, putting it back in the tree if it has left its
+   * box.
+   * @return whether it was put back in
+   */
+  bool move(/** Its proxy */
+	    int proxy,
+	    /** Where it is now */
+	    const Box& box,
+	    /** How far it can move before it is put back again */
+	    int margin) noexcept;
+
+  /**
+   * Get the number of things in the tree.
+   * @return the number of things
+   */
+  int size() const noexcept;
+
+  /**
+   * Get the height of the tree, which stays close to the logarithm
+   * of its size.
+   * @return the height, or -1 if it is empty
+   */
+  int getHeight() const noexcept;
+
+  /**
+   * Finds everything whose box overlaps a box.
+   */
+  template <typename Found>
+  void query(/** The box */
+	     const Box& box,
+	     /** Called with the id of each thing found, and returns
+		 whether to keep looking */
+	     Found found) const noexcept {
+    int stack[STACK];
+    int size = 0;
+    if (root_ >= 0) {
+      stack[size++] = root_;
+    }
+    while (size > 0) {
+      const Node& node = nodes_[stack[--size]];
+      if (!overlaps(node.box, box)) {
+	continue;
+      }
+      if (node.child1 < 0) {
+	if (!found(node.id)) {
+	  return;
+	}
+      } else if (size + 2 <= STACK) {
+	stack[size++] = node.child1;
+	stack[size++] = node.child2;
+      }
+    }
+  }
+
+  /**
+   * Finds everything whose box a box moving along a line would
+   * overlap.
+   */
+  template <typename Found>
+  void sweep(/** Where the top left of the moving box starts */
+	     double x, double y,
+	     /** How far it moves across and down */
+	     double dx, double dy,
+	     /** The size of the moving box, which is 0 for a ray */
+	     int width, int height,
+	     /** The fraction of the line to look along */
+	     double limit,
+	     /** Called with the id of each thing found and the fraction
+		 of the line it has been looked along so far, and
+		 returns the fraction to keep looking along */
+	     Found found) const noexcept {
+    int stack[STACK];
+    int size = 0;
+    if (root_ >= 0) {
+      stack[size++] = root_;
+    }
+    while (size > 0) {
+      const Node& node = nodes_[stack[--size]];
+      double enter;
+      if (!crosses(node.box, x, y, dx, dy, width, height, limit, enter)) {
+	continue;
+      }
+      if (node.child1 < 0) {
+	limit = found(node.id, limit);
+      } else if (size + 2 <= STACK) {
+	stack[size++] = node.child1;
+	stack[size++] = node.child2;
+      }
+    }
+  }
+
+  /**
+   * Get when a box moving along a line first overlaps another box.
+   * @return whether it does before the limit
+   */
+  static bool crosses(/** The box */
+		      const Box& box,
+		      /** Where the top left of the moving box starts */
+		      double x, double y,
+		      /** How far it moves across and down */
+		      double dx, double dy,
+		      /** The size of the moving box */
+		      int width, int height,
+		      /** The fraction of the line to look along */
+		      double limit,
+		      /** Set to the fraction it first overlaps at */
+		      double& enter) noexcept {
+    // the top left of the moving box overlaps when it is inside the
+    // box grown by the moving box's size
+    double exit = limit;
+    enter = 0;
+    return slab(x, dx, box.left - width, box.right, enter, exit) &&
+      slab(y, dy, box.top - height, box.bottom, enter, exit);
+  }
+
+private:
+
+  /**
+   * The deepest the tree is looked through
+   */
+  static const int STACK = 256;
+
+  /**
+   * A node of the tree, which is a leaf holding one thing or has
+   * two children and a box around both
+   */
+  struct Node {
+    /** The box, which for a leaf is bigger than the thing by the
+	margin */
+    Box box;
+    /** The parent, or the next node free if this one is */
+    int parent;
+    /** The children, or -1 for a leaf */
+    int child1;
+    int child2;
+    /** The height above the leaves, or -1 if the node is free */
+    int height;
+    /** The number of the thing for a leaf */
+    int id;
+  };
+
+  /**
+   * The nodes, including those free
+   */
+  std::vector<Node> nodes_;
+
+  /**
+   * The root node and the first node free, or -1
+   */
+  int root_ = -1;
+  int free_ = -1;
+
+  /**
+   * The number of things
+   */
+  int count_ = 0;
+
+  /**
+   * Narrows the fractions of a line inside a box to those inside
+   * the box across or down.
+   * @return whether any are left
+   */
+  static bool slab(/** Where the line starts */ double start,
+		   /** How far it goes */ double length,
+		   /** The ends of the box, which aren't inside it */ double low, double high,
+		   /** The fractions inside */ double& enter, double& exit) noexcept {
+    if (length == 0) {
+      return low < start && start < high;
+    }
+    double first = (low - start) / length;
+    double second = (high - start) / length;
+    if (first > second) {
+      std::swap(first, second);
+    }
+    enter = std::max(enter, first);
+    exit = std::min(exit, second);
+    return enter < exit;
+  }
+
+  /**
+   * Get whether two boxes overlap.
+   * @return whether they overlap
+   */
+  static bool overlaps(const Box& a, const Box& b) noexcept {
+    return a.left < b.right && a.right > b.left && a.top < b.bottom && a.bottom > b.top;
+  }
+
+  /**
+   * Takes a node that is free, making more if there are none.
+   * @return the node
+   */
+  int allocate();
+
+  /**
+   * Frees a node.
+   */
+  void release(/** The node */ int node) noexcept;
+
+  /**
+   * Puts a leaf into the tree next to where it adds least to the
+   * boxes around it.
+   */
+  void insertLeaf(/** The leaf */ int leaf);
+
+  /**
+   * Takes a leaf out of the tree.
+   */
+  void removeLeaf(/** The leaf */ int leaf) noexcept;
+
+  /**
+   * Fixes the boxes and heights from a node up to the root,
+   * rebalancing on the way.
+   */
+  void refit(/** The node */ int node) noexcept;
+
+  /**
+   * Rotates a node's taller child up if its children's heights
+   * differ by more than one.
+   * @return the node now where it was
+   */
+  int balance(/** The node */ int node) noexcept;
+};
+
+}
+
+#endif
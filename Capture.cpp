@@ -0,0 +1,122 @@
+#include "Capture.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace medieval;
+
+Capture::Capture(const string& path, Format format, int width, int height, int rate,
+		 bool lossless) :
+  format_(format), width_(width), height_(height), lossless_(lossless) {
+  if (width < 1 || height < 1 || rate < 1) {
+    throw domain_error("A capture needs a size and a frame rate");
+  }
+  if (format == Format::Y4M && (width % 2 != 0 || height % 2 != 0)) {
+    throw domain_error("Y4M frames must have an even width and height");
+  }
+  file_ = path == "-" ? stdout : fopen(path.c_str(), "wb");
+  if (!file_) {
+    throw domain_error("Unable to open " + path + " for capturing");
+  }
+
+  // a large buffer lets the writer hand over whole frames at once
+  setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+  if (format == Format::Y4M) {
+    fprintf(file_, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, rate);
+    planes_.resize(width * height * 3 / 2);
+  }
+
+  size_t frameBytes = static_cast<size_t>(width) * height * 4;
+  buffers_.resize(frameBytes * BUFFERS);
+  writer_.start([this, frameBytes](int buffer) -> long {
+      return writeFrame(&buffers_[buffer * frameBytes]) ? 1 : -1;
+    });
+}
+
+Capture::~Capture() {
+  close();
+}
+
+void Capture::close() noexcept {
+  if (!file_) {
+    return;
+  }
+  writer_.close();
+  fflush(file_);
+  if (file_ != stdout) {
+    fclose(file_);
+  }
+  file_ = nullptr;
+}
+
+uint8_t* Capture::acquire() noexcept {
+  // offscreen there's no frame rate to keep up, so it's better to
+  // wait for the writer than lose the frame
+  if (held_ < 0 && (held_ = writer_.acquire(lossless_)) < 0) {
+    ++dropped_;
+    return nullptr;
+  }
+  return &buffers_[static_cast<size_t>(held_) * width_ * height_ * 4];
+}
+
+void Capture::submit(bool copied) noexcept {
+  if (held_ < 0) {
+    return;
+  }
+  if (!copied) {
+    // the buffer is kept for the next frame
+    ++dropped_;
+    return;
+  }
+
+  writer_.submit(held_);
+  held_ = -1;
+}
+
+long Capture::getWritten() const noexcept {
+  return writer_.getWritten();
+}
+
+long Capture::getDropped() const noexcept {
+  return dropped_;
+}
+
+bool Capture::failed() const noexcept {
+  return writer_.failed();
+}
+
+bool Capture::writeFrame(const uint8_t* pixels) noexcept {
+  size_t pixelCount = static_cast<size_t>(width_) * height_;
+  if (format_ == Format::RAW) {
+    return fwrite(pixels, 4, pixelCount, file_) == pixelCount;
+  }
+
+  // full range BT.601, with each chroma sample averaged over a
+  // square of four pixels
+  uint8_t* luma = &planes_[0];
+  uint8_t* blue = luma + pixelCount;
+  uint8_t* red = blue + pixelCount / 4;
+  int stride = width_ * 4;
+  for (int y = 0; y < height_; ++y) {
+    const uint8_t* row = pixels + static_cast<size_t>(y) * stride;
+    for (int x = 0; x < width_; ++x) {
+      const uint8_t* p = row + x * 4;
+      luma[static_cast<size_t>(y) * width_ + x] =
+	static_cast<uint8_t>((77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8);
+    }
+  }
+  for (int y = 0; y < height_ / 2; ++y) {
+    const uint8_t* top = pixels + static_cast<size_t>(y) * 2 * stride;
+    const uint8_t* bottom = top + stride;
+    for (int x = 0; x < width_ / 2; ++x) {
+      int r = top[x * 8] + top[x * 8 + 4] + bottom[x * 8] + bottom[x * 8 + 4];
+      int g = top[x * 8 + 1] + top[x * 8 + 5] + bottom[x * 8 + 1] + bottom[x * 8 + 5];
+      int b = top[x * 8 + 2] + top[x * 8 + 6] + bottom[x * 8 + 2] + bottom[x * 8 + 6];
+      size_t i = static_cast<size_t>(y) * (width_ / 2) + x;
+      blue[i] = static_cast<uint8_t>(min(255, ((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128));
+      red[i] = static_cast<uint8_t>(min(255, ((128 * r - 107 * g - 21 * b + 512) >> 10) + 128));
+    }
+  }
+  return fputs("FRAME\n", file_) >= 0 && fwrite(luma, 1, planes_.size(), file_) == planes_.size();
+}
@@ -0,0 +1,172 @@
+#ifndef MEDIEVAL_CAPTURE_H
+#define MEDIEVAL_CAPTURE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Writer.h"
+
+namespace medieval {
+
+/**
+ * A frame capture class. This class streams frames to a file or a
+ * pipe as a video. The game copies each frame into one of a fixed
+ * pool of buffers and hands it to a writer, which converts and
+ * writes it on its own thread while the game carries on. If every
+ * buffer is still
+ * waiting to be written the frame is dropped rather than holding up
+ * the game, unless the capture is lossless, which suits rendering
+ * offscreen where nothing runs in real time. Capturing a frame
+ * doesn't allocate.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Capture {
+public:
+
+  /**
+   * The formats a capture can be written in.
+   */
+  enum class Format {
+    /** YUV4MPEG2 video with 4:2:0 chroma, which most players and
+	encoders read directly. */ Y4M,
+    /** Headerless frames of 8 bit red, green, blue and alpha. */ RAW
+  };
+
+  /**
+   * The number of frame buffers, which must be a power of two.
+   */
+  static const int BUFFERS = Writer::BUFFERS;
+
+  /**
+   * Construct a capture and start its writer.
+   * @throw domain_error if the file can't be opened, or the size
+   * can't be written in the format.
+   */
+  Capture(/** The file or named pipe to write to, or "-" for the
+	      standard output */
+	  const std::string& path,
+	  /** The format to write */
+	  Format format,
+	  /** The width and height of the frames */
+	  int width, int height,
+	  /** The frames per second to play the video at */
+	  int rate,
+	  /** Whether to wait for a buffer rather than drop a frame */
+	  bool lossless = false);
+
+  /**
+   * The writer holds a pointer to the capture, so it can't be
+   * copied.
+   */
+  Capture(const Capture&) = delete;
+  Capture& operator=(const Capture&) = delete;
+
+  /**
+   * Close the capture.
+   */
+  ~Capture();
+
+  /**
+   * Writes the frames still waiting, stops the writer and closes
+   * the file.
+   */
+  void close() noexcept;
+
+  /**
+   * Get a buffer to copy the next frame into, as rows of width
+   * pixels of 8 bit red, green, blue and alpha bytes, with no
+   * padding.
+   * @return the buffer, or nullptr if the frame has to be dropped
+   */
+  std::uint8_t* acquire() noexcept;
+
+  /**
+   * Hands the frame copied into the last buffer acquired to the
+   * writer.
+   */
+  void submit(/** Whether the frame was copied, which if not is
+		  counted as dropped */
+	      bool copied) noexcept;
+
+  /**
+   * Get the number of frames written.
+   * @return the number of frames
+   */
+  long getWritten() const noexcept;
+
+  /**
+   * Get the number of frames dropped.
+   * @return the number of frames
+   */
+  long getDropped() const noexcept;
+
+  /**
+   * Get whether writing a frame failed, after which nothing more
+   * is written.
+   * @return whether the capture failed
+   */
+  bool failed() const noexcept;
+
+private:
+
+  /**
+   * The file written to
+   */
+  std::FILE* file_ = nullptr;
+
+  /**
+   * The format written
+   */
+  Format format_;
+
+  /**
+   * The size of the frames
+   */
+  int width_;
+  int height_;
+
+  /**
+   * Whether to wait for a buffer rather than drop a frame
+   */
+  bool lossless_;
+
+  /**
+   * The frame buffers, one after another
+   */
+  std::vector<std::uint8_t> buffers_;
+
+  /**
+   * The planes of the frame being written as Y4M
+   */
+  std::vector<std::uint8_t> planes_;
+
+  /**
+   * The buffer acquired by the game, or -1
+   */
+  int held_ = -1;
+
+  /**
+   * The frames dropped
+   */
+  long dropped_ = 0;
+
+  /**
+   * Writes the frames, declared last so that it stops before anything
+   * it writes from goes
+   */
+  Writer writer_;
+
+  /**
+   * Writes one frame.
+   * @return whether it was all written
+   */
+  bool writeFrame(/** The frame's buffer */
+		  const std::uint8_t* pixels) noexcept;
+};
+
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef MEDIEVAL_FRAMEPHASE_H
+#define MEDIEVAL_FRAMEPHASE_H
+
+namespace medieval {
+
+/**
+ * Frame Phase Enumeration.
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+  
+enum class FramePhase {
+  /** Everything between frames, such as handling events. */ EVENTS,
+  /** Drawing the background and the overlay. */ OVERLAY,
+  /** Moving the sprites and applying the rules. */ SIMULATE,
+  /** Drawing the tiles, sprites and particles. */ DRAW,
+  /** Presenting the frame and moving on to the next level. */ PRESENT,
+  /** The number of phases. */ COUNT
+};
+
+}
+
+#endif
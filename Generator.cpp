@@ -0,0 +1,166 @@
+#include "Generator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include "Balls.h"
+#include "Hazard.h"
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * The height of the ground at both ends of every chunk. 
+ */
+static const int ANCHOR = 570;
+
+/**
+ * The highest and lowest the ground goes. 
+ */
+static const int HIGHEST = 370;
+static const int LOWEST = 670;
+
+/**
+ * Roughly how many sprites a chunk has. 
+ */
+static const int SPRITES_PER_CHUNK = 40;
+
+Generator::Generator(unsigned seed, int sprites) :
+  seed_(seed), chunks_(max(1, (sprites + SPRITES_PER_CHUNK - 1) / SPRITES_PER_CHUNK)) {}
+
+void Generator::generate(vector<shared_ptr<Sprite>>& sprites, int threads) const {
+  threads = max(1, min(threads, chunks_));
+  if (threads == 1) {
+    for (int chunk = 0; chunk < chunks_; ++chunk) {
+      generateChunk(chunk, sprites);
+    }
+    return;
+  }
+
+  // each thread builds a run of chunks, which are then joined up in
+  // order so the result is the same as building them one by one
+  vector<vector<shared_ptr<Sprite>>> parts(threads);
+  vector<thread> pool;
+  for (int t = 0; t < threads; ++t) {
+    pool.emplace_back([this, t, threads, &parts]() {
+	int first = static_cast<long long>(chunks_) * t / threads;
+	int last = static_cast<long long>(chunks_) * (t + 1) / threads;
+	parts[t].reserve((last - first) * SPRITES_PER_CHUNK);
+	for (int chunk = first; chunk < last; ++chunk) {
+	  generateChunk(chunk, parts[t]);
+	}
+      });
+  }
+  size_t total = sprites.size();
+  for (int t = 0; t < threads; ++t) {
+    pool[t].join();
+    total += parts[t].size();
+  }
+  sprites.reserve(total);
+  for (vector<shared_ptr<Sprite>>& part : parts) {
+    move(part.begin(), part.end(), back_inserter(sprites));
+  }
+}
+
+int Generator::getWidth() const noexcept {
+  return chunks_ * CHUNK_TILES * TILE - TILE;
+}
+
+void Generator::generateChunk(int chunk, vector<shared_ptr<Sprite>>& sprites) const {
+  // every chunk has its own random numbers, taken straight from the
+  // generator so that they are the same with any standard library
+  uint64_t mixed = (static_cast<uint64_t>(seed_) << 32 | static_cast<uint32_t>(chunk))
+    * 0x9e3779b97f4a7c15ULL;
+  minstd_rand random(static_cast<uint32_t>(mixed >> 32) | 1);
+  auto roll = [&random](int n) { return static_cast<int>(random() % n); };
+
+  // the first chunk starts one tile left of the screen
+  int left = chunk * CHUNK_TILES * TILE - TILE;
+  int tile = 0;
+  int ground = ANCHOR;
+
+  // whether a fireball has been placed since the last health pickup
+  bool hurt = false;
+
+  while (tile < CHUNK_TILES) {
+    // the ends of the chunk are flat ground at the anchor height
+    int remaining = CHUNK_TILES - tile;
+    int length;
+    if (tile == 0) {
+      length = 4;
+    } else if (remaining <= 10) {
+      length = remaining;
+      ground = ANCHOR;
+    } else {
+      length = min(3 + roll(6), remaining - 7);
+    }
+
+    // lay the platform
+    int start = left + tile * TILE;
+    for (int i = 0; i < length; ++i) {
+      sprites.push_back(make_shared<Sprite>(Sprite(4, start + i * TILE, ground, TILE, TILE)));
+    }
+    int end = start + (length - 1) * TILE;
+
+    // heal the player if a fireball came before, otherwise maybe put
+    // a fireball or a coin on longer platforms
+    if (hurt) {
+      sprites.push_back(make_shared<Sprite>(Sprite(7, start + TILE, ground - TILE, TILE, TILE)));
+      hurt = false;
+    } else if (length >= 4 && remaining > 10) {
+      switch (roll(5)) {
+      case 0:
+	// a still fireball above head height
+	{
+	  int x = start + TILE * (1 + roll(length - 2));
+	  sprites.push_back(make_shared<Balls>(Balls(5, x, ground - 160, x, x, true)));
+	}
+	hurt = true;
+	break;
+      case 1:
+	// a fireball patrolling the platform at head height
+	sprites.push_back(make_shared<Balls>(Balls(6, start + TILE, ground - 100,
+						   start, end, roll(2) == 0)));
+	hurt = true;
+	break;
+      case 2:
+	// a fireball that dashes along the platform at head height,
+	// drops to it from high up or circles down to it
+	switch (roll(3)) {
+	case 0:
+	  sprites.push_back(make_shared<Hazard>(Hazard(6, start + TILE, ground - 100,
+						       Behavior::dasher())));
+	  break;
+	case 1:
+	  sprites.push_back(make_shared<Hazard>(Hazard(6, start + TILE * (1 + roll(length - 2)),
+						       ground - 280, Behavior::dropper())));
+	  break;
+	default:
+	  sprites.push_back(make_shared<Hazard>(Hazard(6, start + TILE * 2, ground - 160,
+						       Behavior::orbiter())));
+	  break;
+	}
+	hurt = true;
+	break;
+      default:
+	sprites.push_back(make_shared<Sprite>(Sprite(8, start + TILE * roll(length),
+						     ground - TILE, TILE, TILE)));
+	break;
+      }
+    }
+    tile += length;
+    if (tile >= CHUNK_TILES) {
+      break;
+    }
+
+    // then either a gap or a step to the next platform, both of
+    // which can be jumped
+    if (roll(2) == 0) {
+      tile += 1 + roll(3);
+      ground = min(LOWEST, ground + TILE * roll(2));
+    } else {
+      ground = max(HIGHEST, min(LOWEST, ground + TILE * (roll(5) - 2)));
+    }
+  }
+}
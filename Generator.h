@@ -0,0 +1,86 @@
+#ifndef MEDIEVAL_GENERATOR_H
+#define MEDIEVAL_GENERATOR_H
+
+#include <memory>
+#include <vector>
+#include "Sprite.h"
+
+namespace medieval {
+
+/**
+ * A level generator class. This class builds long levels out of the
+ * same pieces as the hand made ones: rows of platform tiles, still,
+ * patrolling and scripted fireballs, health pickups and coins. The
+ * level is made of fixed width chunks that each start and end on
+ * solid ground at the same height and are built from their own seed,
+ * so the same seed always gives the same level, however many threads
+ * build it.
+ *
+ * Every level can be completed by running right and jumping. Gaps
+ * are at most three tiles wide, steps up at most two tiles high, and
+ * every fireball is followed by a health pickup on the ground before
+ * the next one, so even running into every fireball is survivable.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Generator {
+public:
+
+  /**
+   * The width of a chunk in tiles. 
+   */
+  static const int CHUNK_TILES = 40;
+
+  /**
+   * The width and height of a tile. 
+   */
+  static const int TILE = 50;
+
+  /**
+   * Construct a generator. 
+   */
+  Generator(/** The seed for the level */
+	    unsigned seed,
+	    /** Roughly how many sprites the level should have */
+	    int sprites);
+
+  /**
+   * Adds the sprites of the level to a list, in order from left
+   * to right. 
+   */
+  void generate(/** The list to add to */
+		std::vector<std::shared_ptr<Sprite>>& sprites,
+		/** The number of threads to build the chunks with */
+		int threads = 1) const;
+
+  /**
+   * Get the x coordinate the player must pass to finish the level.
+   * @return the x coordinate of the end
+   */
+  int getWidth() const noexcept;
+
+private:
+
+  /**
+   * The seed for the level
+   */
+  unsigned seed_;
+
+  /**
+   * The number of chunks in the level
+   */
+  int chunks_;
+
+  /**
+   * Adds the sprites of one chunk to a list. 
+   */
+  void generateChunk(/** The chunk */
+		     int chunk,
+		     /** The list to add to */
+		     std::vector<std::shared_ptr<Sprite>>& sprites) const;
+};
+
+}
+
+#endif
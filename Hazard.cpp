@@ -0,0 +1,19 @@
+#include "Hazard.h"
+
+#include <stdexcept>
+
+using namespace std;
+using namespace medieval;
+
+Hazard::Hazard(int index, int x, int y, const Behavior& behavior) :
+  Sprite(index, x, y, 50, 50), behavior_(&behavior) {
+  if (behavior.size() == 0) {
+    throw domain_error("A hazard's behavior needs steps");
+  }
+}
+
+const Behavior& Hazard::getBehavior() const noexcept {
+  return *behavior_;
+}
+
+void Hazard::move() noexcept {}
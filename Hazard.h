@@ -0,0 +1,60 @@
+#ifndef MEDIEVAL_HAZARD_H
+#define MEDIEVAL_HAZARD_H
+
+#include "Behavior.h"
+#include "Sprite.h"
+
+namespace medieval {
+
+class Hazards;
+
+/**
+ * A scripted hazard class. This class is a subclass of the sprite
+ * class for fireballs that follow a behavior. It doesn't move itself:
+ * the level's hazards resume its behavior each tick instead, so its
+ * move function does nothing.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Hazard : public Sprite {
+public:
+
+  /**
+   * Construct a hazard.
+   * @throw domain_error if the behavior has no steps.
+   */
+  Hazard(/** The index of this hazard's image */
+	 int index,
+	 /** The x and y coordinates this hazard starts at */
+	 int x, int y,
+	 /** The behavior to follow, which must outlive the hazard */
+	 const Behavior& behavior);
+
+  /**
+   * Get the behavior the hazard follows.
+   * @return the behavior
+   */
+  const Behavior& getBehavior() const noexcept;
+
+  /**
+   * Does nothing, as the hazard is moved by its behavior.
+   */
+  void move() noexcept override;
+
+private:
+
+  /**
+   * The behavior to follow
+   */
+  const Behavior* behavior_;
+
+  /**
+   * The hazards move the hazard as its behavior says.
+   */
+  friend class Hazards;
+};
+
+}
+
+#endif
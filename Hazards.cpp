@@ -0,0 +1,272 @@
+#include "Hazards.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * Get how far across from the centre of a circle a point on it is.
+ * @return the distance, in pixels
+ */
+static int across(/** The radius */ int radius, /** The degrees round */ int phase) {
+  return radius * Behavior::cosine(phase) / 1024;
+}
+
+/**
+ * Get how far down from the centre of a circle a point on it is.
+ * @return the distance, in pixels
+ */
+static int down(/** The radius */ int radius, /** The degrees round */ int phase) {
+  return radius * Behavior::sine(phase) / 1024;
+}
+
+Hazards::Hazards() noexcept {
+  fill(slots_, slots_ + WHEEL, -1);
+}
+
+void Hazards::reserve(size_t count) {
+  frames_.reserve(count);
+}
+
+void Hazards::add(Hazard& hazard) {
+  Frame frame;
+  frame.hazard = &hazard;
+  frame.homeX = hazard.getXCoordinate();
+  frame.homeY = hazard.getYCoordinate();
+  frame.wake = tick_;
+  frames_.push_back(frame);
+  schedule(static_cast<int>(frames_.size()) - 1);
+}
+
+void Hazards::resume() noexcept {
+  // takes the whole slot, resumes the frames due now and puts every
+  // frame back in the slot for when it is next due, which for those
+  // still waiting is this same slot a turn of the wheel later, and
+  // leaves out those that fell asleep
+  int* slot = &slots_[tick_ & (WHEEL - 1)];
+  int frame = *slot;
+  *slot = -1;
+  awake_ = 0;
+  while (frame >= 0) {
+    Frame& f = frames_[frame];
+    int next = f.next;
+    f.scheduled = false;
+    if (!f.asleep) {
+      if (f.wake == tick_) {
+	note(frame);
+	run(f, *f.hazard, tick_);
+	++awake_;
+      }
+      schedule(frame);
+    }
+    frame = next;
+  }
+  ++tick_;
+}
+
+void Hazards::sleep(int frame) noexcept {
+  frames_[frame].asleep = true;
+}
+
+void Hazards::wake(int frame) noexcept {
+  Frame& f = frames_[frame];
+  f.asleep = false;
+  if (f.wake < tick_) {
+    note(frame);
+    advance(f, *f.hazard, tick_);
+  }
+
+  // one that fell asleep since its slot last came round is still in it
+  if (!f.scheduled) {
+    schedule(frame);
+  }
+}
+
+void Hazards::find(int frame, Frame& current, SpriteState& sprite) const noexcept {
+  current = frames_[frame];
+  if (current.asleep && current.wake < tick_) {
+    Hazard hazard(*current.hazard);
+    advance(current, hazard, tick_);
+    hazard.save(sprite);
+  } else {
+    current.hazard->save(sprite);
+  }
+}
+
+size_t Hazards::size() const noexcept {
+  return frames_.size();
+}
+
+int Hazards::getAwake() const noexcept {
+  return awake_;
+}
+
+void Hazards::save(vector<Frame>& frames) const {
+  frames.resize(frames_.size());
+  SpriteState sprite;
+  for (size_t i = 0; i < frames_.size(); ++i) {
+    find(static_cast<int>(i), frames[i], sprite);
+    frames[i].wake -= tick_;
+  }
+}
+
+void Hazards::restore(const vector<Frame>& frames) noexcept {
+  // only where each hazard is in its behavior comes from the saved
+  // frames, and the wheel is built again around them
+  for (size_t i = 0; i < frames_.size() && i < frames.size(); ++i) {
+    Frame& f = frames_[i];
+    note(static_cast<int>(i));
+    f.step = frames[i].step;
+    f.left = frames[i].left;
+    f.phase = frames[i].phase;
+    f.speed = frames[i].speed;
+    f.wake = tick_ + frames[i].wake;
+  }
+  reschedule();
+}
+
+void Hazards::setJournal(bool journal) {
+  journal_ = journal;
+  changes_.clear();
+  if (journal) {
+    changes_.reserve(frames_.size());
+    noted_.assign(frames_.size(), 0);
+  }
+}
+
+const vector<Hazards::Change>& Hazards::getJournal() const noexcept {
+  return changes_;
+}
+
+void Hazards::clearJournal() noexcept {
+  changes_.clear();
+  ++cleared_;
+}
+
+void Hazards::undo(const Change& change) noexcept {
+  Frame& f = frames_[change.index];
+  f.step = change.frame.step;
+  f.left = change.frame.left;
+  f.phase = change.frame.phase;
+  f.speed = change.frame.speed;
+  f.wake = change.frame.wake;
+  undone_ = true;
+}
+
+void Hazards::back() noexcept {
+  // the hazards the tick resumed are due again, and those it didn't
+  // are in the slots they were in before it
+  --tick_;
+  if (undone_) {
+    reschedule();
+    undone_ = false;
+  }
+  clearJournal();
+}
+
+void Hazards::note(int frame) noexcept {
+  if (!journal_ || noted_[frame] == cleared_) {
+    return;
+  }
+  noted_[frame] = cleared_;
+  Change change;
+  change.index = frame;
+  change.frame = frames_[frame];
+  change.frame.hazard->save(change.sprite);
+  changes_.push_back(change);
+}
+
+void Hazards::reschedule() noexcept {
+  fill(slots_, slots_ + WHEEL, -1);
+  for (size_t i = 0; i < frames_.size(); ++i) {
+    frames_[i].scheduled = false;
+    if (!frames_[i].asleep) {
+      schedule(static_cast<int>(i));
+    }
+  }
+}
+
+void Hazards::schedule(int frame) noexcept {
+  Frame& f = frames_[frame];
+  int* slot = &slots_[f.wake & (WHEEL - 1)];
+  f.next = *slot;
+  f.scheduled = true;
+  *slot = frame;
+}
+
+void Hazards::advance(Frame& frame, Hazard& hazard, int tick) noexcept {
+  if (frame.wake >= tick) {
+    return;
+  }
+
+  // a behavior that always brings the hazard back to where it was is
+  // in the same place once through it, only turned further, so whole
+  // times through it are skipped at once
+  const Behavior& behavior = *hazard.behavior_;
+  if (behavior.getReach() >= 0) {
+    int period = behavior.getTicks();
+    int times = (tick - frame.wake) / period;
+    frame.wake += times * period;
+    long long turn = static_cast<long long>(behavior.getSpin()) * behavior.getMoves() % 360;
+    hazard.angle_ = static_cast<int>(((hazard.angle_ + turn * (times % 360)) % 360 + 360) % 360);
+  }
+  while (frame.wake < tick) {
+    run(frame, hazard, frame.wake);
+  }
+}
+
+void Hazards::run(Frame& frame, Hazard& hazard, int tick) noexcept {
+  const Behavior& behavior = *hazard.behavior_;
+  const Behavior::Step& step = behavior.getStep(frame.step);
+
+  // a wait is over as soon as it starts, and the hazard isn't
+  // resumed again until the tick after it ends
+  if (frame.left == 0) {
+    if (step.op == Behavior::Op::WAIT) {
+      frame.step = (frame.step + 1) % behavior.size();
+      frame.wake = tick + step.ticks;
+      return;
+    }
+    frame.left = step.ticks;
+    frame.speed = 0;
+  }
+
+  switch (step.op) {
+  case Behavior::Op::WAIT:
+    break;
+  case Behavior::Op::DASH:
+    hazard.x_ += step.x;
+    hazard.y_ += step.y;
+    break;
+  case Behavior::Op::ORBIT:
+    {
+      // moves by the difference between the points, which always
+      // adds up to the same place after a whole turn
+      int phase = frame.phase + step.y;
+      phase = phase >= 360 ? phase - 360 : phase < 0 ? phase + 360 : phase;
+      hazard.x_ += across(step.x, phase) - across(step.x, frame.phase);
+      hazard.y_ += down(step.x, phase) - down(step.x, frame.phase);
+      frame.phase = phase;
+    }
+    break;
+  case Behavior::Op::DROP:
+    hazard.y_ += ++frame.speed;
+    break;
+  case Behavior::Op::HOME:
+    hazard.x_ += (frame.homeX - hazard.x_) / frame.left;
+    hazard.y_ += (frame.homeY - hazard.y_) / frame.left;
+    break;
+  }
+  // the angle is kept within a turn, so that skipping whole times
+  // through the behavior turns it the same
+  hazard.angle_ += behavior.getSpin();
+  if (hazard.angle_ < 0 || hazard.angle_ >= 360) {
+    hazard.angle_ = (hazard.angle_ % 360 + 360) % 360;
+  }
+
+  if (--frame.left == 0) {
+    frame.step = (frame.step + 1) % behavior.size();
+  }
+  frame.wake = tick + 1;
+}
@@ -0,0 +1,267 @@
+#ifndef MEDIEVAL_HAZARDS_H
+#define MEDIEVAL_HAZARDS_H
+
+#include <cstddef>
+#include <vector>
+#include "Hazard.h"
+
+namespace medieval {
+
+/**
+ * A class for running the scripted hazards of a level. Each hazard
+ * has a frame holding where it is in its behavior, and all of the
+ * frames sit in one pool, so adding hazards doesn't allocate per
+ * hazard and resuming them doesn't allocate at all. Frames are kept
+ * on a timing wheel by the tick they next need resuming on, so a
+ * hazard that is waiting isn't looked at again until its wait is
+ * nearly over, and a tick only costs as much as the hazards that
+ * are moving. A hazard can also be put to sleep, when it isn't
+ * resumed at all, and is moved on past the ticks it slept when it
+ * wakes, a whole time through its behavior at once where that
+ * always brings it back to where it was.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Hazards {
+public:
+
+  /**
+   * The number of slots on the timing wheel, which must be a power
+   * of two. A hazard waiting longer than this is looked at once
+   * every time the wheel comes round.
+   */
+  static const int WHEEL = 64;
+
+  /**
+   * Where one hazard is in its behavior.
+   */
+  struct Frame {
+    /** The hazard */
+    Hazard* hazard = nullptr;
+    /** Where the hazard started */
+    int homeX = 0;
+    int homeY = 0;
+    /** The step the hazard is on */
+    int step = 0;
+    /** The ticks left in the step, or 0 if it hasn't started */
+    int left = 0;
+    /** The degrees the hazard is round its orbit */
+    int phase = 0;
+    /** How fast the hazard is falling */
+    int speed = 0;
+    /** The tick to resume the hazard on, or when saved how many
+	ticks away that is */
+    int wake = 0;
+    /** The next frame in the same slot of the wheel, or -1 */
+    int next = -1;
+    /** Whether the hazard is asleep, and whether the frame is in a
+	slot of the wheel, which one asleep stays in until the slot
+	comes round */
+    bool asleep = false;
+    bool scheduled = false;
+  };
+
+  /**
+   * A hazard as it was before a tick changed it, kept in the journal.
+   */
+  struct Change {
+    /** The index of its frame */
+    int index;
+    /** Its frame, with the tick to resume it on */
+    Frame frame;
+    /** The hazard itself */
+    SpriteState sprite;
+  };
+
+  /**
+   * Construct a set of hazards with none in it.
+   */
+  Hazards() noexcept;
+
+  /**
+   * Makes room for a number of hazards, so that adding them
+   * allocates at most once.
+   */
+  void reserve(/** The number of hazards */
+	       std::size_t count);
+
+  /**
+   * Adds a hazard, which starts its behavior on the next tick.
+   */
+  void add(/** The hazard, which must outlive these hazards */
+	   Hazard& hazard);
+
+  /**
+   * Resumes every hazard due this tick and moves on to the next.
+   */
+  void resume() noexcept;
+
+  /**
+   * Stops resuming a hazard until it is woken.
+   */
+  void sleep(/** The index of its frame */
+	     int frame) noexcept;
+
+  /**
+   * Starts resuming a hazard again, first moving it on to wherever
+   * it would be had it never slept. That takes no more than one time
+   * through its behavior however long it slept, unless the behavior
+   * doesn't bring it back to where it started, when every tick it
+   * slept is run.
+   */
+  void wake(/** The index of its frame */
+	    int frame) noexcept;
+
+  /**
+   * Finds where a hazard is now, even if it is asleep, without
+   * waking it.
+   */
+  void find(/** The index of its frame */
+	    int frame,
+	    /** Set to its frame as it would be now */
+	    Frame& current,
+	    /** Set to the hazard as it would be now */
+	    SpriteState& sprite) const noexcept;
+
+  /**
+   * Get the number of hazards.
+   * @return the number of hazards
+   */
+  std::size_t size() const noexcept;
+
+  /**
+   * Get how many hazards the last tick resumed.
+   * @return the number of hazards resumed
+   */
+  int getAwake() const noexcept;
+
+  /**
+   * Saves where every hazard is in its behavior, as it would be now
+   * for those asleep. The positions of the hazards themselves are
+   * saved with the other sprites.
+   */
+  void save(/** Where to save the frames */
+	    std::vector<Frame>& frames) const;
+
+  /**
+   * Restores frames previously saved from these hazards. Those asleep
+   * stay asleep.
+   */
+  void restore(/** The frames to restore */
+	       const std::vector<Frame>& frames) noexcept;
+
+  /**
+   * Starts keeping every hazard resumed or restored in the journal,
+   * as it was before, or stops. Makes room for all of them, so that
+   * keeping them doesn't allocate.
+   */
+  void setJournal(/** Whether to keep the journal */
+		  bool journal);
+
+  /**
+   * Get the hazards changed since the journal was last cleared, each
+   * as it was the first time it changed.
+   * @return the changes, in the order they were made
+   */
+  const std::vector<Change>& getJournal() const noexcept;
+
+  /**
+   * Clears the journal.
+   */
+  void clearJournal() noexcept;
+
+  /**
+   * Puts a hazard back as it was in a change from the journal. Once
+   * every change of the last tick is put back, back must be called.
+   */
+  void undo(/** The change */
+	    const Change& change) noexcept;
+
+  /**
+   * Goes back to the tick before, once the hazards it changed are put
+   * back, and clears the journal.
+   */
+  void back() noexcept;
+
+private:
+
+  /**
+   * The frame of every hazard, in the order they were added
+   */
+  std::vector<Frame> frames_;
+
+  /**
+   * The first frame in each slot of the wheel, or -1
+   */
+  int slots_[WHEEL];
+
+  /**
+   * The number of ticks resumed so far
+   */
+  int tick_ = 0;
+
+  /**
+   * The number of hazards the last tick resumed
+   */
+  int awake_ = 0;
+
+  /**
+   * Whether to keep the journal, the journal, and the number of times
+   * it was cleared when each frame was last kept in it
+   */
+  bool journal_ = false;
+  std::vector<Change> changes_;
+  std::vector<unsigned> noted_;
+  unsigned cleared_ = 1;
+
+  /**
+   * Whether a frame was put back from the journal since the wheel was
+   * last built
+   */
+  bool undone_ = false;
+
+  /**
+   * Keeps a frame in the journal as it is now, unless it already is.
+   */
+  void note(/** The index of the frame */
+	    int frame) noexcept;
+
+  /**
+   * Puts every frame in the slot for the tick it next wakes on, from
+   * scratch.
+   */
+  void reschedule() noexcept;
+
+  /**
+   * Puts a frame in the slot for the tick it next wakes on.
+   */
+  void schedule(/** The index of the frame */
+		int frame) noexcept;
+
+  /**
+   * Moves a hazard on past every tick it should have been resumed on
+   * before a tick.
+   */
+  static void advance(/** The hazard's frame */
+		      Frame& frame,
+		      /** The hazard */
+		      Hazard& hazard,
+		      /** The tick */
+		      int tick) noexcept;
+
+  /**
+   * Runs one tick of a hazard's behavior, starting the next step
+   * if the last one finished, and sets when to resume it next.
+   */
+  static void run(/** The hazard's frame */
+		  Frame& frame,
+		  /** The hazard */
+		  Hazard& hazard,
+		  /** The tick */
+		  int tick) noexcept;
+};
+
+}
+
+#endif
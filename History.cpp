@@ -0,0 +1,122 @@
+#include "History.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace medieval;
+
+History::History(int ticks, int changes) : ticks_(max(ticks, 1)), room_(max(changes, 1)) {
+}
+
+void History::start(Level& level, const int* values) {
+  first_ = 0;
+  count_ = 0;
+  changeCount_ = 0;
+  hazardChangeCount_ = 0;
+  copy(values, values + VALUES, values_);
+
+  // going back to the start changes every sprite that moves, which
+  // there is room for on top of the rest, so losing every life
+  // doesn't forget anything, and a level with hazards gets as much
+  // room again for them, since every one that moves changes its
+  // frame as well as itself
+  changes_.assign(room_ + static_cast<size_t>(RESTARTS) * level.getMovers(), Level::Change());
+  size_t hazards = level.getHazards().size();
+  hazardChanges_.assign(hazards == 0 ? 0 : room_ + RESTARTS * hazards, Hazards::Change());
+  level.setJournal(true);
+}
+
+void History::record(Level& level, const int* values) noexcept {
+  const vector<Level::Change>& journal = level.getJournal();
+  const vector<Hazards::Change>& hazardJournal = level.getHazards().getJournal();
+  int changes = static_cast<int>(journal.size());
+  int hazardChanges = static_cast<int>(hazardJournal.size());
+
+  // forgets the oldest ticks until there is room, or everything if
+  // this one changed too much to keep at all
+  if (changes > static_cast<int>(changes_.size()) ||
+      hazardChanges > static_cast<int>(hazardChanges_.size())) {
+    dropped_ += count_;
+    count_ = 0;
+  }
+  while (count_ > 0 &&
+	 (count_ == static_cast<int>(ticks_.size()) ||
+	  changeCount_ - ticks_[first_].change + changes > static_cast<long>(changes_.size()) ||
+	  hazardChangeCount_ - ticks_[first_].hazardChange + hazardChanges >
+	  static_cast<long>(hazardChanges_.size()))) {
+    if (count_ < static_cast<int>(ticks_.size())) {
+      ++dropped_;
+    }
+    forget();
+  }
+
+  // keeps the sprites and hazards it changed as they were before it
+  if (changes <= static_cast<int>(changes_.size()) &&
+      hazardChanges <= static_cast<int>(hazardChanges_.size())) {
+    Tick& tick = ticks_[(first_ + count_) % ticks_.size()];
+    tick.change = changeCount_;
+    tick.hazardChange = hazardChangeCount_;
+    tick.changes = changes;
+    tick.hazardChanges = hazardChanges;
+    copy(values_, values_ + VALUES, tick.values);
+    for (const Level::Change& change : journal) {
+      changes_[changeCount_++ % changes_.size()] = change;
+    }
+    for (const Hazards::Change& change : hazardJournal) {
+      hazardChanges_[hazardChangeCount_++ % hazardChanges_.size()] = change;
+    }
+    ++count_;
+  }
+  level.clearJournal();
+  copy(values, values + VALUES, values_);
+}
+
+bool History::rewind(Level& level, int* values) noexcept {
+  if (count_ == 0) {
+    return false;
+  }
+
+  // puts back what the newest tick changed, the last change first in
+  // case a sprite changed more than one way, and takes its changes
+  // off the end of the rings
+  const Tick& tick = ticks_[(first_ + count_ - 1) % ticks_.size()];
+  for (int i = tick.changes - 1; i >= 0; --i) {
+    level.undo(changes_[(tick.change + i) % changes_.size()]);
+  }
+  for (int i = tick.hazardChanges - 1; i >= 0; --i) {
+    level.undo(hazardChanges_[(tick.hazardChange + i) % hazardChanges_.size()]);
+  }
+  level.back();
+  copy(tick.values, tick.values + VALUES, values_);
+  copy(tick.values, tick.values + VALUES, values);
+  changeCount_ = tick.change;
+  hazardChangeCount_ = tick.hazardChange;
+  --count_;
+  return true;
+}
+
+int History::getTicks() const noexcept {
+  return count_;
+}
+
+double History::getSeconds() const noexcept {
+  return static_cast<double>(count_) / RATE;
+}
+
+int History::getChanges() const noexcept {
+  return count_ == 0 ? 0 : static_cast<int>(changeCount_ - ticks_[first_].change);
+}
+
+size_t History::getBytes() const noexcept {
+  return sizeof(*this) + ticks_.capacity() * sizeof(Tick) + changes_.capacity() * sizeof(Level::Change) +
+    hazardChanges_.capacity() * sizeof(Hazards::Change);
+}
+
+long History::getDropped() const noexcept {
+  return dropped_;
+}
+
+void History::forget() noexcept {
+  first_ = (first_ + 1) % ticks_.size();
+  --count_;
+}
@@ -0,0 +1,192 @@
+#ifndef MEDIEVAL_HISTORY_H
+#define MEDIEVAL_HISTORY_H
+
+#include <cstddef>
+#include <vector>
+#include "Level.h"
+
+namespace medieval {
+
+/**
+ * A history class. This class remembers the last few seconds of a
+ * level, so that it can be run backwards a tick at a time. Rather
+ * than a copy of the whole level every tick, each tick keeps only
+ * the sprites it changed, as they were before it: the player, the
+ * fireballs and hazards that moved and the pickups taken, which the
+ * level keeps in its journal as it changes them, so remembering a
+ * tick costs as much as the sprites awake however big the level is.
+ * Going back a tick puts just those back, so it takes no longer the
+ * further back it goes. The changes are kept in rings of fixed size,
+ * made when the history is started with room for the ticks that put
+ * every sprite that moves back, as losing a life does, so recording
+ * never allocates, and once they are full the oldest ticks are
+ * forgotten to make room.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class History {
+public:
+
+  /**
+   * The number of ticks a second.
+   */
+  static const int RATE = 60;
+
+  /**
+   * The number of ticks remembered by default, which is 10 seconds.
+   */
+  static const int TICKS = RATE * 10;
+
+  /**
+   * The number of sprite changes kept by default on top of those of
+   * going back to the start, which is enough for every tick
+   * remembered to change 16 sprites, about three times as many as
+   * the built-in levels and generated levels do.
+   */
+  static const int CHANGES = TICKS * 16;
+
+  /**
+   * The number of times going back to the start is made room for,
+   * which is as many lives as the player starts with.
+   */
+  static const int RESTARTS = 5;
+
+  /**
+   * The number of values kept alongside the level every tick, for
+   * whatever else goes back with it.
+   */
+  static const int VALUES = 8;
+
+  /**
+   * Construct a history with nothing in it.
+   */
+  History(/** The number of ticks to remember */
+	  int ticks = TICKS,
+	  /** The number of sprite changes to keep on top of those
+	      of going back to the start, after which the oldest ticks
+	      are forgotten */
+	  int changes = CHANGES);
+
+  /**
+   * Forgets everything, and starts remembering a level from how it
+   * is now, keeping its journal. Makes room for as many changes as
+   * asked for, and those of going back to the start as many times as
+   * the player has lives, for the sprites and the hazards.
+   */
+  void start(/** The level */
+	     Level& level,
+	     /** The values to go back to alongside it */
+	     const int* values);
+
+  /**
+   * Remembers the tick the level has just run, from its journal,
+   * which it then clears.
+   */
+  void record(/** The level, which must be the one started */
+	      Level& level,
+	      /** The values to go back to alongside it */
+	      const int* values) noexcept;
+
+  /**
+   * Runs the level back to before the last tick remembered, and
+   * forgets it.
+   * @return whether there was a tick to go back over
+   */
+  bool rewind(/** The level, which must be the one started */
+	      Level& level,
+	      /** Set to the values before the tick */
+	      int* values) noexcept;
+
+  /**
+   * Get the number of ticks that can be gone back over.
+   * @return the number of ticks
+   */
+  int getTicks() const noexcept;
+
+  /**
+   * Get how long can be gone back over, which is less than was asked
+   * for once ticks are forgotten to make room.
+   * @return the seconds
+   */
+  double getSeconds() const noexcept;
+
+  /**
+   * Get the number of sprite changes kept for them.
+   * @return the number of changes
+   */
+  int getChanges() const noexcept;
+
+  /**
+   * Get the memory the history takes, which is fixed when it is
+   * started.
+   * @return the bytes
+   */
+  std::size_t getBytes() const noexcept;
+
+  /**
+   * Get the number of ticks forgotten to make room for newer ones,
+   * rather than because they were too long ago.
+   * @return the number of ticks
+   */
+  long getDropped() const noexcept;
+
+private:
+
+  /**
+   * What a tick changed
+   */
+  struct Tick {
+    /** Where its sprite and hazard changes start, counting every
+	change ever kept */
+    long change;
+    long hazardChange;
+    /** The number of them */
+    int changes;
+    int hazardChanges;
+    /** The values before it */
+    int values[VALUES];
+  };
+
+  /**
+   * The ticks remembered, going round and round, the oldest one
+   * and the number of them
+   */
+  std::vector<Tick> ticks_;
+  long first_ = 0;
+  int count_ = 0;
+
+  /**
+   * The number of sprite changes to keep on top of those of going
+   * back to the start
+   */
+  int room_;
+
+  /**
+   * The sprite and hazard changes, going round and round, with the
+   * number ever kept of each
+   */
+  std::vector<Level::Change> changes_;
+  std::vector<Hazards::Change> hazardChanges_;
+  long changeCount_ = 0;
+  long hazardChangeCount_ = 0;
+
+  /**
+   * The values as they are now
+   */
+  int values_[VALUES] = {};
+
+  /**
+   * The number of ticks forgotten to make room
+   */
+  long dropped_ = 0;
+
+  /**
+   * Forgets the oldest tick.
+   */
+  void forget() noexcept;
+};
+
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef MEDIEVAL_HIT_H
+#define MEDIEVAL_HIT_H
+
+namespace medieval {
+
+class Sprite;
+
+/**
+ * A hit structure. This structure is something a query of the level
+ * found: a sprite, or a platform tile on the level's grid, which
+ * isn't a sprite, along with where it is and what kind of thing it
+ * is. The kinds can be combined to look for several at once.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+struct Hit {
+
+  /**
+   * The kinds of thing there are to find.
+   */
+  static const unsigned TERRAIN = 1;
+  static const unsigned OBSTACLES = 2;
+  static const unsigned HEALTH = 4;
+  static const unsigned COINS = 8;
+  static const unsigned PLAYER = 16;
+  static const unsigned EVERYTHING = 31;
+
+  /** The sprite, or nullptr for a tile on the grid */
+  const Sprite* sprite = nullptr;
+  /** What kind of thing it is, or 0 if nothing was found */
+  unsigned kind = 0;
+  /** Where it is and its size, now */
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+  /** How far along a ray or sweep it was hit, from 0 to 1 */
+  double fraction = 0;
+};
+
+/**
+ * A ray structure. This structure is a ray, or a box sweeping along a
+ * line, for looking up many at once.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+struct Ray {
+  /** Where the ray starts, or the top left of the box */
+  int x;
+  int y;
+  /** How far it goes across and down */
+  int dx;
+  int dy;
+  /** The size of the box, which is 0 for a ray */
+  int width;
+  int height;
+  /** The kinds of thing to look for */
+  unsigned kinds;
+};
+
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include "Jobs.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace medieval;
+
+Jobs::Jobs(int threads) {
+  if (threads < 1) {
+    throw domain_error("A job system needs at least 1 thread");
+  }
+  for (int i = 0; i < threads; ++i) {
+    deques_.emplace_back(new Deque());
+  }
+  for (int i = 1; i < threads; ++i) {
+    workers_.emplace_back(&Jobs::serve, this, i);
+  }
+}
+
+Jobs::~Jobs() {
+  {
+    lock_guard<mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+int Jobs::getThreads() const noexcept {
+  return static_cast<int>(deques_.size());
+}
+
+long Jobs::getSteals() const noexcept {
+  return steals_.load(memory_order_relaxed);
+}
+
+void Jobs::run(int count, int grain, void (*body)(const void*, int, int), const void* context) {
+  if (count <= 0) {
+    return;
+  }
+  int threads = getThreads();
+  grain = max(grain, 1);
+  int ranges = (count + grain - 1) / grain;
+
+  // Small loops aren't worth waking anyone for
+  if (threads == 1 || ranges == 1) {
+    body(context, 0, count);
+    return;
+  }
+
+  // Make the ranges bigger if there are too many to hold
+  if (ranges > threads * DEQUE) {
+    ranges = threads * DEQUE;
+    grain = (count + ranges - 1) / ranges;
+    ranges = (count + grain - 1) / grain;
+  }
+
+  // Give each thread a run of neighbouring ranges
+  remaining_.store(ranges, memory_order_relaxed);
+  for (int t = 0; t < threads; ++t) {
+    Deque& deque = *deques_[t];
+    lock_guard<mutex> lock(deque.mutex);
+    if (deque.front == deque.back) {
+      deque.front = deque.back = 0;
+    }
+    for (int r = ranges * t / threads; r < ranges * (t + 1) / threads; ++r) {
+      Range& range = deque.ranges[deque.back++ % DEQUE];
+      range.begin = r * grain;
+      range.end = min(count, (r + 1) * grain);
+      range.body = body;
+      range.context = context;
+    }
+  }
+  {
+    lock_guard<mutex> lock(mutex_);
+    ++loop_;
+  }
+  wake_.notify_all();
+
+  // Help out, then wait for whatever the workers are still running
+  work(0);
+  unique_lock<mutex> lock(mutex_);
+  done_.wait(lock, [this] { return remaining_.load(memory_order_acquire) == 0; });
+}
+
+bool Jobs::take(int self, Range& range) noexcept {
+  // The most recently added range of its own
+  {
+    Deque& deque = *deques_[self];
+    lock_guard<mutex> lock(deque.mutex);
+    if (deque.front != deque.back) {
+      range = deque.ranges[--deque.back % DEQUE];
+      return true;
+    }
+  }
+
+  // Otherwise the oldest range of another's
+  int threads = getThreads();
+  for (int i = 1; i < threads; ++i) {
+    Deque& deque = *deques_[(self + i) % threads];
+    lock_guard<mutex> lock(deque.mutex);
+    if (deque.front != deque.back) {
+      range = deque.ranges[deque.front++ % DEQUE];
+      steals_.fetch_add(1, memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Jobs::work(int self) noexcept {
+  Range range;
+  while (take(self, range)) {
+    range.body(range.context, range.begin, range.end);
+    if (remaining_.fetch_sub(1, memory_order_acq_rel) == 1) {
+      lock_guard<mutex> lock(mutex_);
+      done_.notify_all();
+    }
+  }
+}
+
+void Jobs::serve(int self) noexcept {
+  unsigned seen = 0;
+  for (;;) {
+    {
+      unique_lock<mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stopping_ || loop_ != seen; });
+      if (stopping_) {
+	return;
+      }
+      seen = loop_;
+    }
+    work(self);
+  }
+}
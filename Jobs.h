@@ -0,0 +1,170 @@
+#ifndef MEDIEVAL_JOBS_H
+#define MEDIEVAL_JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace medieval {
+
+/**
+ * A job system class. This class keeps a fixed set of worker threads
+ * that split loops between them. Each thread has its own deque of 
+ * ranges to run, taking from the back of its own and stealing from 
+ * the front of the others' when it runs out, so that a thread given 
+ * slow ranges doesn't hold up the rest. Running a loop doesn't 
+ * allocate. 
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Jobs {
+public:
+
+  /**
+   * The most ranges each thread's deque can hold. 
+   */
+  static const int DEQUE = 1024;
+
+  /**
+   * Construct a job system. 
+   */
+  explicit Jobs(/** The number of threads to run loops on, including
+		    the one that runs them, which must be at least 1 */
+		int threads);
+
+  /**
+   * The workers hold pointers to the job system, so it can't be 
+   * copied. 
+   */
+  Jobs(const Jobs&) = delete;
+  Jobs& operator=(const Jobs&) = delete;
+
+  /**
+   * Stop the workers. 
+   */
+  ~Jobs();
+
+  /**
+   * Runs a loop from 0 to count, split into ranges of about grain 
+   * iterations across the threads, and waits for all of it to 
+   * finish. Only one thread may run loops at a time. 
+   */
+  template <typename Body>
+  void run(/** The number of iterations */
+	   int count,
+	   /** The number of iterations to hand out at once */
+	   int grain,
+	   /** Called with the beginning and end of each range */
+	   const Body& body) {
+    run(count, grain, &call<Body>, &body);
+  }
+
+  /**
+   * Get the number of threads loops run on.
+   * @return the number of threads
+   */
+  int getThreads() const noexcept;
+
+  /**
+   * Get the number of ranges a thread has taken from another's deque.
+   * @return the number of steals
+   */
+  long getSteals() const noexcept;
+
+private:
+
+  /**
+   * A range of a loop and what to run it with
+   */
+  struct Range {
+    int begin;
+    int end;
+    void (*body)(const void* body, int begin, int end);
+    const void* context;
+  };
+
+  /**
+   * A thread's deque of ranges, which wraps around
+   */
+  struct Deque {
+    std::mutex mutex;
+    Range ranges[DEQUE];
+    int front = 0;
+    int back = 0;
+  };
+
+  /**
+   * One deque per thread, the first belonging to the caller
+   */
+  std::vector<std::unique_ptr<Deque>> deques_;
+
+  /**
+   * The worker threads
+   */
+  std::vector<std::thread> workers_;
+
+  /**
+   * Guards waking the workers and waiting for a loop to finish
+   */
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+
+  /**
+   * Counts the loops run, so the workers know there's a new one
+   */
+  unsigned loop_ = 0;
+
+  /**
+   * Whether the workers should stop
+   */
+  bool stopping_ = false;
+
+  /**
+   * The number of ranges of the current loop that haven't finished
+   */
+  std::atomic<int> remaining_{0};
+
+  /**
+   * The number of ranges stolen
+   */
+  std::atomic<long> steals_{0};
+
+  /**
+   * Calls a loop body with a range. 
+   */
+  template <typename Body>
+  static void call(const void* body, int begin, int end) {
+    (*static_cast<const Body*>(body))(begin, end);
+  }
+
+  /**
+   * Runs a loop, given its body as a function and its argument. 
+   */
+  void run(int count, int grain, void (*body)(const void*, int, int), const void* context);
+
+  /**
+   * Takes a range for a thread to run, from its own deque or 
+   * another's.
+   * @return whether there was one
+   */
+  bool take(/** The thread */ int self, /** Set to the range */ Range& range) noexcept;
+
+  /**
+   * Runs ranges until there are none left to take. 
+   */
+  void work(/** The thread */ int self) noexcept;
+
+  /**
+   * What each worker thread does until stopped. 
+   */
+  void serve(/** The thread */ int self) noexcept;
+};
+
+}
+
+#endif
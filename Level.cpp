@@ -1,30 +1,316 @@
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
 #include <iostream>
+#include <map>
+#include <typeinfo>
+#include <utility>
 #include "Level.h"
 
 using namespace std;
 using namespace medieval;
 
+/**
+ * The fewest sprites a level needs before it spreads its work over
+ * the jobs, and how many sprites to hand out at once. 
+ */
+static const size_t PARALLEL = 4096;
+static const int GRAIN = 2048;
+
+/**
+ * The fewest rays cast at once that are spread over the jobs, and
+ * how many to hand out at once. 
+ */
+static const int CASTS = 512;
+static const int CAST_GRAIN = 128;
+
+/**
+ * A sprite placed in a built-in level, with the path of a fireball
+ * if it is one. Every sprite is one tile in size. 
+ */
+struct Placement {
+  int image;
+  int x;
+  int y;
+  int start;
+  int end;
+  bool left;
+};
+
+/**
+ * The sprites of the first level, other than the player. 
+ */
+static constexpr Placement LEVEL_ONE[] = {
+  {4, -50, 670, 0, 0, false},
+  {4, 0, 670, 0, 0, false},
+  {4, 50, 670, 0, 0, false},
+  {4, 100, 670, 0, 0, false},
+  {4, 150, 670, 0, 0, false},
+  {4, 200, 670, 0, 0, false},
+  {4, 150, 620, 0, 0, false},
+  {4, 150, 570, 0, 0, false},
+  {4, 350, 520, 0, 0, false},
+  {4, 400, 520, 0, 0, false},
+  {4, 450, 520, 0, 0, false},
+  {4, 350, 570, 0, 0, false},
+  {4, 400, 570, 0, 0, false},
+  {4, 450, 570, 0, 0, false},
+  {4, 350, 330, 0, 0, false},
+  {4, 400, 330, 0, 0, false},
+  {4, 450, 330, 0, 0, false},
+  {4, 600, 230, 0, 0, false},
+  {4, 650, 230, 0, 0, false},
+  {4, 700, 230, 0, 0, false},
+  {4, 750, 230, 0, 0, false},
+  {4, 800, 230, 0, 0, false},
+  {4, 850, 230, 0, 0, false},
+  {4, 900, 230, 0, 0, false},
+  {4, 950, 230, 0, 0, false},
+  {4, 1000, 230, 0, 0, false},
+  {4, 1050, 230, 0, 0, false},
+  {4, 150, 190, 0, 0, false},
+  {4, 200, 190, 0, 0, false},
+  {4, 250, 190, 0, 0, false},
+  {4, 600, 670, 0, 0, false},
+  {4, 650, 670, 0, 0, false},
+  {4, 700, 670, 0, 0, false},
+  {7, 650, 620, 0, 0, false},
+  {8, 200, 120, 0, 0, false},
+  {8, 800, 160, 0, 0, false},
+  {5, 225, 380, 225, 225, true},
+  {5, 500, 320, 500, 500, true},
+  {5, 730, 610, 730, 730, true},
+  {6, 800, 160, 600, 1000, true}
+};
+
+/**
+ * The sprites of the second level, other than the player. 
+ */
+static constexpr Placement LEVEL_TWO[] = {
+  {4, -50, 230, 0, 0, false},
+  {4, 0, 230, 0, 0, false},
+  {4, 50, 230, 0, 0, false},
+  {4, 100, 230, 0, 0, false},
+  {4, 150, 230, 0, 0, false},
+  {4, 100, 430, 0, 0, false},
+  {4, 150, 430, 0, 0, false},
+  {4, 450, 400, 0, 0, false},
+  {4, 500, 400, 0, 0, false},
+  {4, 550, 400, 0, 0, false},
+  {4, 600, 400, 0, 0, false},
+  {4, 650, 350, 0, 0, false},
+  {4, 600, 350, 0, 0, false},
+  {4, 600, 300, 0, 0, false},
+  {4, 600, 250, 0, 0, false},
+  {4, 475, 650, 0, 0, false},
+  {4, 525, 650, 0, 0, false},
+  {4, 575, 650, 0, 0, false},
+  {4, 100, 650, 0, 0, false},
+  {4, 150, 650, 0, 0, false},
+  {4, 750, 520, 0, 0, false},
+  {4, 800, 520, 0, 0, false},
+  {4, 850, 520, 0, 0, false},
+  {4, 900, 520, 0, 0, false},
+  {4, 950, 520, 0, 0, false},
+  {4, 1000, 520, 0, 0, false},
+  {4, 1050, 520, 0, 0, false},
+  {4, 1100, 520, 0, 0, false},
+  {8, 125, 370, 0, 0, false},
+  {8, 650, 280, 0, 0, false},
+  {7, 125, 590, 0, 0, false},
+  {5, 600, 180, 600, 600, true},
+  {5, 60, 370, 60, 60, true},
+  {6, 300, 190, 220, 500, true},
+  {6, 350, 620, 230, 400, false},
+  {6, 700, 280, 680, 870, true}
+};
+
+/**
+ * Get how far into a tile a coordinate is. 
+ * @return the distance, from 0 to the tile size
+ */
+static constexpr int within(int coordinate) {
+  return (coordinate % TileMap::TILE + TileMap::TILE) % TileMap::TILE;
+}
+
+/**
+ * Get whether a placement is a kind of sprite a level has, and if
+ * it is a fireball whether it starts on its path, which Balls
+ * otherwise throws on. 
+ * @return whether the placement is valid
+ */
+static constexpr bool valid(const Placement& placement) {
+  return placement.image >= 4 && placement.image <= 8 &&
+    (placement.image < 5 || placement.image > 6 ||
+     (placement.start <= placement.x && placement.x <= placement.end));
+}
+
+/**
+ * Get whether every placement in a list is valid. 
+ * @return whether they are
+ */
+static constexpr bool valid(const Placement* placements, int count) {
+  return count == 0 || (valid(*placements) && valid(placements + 1, count - 1));
+}
+
+/**
+ * Get the number of tiles in a list on a grid. 
+ * @return the number of tiles
+ */
+static constexpr int onGrid(const Placement* placements, int count, int x, int y) {
+  return count == 0 ? 0 :
+    (placements->image == 4 && within(placements->x) == x && within(placements->y) == y) +
+    onGrid(placements + 1, count - 1, x, y);
+}
+
+/**
+ * Finds the tile whose grid the most tiles in a list line up with,
+ * looking from one tile on, the earliest winning a tie. 
+ * @return the index of the tile, or best if there is none
+ */
+static constexpr int busiest(const Placement* placements, int count, int i, int best, int most) {
+  return i == count ? best :
+    placements[i].image == 4 &&
+    onGrid(placements, count, within(placements[i].x), within(placements[i].y)) > most ?
+    busiest(placements, count, i + 1, i,
+	    onGrid(placements, count, within(placements[i].x), within(placements[i].y))) :
+    busiest(placements, count, i + 1, best, most);
+}
+
+/**
+ * A built-in level, with the grid most of its platform tiles line
+ * up with worked out when compiling. 
+ */
+struct Layout {
+  const Placement* placements;
+  int count;
+  int gridX;
+  int gridY;
+};
+
+/**
+ * Lays out a built-in level. 
+ * @return the layout
+ */
+template <int N>
+static constexpr Layout layout(const Placement (&placements)[N]) {
+  return Layout{placements, N, within(placements[busiest(placements, N, 0, 0, 0)].x),
+      within(placements[busiest(placements, N, 0, 0, 0)].y)};
+}
+
+static_assert(valid(LEVEL_ONE, sizeof(LEVEL_ONE) / sizeof(Placement)),
+	      "Every sprite in level one must be a known kind, on its path if it is a fireball");
+static_assert(valid(LEVEL_TWO, sizeof(LEVEL_TWO) / sizeof(Placement)),
+	      "Every sprite in level two must be a known kind, on its path if it is a fireball");
+
+/**
+ * The built-in levels, in order. 
+ */
+static constexpr Layout LAYOUTS[] = { layout(LEVEL_ONE), layout(LEVEL_TWO) };
+
 Level::Level(int level) : level_(level) {
   player_ = make_shared<Player>(Player(10, 50));
   init();
 }
 
-vector<shared_ptr<Sprite>> Level::getList() const noexcept {
+Level::Level(int level, unsigned seed, int sprites, int threads) :
+  level_(level), seed_(seed), sprites_(sprites), threads_(threads) {
+  player_ = make_shared<Player>(Player(10, 50));
+  width_ = Generator(seed_, sprites_).getWidth();
+  init();
+}
+
+const vector<shared_ptr<Sprite>>& Level::getList() const noexcept {
   return spriteList_;
 }
 
 void Level::evolve() noexcept {
+  activate();
   
   // makes sure player knows if it's touching the ground
   // or a wall before moving them
-  player_->touchingGround(spriteList_);
+  player_->touchingGround(tiles_, nearTerrain_);
 
-  // moves all of our sprites
-  player_->touchingWall(spriteList_);
-  for (shared_ptr<Sprite>& s : spriteList_) {
-    s->move();
+  // moves all of our sprites that are awake, keeping those that move
+  // themselves in the journal first
+  player_->touchingWall(tiles_, nearTerrain_);
+  if (journal_) {
+    for (int sprite : awake_) {
+      if (activity_[sprite].kind == Kind::BALL || activity_[sprite].kind == Kind::OTHER) {
+	note(sprite);
+      }
+    }
+  }
+  if (parallel()) {
+    // every sprite only moves itself, so they can move in any order
+    jobs_->run(static_cast<int>(moving_.size()), GRAIN, [this](int begin, int end) {
+	for (int i = begin; i < end; ++i) {
+	  moving_[i]->move();
+	}
+      });
+  } else {
+    for (Sprite* s : moving_) {
+      s->move();
+    }
   }
+  size_t resumed = hazards_.getJournal().size();
+  hazards_.resume();
+  if (journal_) {
+    // the hazards kept themselves as they were before they moved
+    const vector<Hazards::Change>& changes = hazards_.getJournal();
+    for (size_t i = resumed; i < changes.size(); ++i) {
+      note(hazardSprites_[changes[i].index], changes[i].sprite);
+    }
+  }
+  ++tick_;
+  refit();
+}
+
+void Level::setJobs(Jobs* jobs) noexcept {
+  jobs_ = jobs;
+}
+
+void Level::setMasks(const Masks* masks) noexcept {
+  masks_ = masks;
+}
+
+void Level::setActivation(int radius, int viewLeft, int viewRight) noexcept {
+  radius_ = radius;
+  viewLeft_ = viewLeft;
+  viewRight_ = viewRight;
+  activate();
+}
+
+int Level::getAwake() const noexcept {
+  return static_cast<int>(awake_.size());
+}
+
+int Level::getAsleep() const noexcept {
+  return static_cast<int>(activity_.size() - awake_.size());
+}
+
+int Level::getMovers() const noexcept {
+  return static_cast<int>(count_if(activity_.begin(), activity_.end(), [](const Activity& a) {
+	return a.kind != Kind::STILL;
+      }));
+}
+
+int Level::getTick() const noexcept {
+  return tick_;
+}
+
+const TileMap& Level::getTiles() const noexcept {
+  return tiles_;
+}
+
+const Hazards& Level::getHazards() const noexcept {
+  return hazards_;
+}
+
+int Level::getNumber() const noexcept {
+  return level_;
 }
 
 weak_ptr<Player> Level::getPlayer() const noexcept {
@@ -42,22 +328,27 @@ bool Level::dead() noexcept {
 
 bool Level::damaged() noexcept {
   // player takes damage if they touch an obstacle
-  return player_->touchingObstacles(spriteList_);
+  return removeTouching(5, 6);
 }
 
 bool Level::healed() noexcept {
   // player gains health if they touch a pickup
-  return player_->touchingHealth(spriteList_);
+  return removeTouching(7, 7);
 }
 
 bool Level::scored() noexcept {
   // player scores if they touch a coin
-  return player_->touchingCoin(spriteList_);
+  return removeTouching(8, 8);
 }
 
 bool Level::next() const noexcept {
-  // player reached end if they reach right side of screen
-  return player_->getXCoordinate() > 1080;
+  // player reached end if they reach right side of screen,
+  // or the end of a generated level
+  return player_->getXCoordinate() > width_;
+}
+
+int Level::getWidth() const noexcept {
+  return width_;
 }
 
 void Level::resetPlayer() noexcept {
@@ -66,92 +357,894 @@ void Level::resetPlayer() noexcept {
   player_->setY(50);
   player_->stopV();
   player_->stopH();
-  // reinitializes all of the other sprites
-  init();
+  // puts all of the other sprites back where they started, keeping
+  // the rest of the player as it was
+  SpriteState player;
+  player_->save(player);
+  restore(start_);
+  player_->restore(player);
+  refit();
+}
+
+void Level::save(State& state) const {
+  state.sprites.resize(allSprites_.size());
+  state.present.resize(allSprites_.size());
+
+  // the sprite list is always in the same order as the sprites the
+  // level started with, so one pass finds which are still present
+  size_t current = 0;
+  for (size_t i = 0; i < allSprites_.size(); ++i) {
+    const Activity& activity = activity_[i];
+    if (activity.kind == Kind::BALL && !activity.awake && tick_ > activity.since) {
+      // saves where a fireball asleep would be now, without waking it
+      Balls ball(static_cast<const Balls&>(*allSprites_[i]));
+      ball.skip(tick_ - activity.since);
+      ball.save(state.sprites[i]);
+    } else if (activity.kind == Kind::HAZARD && !activity.awake) {
+      // and where a hazard asleep would be
+      Hazards::Frame frame;
+      hazards_.find(activity.frame, frame, state.sprites[i]);
+    } else {
+      allSprites_[i]->save(state.sprites[i]);
+    }
+    state.present[i] = current < spriteList_.size() && spriteList_[current] == allSprites_[i];
+    if (state.present[i]) {
+      ++current;
+    }
+  }
+  hazards_.save(state.hazards);
+}
+
+void Level::restore(const State& state) noexcept {
+  // puts back every sprite that was present, in its saved state,
+  // which for those asleep is where they are now, keeping in the
+  // journal only those that can have changed
+  spriteList_.clear();
+  for (size_t i = 0; i < allSprites_.size() && i < state.sprites.size(); ++i) {
+    if (activity_[i].kind != Kind::STILL || activity_[i].present != state.present[i]) {
+      note(static_cast<int>(i));
+    }
+    allSprites_[i]->restore(state.sprites[i]);
+    if (state.present[i]) {
+      spriteList_.push_back(allSprites_[i]);
+    }
+    activity_[i].since = tick_;
+    activity_[i].present = state.present[i];
+  }
+  hazards_.restore(state.hazards);
+
+  // the sprites present may have changed, so they are all looked at
+  // again
+  window_[0] = -2;
+  refit();
+}
+
+void Level::setJournal(bool journal) {
+  journal_ = journal;
+  changes_.clear();
+  if (journal) {
+    changes_.reserve(allSprites_.size());
+  }
+  hazards_.setJournal(journal);
+  clearJournal();
+}
+
+const vector<Level::Change>& Level::getJournal() const noexcept {
+  return changes_;
+}
+
+void Level::clearJournal() noexcept {
+  changes_.clear();
+  ++cleared_;
+  hazards_.clearJournal();
+  if (playerSprite_ >= 0) {
+    note(playerSprite_);
+  }
+}
+
+void Level::undo(const Change& change) noexcept {
+  // puts it back as asleep, which for a sprite awake is the same as
+  // having just fallen asleep, so that waking it again puts it back
+  // in the sprites moving
+  Activity& activity = activity_[change.sprite];
+  allSprites_[change.sprite]->restore(change.state);
+  activity.awake = false;
+  activity.since = change.since;
+  if (activity.kind == Kind::HAZARD) {
+    hazards_.sleep(activity.frame);
+  }
+  if (activity.present != change.present) {
+    activity.present = change.present;
+    relist_ = true;
+  }
+}
+
+void Level::undo(const Hazards::Change& change) noexcept {
+  hazards_.undo(change);
+}
+
+void Level::back() noexcept {
+  --tick_;
+  hazards_.back();
+
+  // only a sprite coming back or going changes the sprite list, which
+  // is then put back in order
+  if (relist_) {
+    spriteList_.clear();
+    for (size_t i = 0; i < allSprites_.size(); ++i) {
+      if (activity_[i].present) {
+	spriteList_.push_back(allSprites_[i]);
+      }
+    }
+    relist_ = false;
+  }
+
+  // the sprites put back are asleep, so those near the player wake
+  // again where they are now
+  window_[0] = -2;
+  activate();
+  refit();
+  clearJournal();
+}
+
+void Level::note(int sprite) noexcept {
+  if (journal_ && activity_[sprite].noted != cleared_) {
+    SpriteState state;
+    allSprites_[sprite]->save(state);
+    note(sprite, state);
+  }
+}
+
+void Level::note(int sprite, const SpriteState& state) noexcept {
+  Activity& activity = activity_[sprite];
+  if (!journal_ || activity.noted == cleared_) {
+    return;
+  }
+  activity.noted = cleared_;
+  Change change;
+  change.sprite = sprite;
+  change.state = state;
+  change.present = activity.present;
+  change.since = activity.awake ? tick_ : activity.since;
+  changes_.push_back(change);
 }
 
 void Level::init() noexcept {
   // Adds the sprites given the level
   spriteList_.clear();
-  if(level_ == 1) {
-    spriteList_.push_back(player_);
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, -50, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 0, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 50, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 100, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 150, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 200, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 150, 620, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 150, 570, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 350, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 400, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 450, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 350, 570, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 400, 570, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 450, 570, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 350, 330, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 400, 330, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 450, 330, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 600, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 650, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 700, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 750, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 800, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 850, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 900, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 950, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 1000, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 1050, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 150, 190, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 200, 190, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 250, 190, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 600, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 650, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 700, 670, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(7, 650, 620, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(8, 200, 120, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(8, 800, 160, 50, 50)));
-    spriteList_.push_back(make_shared<Balls>(Balls(5, 225, 380, 225, 225, true)));
-    spriteList_.push_back(make_shared<Balls>(Balls(5, 500, 320, 500, 500, true)));
-    spriteList_.push_back(make_shared<Balls>(Balls(5, 730, 610, 730, 730, true)));
-    spriteList_.push_back(make_shared<Balls>(Balls(6, 800, 160, 600, 1000, true)));
-  } else if(level_ == 2) {
+  if(sprites_ > 0) {
     spriteList_.push_back(player_);
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, -50, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 0, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 50, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 100, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 150, 230, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 100, 430, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 150, 430, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 450, 400, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 500, 400, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 550, 400, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 600, 400, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 650, 350, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 600, 350, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 600, 300, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 600, 250, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 475, 650, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 525, 650, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 575, 650, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 100, 650, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 150, 650, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 750, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 800, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 850, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 900, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 950, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 1000, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 1050, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(4, 1100, 520, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(8, 125, 370, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(8, 650, 280, 50, 50)));
-    spriteList_.push_back(make_shared<Sprite>(Sprite(7, 125, 590, 50, 50)));
-    spriteList_.push_back(make_shared<Balls>(Balls(5, 600, 180, 600, 600, true)));
-    spriteList_.push_back(make_shared<Balls>(Balls(5, 60, 370, 60, 60, true)));	
-    spriteList_.push_back(make_shared<Balls>(Balls(6, 300, 190, 220, 500, true)));
-    spriteList_.push_back(make_shared<Balls>(Balls(6, 350, 620, 230, 400, false)));
-    spriteList_.push_back(make_shared<Balls>(Balls(6, 700, 280, 680, 870, true)));
+    Generator(seed_, sprites_).generate(spriteList_, threads_);
+    buildTiles();
+  } else if(level_ >= 1 && level_ <= static_cast<int>(sizeof(LAYOUTS) / sizeof(Layout))) {
+    load();
+  } else {
+    buildTiles();
+  }
+  allSprites_ = spriteList_;
+
+  // gives every scripted hazard a frame in the pool
+  hazards_ = Hazards();
+  hazards_.reserve(count_if(allSprites_.begin(), allSprites_.end(), [](const shared_ptr<Sprite>& s) {
+	return dynamic_cast<Hazard*>(s.get()) != nullptr;
+      }));
+  hazardSprites_.clear();
+  for (size_t i = 0; i < allSprites_.size(); ++i) {
+    if (Hazard* hazard = dynamic_cast<Hazard*>(allSprites_[i].get())) {
+      hazards_.add(*hazard);
+      hazardSprites_.push_back(static_cast<int>(i));
+    }
+  }
+  playerSprite_ = static_cast<int>(find(allSprites_.begin(), allSprites_.end(), player_) - allSprites_.begin());
+  if (playerSprite_ == static_cast<int>(allSprites_.size())) {
+    playerSprite_ = -1;
+  }
+  buildRegions();
+  buildSpace();
+  activate();
+  save(start_);
+}
+
+bool Level::parallel() const noexcept {
+  return jobs_ && jobs_->getThreads() > 1 && awake_.size() >= PARALLEL;
+}
+
+bool Level::removeTouching(int image, int otherImage) noexcept {
+  activate();
+  const Player& player = *player_;
+  int found = INT_MAX;
+  if (parallel()) {
+    // each range looks for its first match, and the earliest of those
+    // is the one the player touched first, as on one thread
+    atomic<int> first(INT_MAX);
+    jobs_->run(static_cast<int>(awake_.size()), GRAIN, [&](int begin, int end) {
+	for (int i = begin; i < end && i < first.load(memory_order_relaxed); ++i) {
+	  const Sprite& s = *allSprites_[awake_[i]];
+	  if ((s.getImageIndex() == image || s.getImageIndex() == otherImage) &&
+	      activity_[awake_[i]].present && s.hits(player) && (!masks_ || masks_->hit(s, player))) {
+	    int found = first.load(memory_order_relaxed);
+	    while (i < found && !first.compare_exchange_weak(found, i, memory_order_relaxed)) {}
+	    return;
+	  }
+	}
+      });
+    found = first.load(memory_order_relaxed);
+  } else {
+    for (size_t i = 0; i < awake_.size(); ++i) {
+      const Sprite& s = *allSprites_[awake_[i]];
+      if ((s.getImageIndex() == image || s.getImageIndex() == otherImage) &&
+	  activity_[awake_[i]].present && s.hits(player) && (!masks_ || masks_->hit(s, player))) {
+	found = static_cast<int>(i);
+	break;
+      }
+    }
+  }
+  if (found == INT_MAX) {
+    return false;
+  }
+
+  // the sprites asleep can't be touching the player, so the first one
+  // awake is the first in the list
+  int sprite = awake_[found];
+  note(sprite);
+  activity_[sprite].present = false;
+  spriteList_.erase(find(spriteList_.begin(), spriteList_.end(), allSprites_[sprite]));
+  window_[0] = -2;
+  return true;
+}
+
+/**
+ * Get the region across that a distance from the left of the first
+ * region is in. The distance is wide enough that a coordinate less
+ * the origin and any radius never overflows.
+ * @return the region, or -1 if it is left of the first, and at most
+ * INT_MAX - 1 however far right it is
+ */
+static int regionOf(/** The distance */ long long x, /** The width of a region */ int width) {
+  return x < 0 ? -1 : static_cast<int>(min<long long>(x / width, INT_MAX - 1));
+}
+
+void Level::buildRegions() {
+  // finds how far each sprite can reach across, which for a fireball
+  // is its whole path and for a hazard as far as its behavior goes
+  activity_.assign(allSprites_.size(), Activity());
+  restless_.clear();
+  origin_ = INT_MAX;
+  int right = INT_MIN;
+  for (size_t i = 0; i < allSprites_.size(); ++i) {
+    const Sprite& s = *allSprites_[i];
+    Activity& activity = activity_[i];
+    activity.left = s.getXCoordinate();
+    activity.right = s.getXCoordinate() + s.getWidth();
+    activity.present = true;
+    activity.proxy = -1;
+    activity.frame = -1;
+    if (const Balls* ball = dynamic_cast<const Balls*>(&s)) {
+      activity.kind = Kind::BALL;
+      if (s.getImageIndex() == 6) {
+	// a fireball can go a step past either end before turning
+	activity.left = ball->getStart() - 5;
+	activity.right = ball->getEnd() + s.getWidth() + 5;
+      }
+    } else if (const Hazard* hazard = dynamic_cast<const Hazard*>(&s)) {
+      activity.kind = Kind::HAZARD;
+      int reach = hazard->getBehavior().getReach();
+      activity.restless = reach < 0;
+      activity.left -= reach;
+      activity.right += reach;
+    } else if (typeid(s) == typeid(Sprite)) {
+      activity.kind = Kind::STILL;
+    } else {
+      activity.kind = Kind::OTHER;
+      activity.restless = true;
+    }
+    if (activity.restless) {
+      restless_.push_back(static_cast<int>(i));
+      continue;
+    }
+    origin_ = min(origin_, activity.left);
+    right = max(right, activity.right);
+  }
+
+  // every hazard is asleep until the player is first looked for, like
+  // every other sprite
+  for (size_t frame = 0; frame < hazardSprites_.size(); ++frame) {
+    activity_[hazardSprites_[frame]].frame = static_cast<int>(frame);
+    hazards_.sleep(static_cast<int>(frame));
+  }
+
+  // counts the sprites in each region, then puts them in, with no
+  // regions at all if every sprite is restless
+  if (origin_ > right) {
+    origin_ = 0;
+  }
+  int count = origin_ <= right ? regionOf(static_cast<long long>(right) - origin_, REGION) + 1 : 0;
+  regions_.assign(count + 1, 0);
+  for (const Activity& activity : activity_) {
+    if (!activity.restless) {
+      for (int r = regionOf(static_cast<long long>(activity.left) - origin_, REGION);
+	   r <= regionOf(static_cast<long long>(activity.right) - origin_, REGION); ++r) {
+	++regions_[r + 1];
+      }
+    }
+  }
+  for (int r = 0; r < count; ++r) {
+    regions_[r + 1] += regions_[r];
+  }
+  members_.resize(regions_[count]);
+  for (size_t i = 0; i < activity_.size(); ++i) {
+    const Activity& activity = activity_[i];
+    if (!activity.restless) {
+      for (int r = regionOf(static_cast<long long>(activity.left) - origin_, REGION);
+	   r <= regionOf(static_cast<long long>(activity.right) - origin_, REGION); ++r) {
+	members_[regions_[r]++] = static_cast<int>(i);
+      }
+    }
+  }
+
+  // which leaves each region starting where the next one did
+  for (int r = count; r > 0; --r) {
+    regions_[r] = regions_[r - 1];
+  }
+  if (count > 0) {
+    regions_[0] = 0;
+  }
+
+  // nothing is awake until the player is first looked for
+  awake_.clear();
+  previous_.clear();
+  moving_.clear();
+  nearTerrain_.clear();
+  awake_.reserve(activity_.size());
+  previous_.reserve(activity_.size());
+  moving_.reserve(activity_.size());
+  nearTerrain_.reserve(terrain_.size());
+  window_[0] = -2;
+}
+
+/**
+ * Get the kind of thing a sprite is from its image. 
+ * @return the kind, from Hit, or 0 if it isn't any of them
+ */
+static unsigned kindOf(/** The index of the image */ int image) {
+  switch (image) {
+  case 2:
+  case 3:
+    return Hit::PLAYER;
+  case 4:
+    return Hit::TERRAIN;
+  case 5:
+  case 6:
+    return Hit::OBSTACLES;
+  case 7:
+    return Hit::HEALTH;
+  case 8:
+    return Hit::COINS;
+  default:
+    return 0;
+  }
+}
+
+/**
+ * Divides, rounding down rather than towards 0. 
+ */
+static int floorDivide(int a, int b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+/**
+ * Walks through the cells of a grid that a ray goes through, in the
+ * order it goes into them. 
+ */
+template <typename Visit>
+static void walk(/** Where the ray starts */ double x, double y,
+		 /** How far it goes across and down */ double dx, double dy,
+		 /** The top left of the first cell */ int left, int top,
+		 /** The size of a cell */ int size,
+		 /** Called with the column and row of each cell and the
+		     fraction of the ray it is gone into at, and returns
+		     whether to go on */
+		 Visit visit) {
+  int column = static_cast<int>(floor((x - left) / size));
+  int row = static_cast<int>(floor((y - top) / size));
+  int stepX = dx > 0 ? 1 : -1;
+  int stepY = dy > 0 ? 1 : -1;
+  double nextX = dx == 0 ? HUGE_VAL : ((dx > 0 ? column + 1 : column) * size + left - x) / dx;
+  double nextY = dy == 0 ? HUGE_VAL : ((dy > 0 ? row + 1 : row) * size + top - y) / dy;
+  double deltaX = dx == 0 ? HUGE_VAL : size / fabs(dx);
+  double deltaY = dy == 0 ? HUGE_VAL : size / fabs(dy);
+  double enter = 0;
+  while (enter <= 1 && visit(column, row, enter)) {
+    if (nextX < nextY) {
+      enter = nextX;
+      column += stepX;
+      nextX += deltaX;
+    } else {
+      enter = nextY;
+      row += stepY;
+      nextY += deltaY;
+    }
+  }
+}
+
+void Level::buildSpace() {
+  // the sprites that move go in the tree by everywhere they can
+  // reach, which they never leave, apart from those that never
+  // sleep, which go in by where they are and move in the tree
+  movers_ = BoxTree();
+  int moving = static_cast<int>(count_if(activity_.begin(), activity_.end(), [](const Activity& a) {
+	return a.kind != Kind::STILL;
+      }));
+  movers_.reserve(moving);
+  int right = INT_MIN;
+  int bottom = INT_MIN;
+  cellLeft_ = INT_MAX;
+  cellTop_ = INT_MAX;
+  for (size_t i = 0; i < activity_.size(); ++i) {
+    Activity& activity = activity_[i];
+    const Sprite& s = *allSprites_[i];
+    BoxTree::Box box = {s.getXCoordinate(), s.getYCoordinate(),
+			s.getXCoordinate() + s.getWidth(), s.getYCoordinate() + s.getHeight()};
+    if (activity.kind == Kind::STILL) {
+      cellLeft_ = min(cellLeft_, box.left);
+      cellTop_ = min(cellTop_, box.top);
+      right = max(right, box.right);
+      bottom = max(bottom, box.bottom);
+    } else if (activity.restless) {
+      activity.proxy = movers_.insert(box, static_cast<int>(i), MARGIN);
+    } else {
+      // a hazard reaches as far down as across
+      int reach = activity.kind == Kind::HAZARD ? box.left - activity.left : 0;
+      movers_.insert(BoxTree::Box{activity.left, box.top - reach, activity.right, box.bottom + reach},
+		     static_cast<int>(i), 0);
+    }
+  }
+
+  // counts the sprites that never move in each cell, then puts them
+  // in, as with the regions
+  columns_ = cellLeft_ < right ? (right - 1 - cellLeft_) / CELL + 1 : 0;
+  rows_ = cellTop_ < bottom ? (bottom - 1 - cellTop_) / CELL + 1 : 0;
+  int count = columns_ * rows_;
+  cells_.assign(count + 1, 0);
+  for (int pass = 0; pass < 2; ++pass) {
+    for (size_t i = 0; i < activity_.size(); ++i) {
+      if (activity_[i].kind != Kind::STILL) {
+	continue;
+      }
+      const Sprite& s = *allSprites_[i];
+      int firstColumn = (s.getXCoordinate() - cellLeft_) / CELL;
+      int lastColumn = (s.getXCoordinate() + s.getWidth() - 1 - cellLeft_) / CELL;
+      int firstRow = (s.getYCoordinate() - cellTop_) / CELL;
+      int lastRow = (s.getYCoordinate() + s.getHeight() - 1 - cellTop_) / CELL;
+      for (int row = firstRow; row <= lastRow; ++row) {
+	for (int column = firstColumn; column <= lastColumn; ++column) {
+	  int cell = row * columns_ + column;
+	  if (pass == 0) {
+	    ++cells_[cell + 1];
+	  } else {
+	    cellMembers_[cells_[cell]++] = static_cast<int>(i);
+	  }
+	}
+      }
+    }
+    if (pass == 0) {
+      for (int cell = 0; cell < count; ++cell) {
+	cells_[cell + 1] += cells_[cell];
+      }
+      cellMembers_.resize(cells_[count]);
+    }
+  }
+  for (int cell = count; cell > 0; --cell) {
+    cells_[cell] = cells_[cell - 1];
+  }
+  if (count > 0) {
+    cells_[0] = 0;
+  }
+}
+
+void Level::refit() noexcept {
+  for (int sprite : restless_) {
+    const Activity& activity = activity_[sprite];
+    if (activity.proxy >= 0) {
+      const Sprite& s = *allSprites_[sprite];
+      movers_.move(activity.proxy, BoxTree::Box{s.getXCoordinate(), s.getYCoordinate(),
+	    s.getXCoordinate() + s.getWidth(), s.getYCoordinate() + s.getHeight()}, MARGIN);
+    }
+  }
+}
+
+bool Level::locate(int sprite, unsigned kinds, Hit& hit) const noexcept {
+  const Activity& activity = activity_[sprite];
+  const Sprite& s = *allSprites_[sprite];
+  hit.kind = kindOf(s.getImageIndex());
+  if (!activity.present || !(hit.kind & kinds)) {
+    return false;
+  }
+  hit.sprite = &s;
+  hit.x = s.getXCoordinate();
+  hit.y = s.getYCoordinate();
+  hit.width = s.getWidth();
+  hit.height = s.getHeight();
+  if (activity.kind == Kind::BALL && !activity.awake && tick_ > activity.since) {
+    // finds where a fireball asleep would be now, without waking it
+    Balls ball(static_cast<const Balls&>(s));
+    ball.skip(tick_ - activity.since);
+    hit.x = ball.getXCoordinate();
+  } else if (activity.kind == Kind::HAZARD && !activity.awake) {
+    // and where a hazard asleep would be
+    Hazards::Frame frame;
+    SpriteState state;
+    hazards_.find(activity.frame, frame, state);
+    hit.x = state.x;
+    hit.y = state.y;
+  }
+  return true;
+}
+
+int Level::overlapping(int left, int top, int width, int height, unsigned kinds,
+		       vector<Hit>& hits) const {
+  size_t before = hits.size();
+  int right = left + width;
+  int bottom = top + height;
+  if (width <= 0 || height <= 0) {
+    return 0;
+  }
+  Hit hit;
+
+  // the tiles on the grid in the box
+  if (kinds & Hit::TERRAIN) {
+    for (int row = tiles_.getRow(top); row <= tiles_.getRow(bottom - 1); ++row) {
+      for (int column = tiles_.getColumn(left); column <= tiles_.getColumn(right - 1); ++column) {
+	if (tiles_.at(column, row)) {
+	  hit = Hit();
+	  hit.kind = Hit::TERRAIN;
+	  hit.x = tiles_.getX(column);
+	  hit.y = tiles_.getY(row);
+	  hit.width = TileMap::TILE;
+	  hit.height = TileMap::TILE;
+	  hits.push_back(hit);
+	}
+      }
+    }
+  }
+
+  // the sprites that never move in the cells the box covers, each
+  // found only in the cell where it and the box start to overlap
+  int firstColumn = max(0, floorDivide(left - cellLeft_, CELL));
+  int lastColumn = min(columns_ - 1, floorDivide(right - 1 - cellLeft_, CELL));
+  int firstRow = max(0, floorDivide(top - cellTop_, CELL));
+  int lastRow = min(rows_ - 1, floorDivide(bottom - 1 - cellTop_, CELL));
+  for (int row = firstRow; row <= lastRow; ++row) {
+    for (int column = firstColumn; column <= lastColumn; ++column) {
+      int cell = row * columns_ + column;
+      for (int i = cells_[cell]; i < cells_[cell + 1]; ++i) {
+	if (locate(cellMembers_[i], kinds, hit) && hit.x < right && hit.x + hit.width > left &&
+	    hit.y < bottom && hit.y + hit.height > top &&
+	    (max(left, hit.x) - cellLeft_) / CELL == column &&
+	    (max(top, hit.y) - cellTop_) / CELL == row) {
+	  hit.fraction = 0;
+	  hits.push_back(hit);
+	}
+      }
+    }
+  }
+
+  // and the sprites that move
+  movers_.query(BoxTree::Box{left, top, right, bottom}, [&](int sprite) {
+      if (locate(sprite, kinds, hit) && hit.x < right && hit.x + hit.width > left &&
+	  hit.y < bottom && hit.y + hit.height > top) {
+	hit.fraction = 0;
+	hits.push_back(hit);
+      }
+      return true;
+    });
+  return static_cast<int>(hits.size() - before);
+}
+
+int Level::within(int x, int y, int radius, unsigned kinds, vector<Hit>& hits) const {
+  // looks in the square around the circle, then keeps those whose
+  // nearest point is in the circle
+  size_t before = hits.size();
+  overlapping(x - radius, y - radius, 2 * radius + 1, 2 * radius + 1, kinds, hits);
+  size_t kept = before;
+  for (size_t i = before; i < hits.size(); ++i) {
+    const Hit& hit = hits[i];
+    long across = x - max(hit.x, min(x, hit.x + hit.width - 1));
+    long down = y - max(hit.y, min(y, hit.y + hit.height - 1));
+    if (across * across + down * down <= static_cast<long>(radius) * radius) {
+      hits[kept++] = hit;
+    }
+  }
+  hits.resize(kept);
+  return static_cast<int>(kept - before);
+}
+
+bool Level::raycast(int x, int y, int dx, int dy, unsigned kinds, Hit& hit) const noexcept {
+  return sweep(x, y, 0, 0, dx, dy, kinds, hit);
+}
+
+bool Level::sweep(int left, int top, int width, int height, int dx, int dy, unsigned kinds,
+		  Hit& hit) const noexcept {
+  double limit = 1;
+  bool found = false;
+  Hit candidate;
+
+  // tries something against the nearest so far
+  auto test = [&](const Hit& h) {
+    double enter;
+    if (BoxTree::crosses(BoxTree::Box{h.x, h.y, h.x + h.width, h.y + h.height},
+			 left, top, dx, dy, width, height, limit, enter)) {
+      hit = h;
+      hit.fraction = enter;
+      limit = enter;
+      found = true;
+    }
+  };
+
+  // a ray walks through the cells it goes into, stopping at the
+  // first tile and once past the nearest sprite, while a box looks
+  // at every cell around where it goes
+  if (width == 0 && height == 0) {
+    if (kinds & Hit::TERRAIN) {
+      walk(left, top, dx, dy, tiles_.getX(0), tiles_.getY(0), TileMap::TILE,
+	   [&](int column, int row, double) {
+	     if (!tiles_.at(column, row)) {
+	       return true;
+	     }
+	     candidate = Hit();
+	     candidate.kind = Hit::TERRAIN;
+	     candidate.x = tiles_.getX(column);
+	     candidate.y = tiles_.getY(row);
+	     candidate.width = TileMap::TILE;
+	     candidate.height = TileMap::TILE;
+	     test(candidate);
+	     return !found;
+	   });
+    }
+    walk(left, top, dx, dy, cellLeft_, cellTop_, CELL, [&](int column, int row, double enter) {
+	if (enter >= limit) {
+	  return false;
+	}
+	if (column >= 0 && column < columns_ && row >= 0 && row < rows_) {
+	  int cell = row * columns_ + column;
+	  for (int i = cells_[cell]; i < cells_[cell + 1]; ++i) {
+	    if (locate(cellMembers_[i], kinds, candidate)) {
+	      test(candidate);
+	    }
+	  }
+	}
+	return true;
+      });
+  } else {
+    int right = max(left, left + dx) + width;
+    int bottom = max(top, top + dy) + height;
+    int boxLeft = min(left, left + dx);
+    int boxTop = min(top, top + dy);
+    if (kinds & Hit::TERRAIN) {
+      for (int row = tiles_.getRow(boxTop); row <= tiles_.getRow(bottom - 1); ++row) {
+	for (int column = tiles_.getColumn(boxLeft); column <= tiles_.getColumn(right - 1); ++column) {
+	  if (tiles_.at(column, row)) {
+	    candidate = Hit();
+	    candidate.kind = Hit::TERRAIN;
+	    candidate.x = tiles_.getX(column);
+	    candidate.y = tiles_.getY(row);
+	    candidate.width = TileMap::TILE;
+	    candidate.height = TileMap::TILE;
+	    test(candidate);
+	  }
+	}
+      }
+    }
+    int firstColumn = max(0, floorDivide(boxLeft - cellLeft_, CELL));
+    int lastColumn = min(columns_ - 1, floorDivide(right - 1 - cellLeft_, CELL));
+    int firstRow = max(0, floorDivide(boxTop - cellTop_, CELL));
+    int lastRow = min(rows_ - 1, floorDivide(bottom - 1 - cellTop_, CELL));
+    for (int row = firstRow; row <= lastRow; ++row) {
+      for (int column = firstColumn; column <= lastColumn; ++column) {
+	int cell = row * columns_ + column;
+	for (int i = cells_[cell]; i < cells_[cell + 1]; ++i) {
+	  if (locate(cellMembers_[i], kinds, candidate)) {
+	    test(candidate);
+	  }
+	}
+      }
+    }
+  }
+
+  // then the sprites that move, no further than the nearest so far
+  movers_.sweep(left, top, dx, dy, width, height, limit, [&](int sprite, double) {
+      if (locate(sprite, kinds, candidate)) {
+	test(candidate);
+      }
+      return limit;
+    });
+  return found;
+}
+
+void Level::cast(const Ray* rays, int count, Hit* hits) const noexcept {
+  auto castRange = [=](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      const Ray& ray = rays[i];
+      hits[i] = Hit();
+      sweep(ray.x, ray.y, ray.width, ray.height, ray.dx, ray.dy, ray.kinds, hits[i]);
+    }
+  };
+  if (jobs_ && jobs_->getThreads() > 1 && count >= CASTS) {
+    // every ray only reads the level, so they can be cast in any order
+    jobs_->run(count, CAST_GRAIN, castRange);
+  } else {
+    castRange(0, count);
+  }
+}
+
+void Level::activate() noexcept {
+  // finds the regions around the player and the view, which are all
+  // of them if nothing sleeps
+  int last = static_cast<int>(regions_.size()) - 2;
+  int window[4] = {0, last, 0, -1};
+  if (radius_ >= 0) {
+    long long left = player_->getXCoordinate();
+    long long right = left + player_->getWidth();
+    window[0] = max(0, regionOf(left - radius_ - origin_, REGION));
+    window[1] = min(last, regionOf(right + radius_ - origin_, REGION));
+    window[2] = max(0, regionOf(static_cast<long long>(viewLeft_) - origin_, REGION));
+    window[3] = min(last, regionOf(static_cast<long long>(viewRight_) - origin_, REGION));
+  }
+  if (equal(window, window + 4, window_)) {
+    return;
+  }
+  copy(window, window + 4, window_);
+
+  // gathers the sprites in them, and those that never sleep
+  awake_.swap(previous_);
+  awake_.clear();
+  ++stamp_;
+  gather(window[0], window[1]);
+  gather(window[2], window[3]);
+  for (int sprite : restless_) {
+    if (activity_[sprite].present) {
+      activity_[sprite].stamp = stamp_;
+      awake_.push_back(sprite);
+    }
+  }
+  sort(awake_.begin(), awake_.end());
+
+  // those no longer awake fall asleep where they are
+  for (int sprite : previous_) {
+    Activity& activity = activity_[sprite];
+    if (activity.stamp != stamp_ && activity.awake) {
+      activity.awake = false;
+      activity.since = tick_;
+      if (activity.kind == Kind::HAZARD) {
+	hazards_.sleep(activity.frame);
+      }
+    }
+  }
+
+  // and those waking move on to wherever they would be now
+  moving_.clear();
+  nearTerrain_.clear();
+  for (int sprite : awake_) {
+    Activity& activity = activity_[sprite];
+    Sprite* s = allSprites_[sprite].get();
+    if (!activity.awake) {
+      if (activity.kind == Kind::BALL && tick_ > activity.since) {
+	note(sprite);
+	static_cast<Balls*>(s)->skip(tick_ - activity.since);
+      } else if (activity.kind == Kind::HAZARD) {
+	// a hazard moved on keeps itself as it was in the hazards'
+	// journal, which the level's journal takes the sprite from
+	size_t noted = hazards_.getJournal().size();
+	hazards_.wake(activity.frame);
+	if (hazards_.getJournal().size() > noted) {
+	  note(sprite, hazards_.getJournal().back().sprite);
+	}
+      }
+      activity.awake = true;
+    }
+    if (activity.kind == Kind::BALL || activity.kind == Kind::OTHER) {
+      moving_.push_back(s);
+    } else if (activity.kind == Kind::STILL && s->getImageIndex() == 4) {
+      // every platform tile still in the sprite list is off the grid
+      nearTerrain_.push_back(allSprites_[sprite]);
+    }
+  }
+}
+
+void Level::gather(int first, int last) noexcept {
+  for (int r = first; r <= last; ++r) {
+    for (int i = regions_[r]; i < regions_[r + 1]; ++i) {
+      int sprite = members_[i];
+      if (activity_[sprite].stamp != stamp_ && activity_[sprite].present) {
+	activity_[sprite].stamp = stamp_;
+	awake_.push_back(sprite);
+      }
+    }
+  }
+}
+
+void Level::load() {
+  const Layout& layout = LAYOUTS[level_ - 1];
+
+  // the platform tiles on the level's grid go straight into the
+  // tile map
+  vector<pair<int, int>> tiles;
+  tiles.reserve(layout.count);
+  int others = 0;
+  int balls = 0;
+  for (int i = 0; i < layout.count; ++i) {
+    const Placement& p = layout.placements[i];
+    if (p.image == 4 && ::within(p.x) == layout.gridX && ::within(p.y) == layout.gridY) {
+      tiles.push_back(make_pair(p.x, p.y));
+    } else if (p.image == 5 || p.image == 6) {
+      ++balls;
+    } else {
+      ++others;
+    }
+  }
+  tiles_ = TileMap(layout.gridX, layout.gridY, tiles);
+
+  // the rest are made in one block, which each sprite shares, rather
+  // than one at a time. Room is made for them all first so that they
+  // never move
+  struct Block {
+    vector<Sprite> sprites;
+    vector<Balls> balls;
+  };
+  shared_ptr<Block> block = make_shared<Block>();
+  block->sprites.reserve(others);
+  block->balls.reserve(balls);
+  spriteList_.reserve(others + balls + 1);
+  spriteList_.push_back(player_);
+  terrain_.clear();
+  for (int i = 0; i < layout.count; ++i) {
+    const Placement& p = layout.placements[i];
+    if (p.image == 4 && ::within(p.x) == layout.gridX && ::within(p.y) == layout.gridY) {
+      continue;
+    }
+    if (p.image == 5 || p.image == 6) {
+      block->balls.emplace_back(p.image, p.x, p.y, p.start, p.end, p.left);
+      spriteList_.push_back(shared_ptr<Sprite>(block, &block->balls.back()));
+    } else {
+      block->sprites.emplace_back(p.image, p.x, p.y, 50, 50);
+      spriteList_.push_back(shared_ptr<Sprite>(block, &block->sprites.back()));
+      if (p.image == 4) {
+	terrain_.push_back(spriteList_.back());
+      }
+    }
+  }
+}
+
+void Level::buildTiles() {
+  // finds the grid that most of the platform tiles line up with
+  map<pair<int, int>, int> grids;
+  pair<int, int> grid(0, 0);
+  for (const shared_ptr<Sprite>& s : spriteList_) {
+    if (s->getImageIndex() == 4 && s->getWidth() == TileMap::TILE && s->getHeight() == TileMap::TILE) {
+      pair<int, int> offset((s->getXCoordinate() % TileMap::TILE + TileMap::TILE) % TileMap::TILE,
+			    (s->getYCoordinate() % TileMap::TILE + TileMap::TILE) % TileMap::TILE);
+      if (++grids[offset] > grids[grid]) {
+	grid = offset;
+      }
+    }
+  }
+
+  // moves those into the tile map, and keeps the rest as sprites
+  vector<pair<int, int>> tiles;
+  vector<shared_ptr<Sprite>> sprites;
+  terrain_.clear();
+  for (shared_ptr<Sprite>& s : spriteList_) {
+    if (s->getImageIndex() != 4) {
+      sprites.push_back(move(s));
+    } else if (s->getWidth() == TileMap::TILE && s->getHeight() == TileMap::TILE &&
+	       (s->getXCoordinate() - grid.first) % TileMap::TILE == 0 &&
+	       (s->getYCoordinate() - grid.second) % TileMap::TILE == 0) {
+      tiles.push_back(make_pair(s->getXCoordinate(), s->getYCoordinate()));
+    } else {
+      terrain_.push_back(s);
+      sprites.push_back(move(s));
+    }
   }
+  spriteList_.swap(sprites);
+  tiles_ = TileMap(grid.first, grid.second, tiles);
 }
@@ -6,6 +6,13 @@
 #include "Sprite.h"
 #include "Player.h"
 #include "Balls.h"
+#include "BoxTree.h"
+#include "Generator.h"
+#include "Hazards.h"
+#include "Hit.h"
+#include "Jobs.h"
+#include "Masks.h"
+#include "TileMap.h"
 
 namespace medieval {
 
@@ -22,24 +29,213 @@ namespace medieval {
   
 class Level {
 public:
+
+  /**
+   * The state of every sprite in a level at one moment, which can 
+   * be saved and later restored. Saving into the same state again 
+   * reuses its storage. 
+   */
+  struct State {
+    /** The state of each sprite the level started with */
+    std::vector<SpriteState> sprites;
+    /** Whether each of those sprites is still in the level */
+    std::vector<bool> present;
+    /** Where each scripted hazard is in its behavior */
+    std::vector<Hazards::Frame> hazards;
+  };
+
+  /**
+   * A sprite as it was before a tick changed it, kept in the journal.
+   */
+  struct Change {
+    /** Its index in the level's state */
+    int sprite;
+    /** Its state */
+    SpriteState state;
+    /** Whether it was in the level */
+    bool present;
+    /** The tick it was asleep since, which for a fireball asleep is
+	the tick its state is of, or the tick it changed on */
+    int since;
+  };
   
   /**
    * Construct a level based on the current level. 
    */
   Level(/** The current level */
         int level);
+
+  /**
+   * Construct a generated level. 
+   */
+  Level(/** The level number */
+	int level,
+	/** The seed to generate the level from */
+	unsigned seed,
+	/** Roughly how many sprites the level should have */
+	int sprites,
+	/** The number of threads to generate it with */
+	int threads = 1);
     
   /**
    * Evolve a collection of sprites. This makes them move
-   * to their new locations. 
+   * to their new locations, and resumes the behaviors of the
+   * scripted hazards that are due. 
    */
   void evolve() noexcept;
 
+  /**
+   * Spread moving the sprites, and checking what the player touches,
+   * over a job system's threads once there are enough sprites for 
+   * it to help. The results are the same as on one thread. 
+   */
+  void setJobs(/** The job system, which must outlive the level, or
+		   nullptr to use one thread */
+	       Jobs* jobs) noexcept;
+
+  /**
+   * Checks the sprites whose boxes touch the player against their
+   * collision masks, so that only the solid parts of their images
+   * hurt, heal or score. 
+   */
+  void setMasks(/** The masks, which must outlive the level, or
+		    nullptr to check the boxes alone */
+		const Masks* masks) noexcept;
+
+  /**
+   * Sets which sprites stay awake. Only the sprites that could reach
+   * somewhere within a distance either side of the player, or the
+   * view, are moved or checked against the player, and the rest
+   * sleep until the player comes near, when they are moved on to
+   * wherever they would have got to. The results are the same
+   * either way. 
+   */
+  void setActivation(/** How far either side of the player sprites
+			 stay awake, or a negative number to keep every
+			 sprite awake */
+		     int radius,
+		     /** The x coordinates of the left and right of the
+			 view, which always stays awake */
+		     int viewLeft = 0, int viewRight = 1080) noexcept;
+
+  /**
+   * Get the number of sprites awake, including the player.
+   * @return the number of sprites
+   */
+  int getAwake() const noexcept;
+
+  /**
+   * Get the number of sprites asleep.
+   * @return the number of sprites
+   */
+  int getAsleep() const noexcept;
+
+  /**
+   * Get the number of sprites that can move, including the player,
+   * which is as many as going back to the start can change.
+   * @return the number of sprites
+   */
+  int getMovers() const noexcept;
+
+  /**
+   * Get the number of ticks the level has evolved.
+   * @return the number of ticks
+   */
+  int getTick() const noexcept;
+
+  /**
+   * Finds everything of some kinds that overlaps a box. 
+   * @return the number found, which are added to the hits
+   */
+  int overlapping(/** The top left of the box */
+		  int left, int top,
+		  /** The size of the box */
+		  int width, int height,
+		  /** The kinds of thing to look for, from Hit */
+		  unsigned kinds,
+		  /** What was found */
+		  std::vector<Hit>& hits) const;
+
+  /**
+   * Finds everything of some kinds with some part of it within a
+   * distance of a point. 
+   * @return the number found, which are added to the hits
+   */
+  int within(/** The point */
+	     int x, int y,
+	     /** The distance */
+	     int radius,
+	     /** The kinds of thing to look for, from Hit */
+	     unsigned kinds,
+	     /** What was found */
+	     std::vector<Hit>& hits) const;
+
+  /**
+   * Finds the first thing of some kinds a ray goes into, passing
+   * along the edges of things without going into them. 
+   * @return whether there was one
+   */
+  bool raycast(/** Where the ray starts */
+	       int x, int y,
+	       /** How far it goes across and down */
+	       int dx, int dy,
+	       /** The kinds of thing to look for, from Hit */
+	       unsigned kinds,
+	       /** Set to what was hit, if anything */
+	       Hit& hit) const noexcept;
+
+  /**
+   * Finds the first thing of some kinds a box moving along a line
+   * would overlap, in the same way as sprites hit each other. 
+   * @return whether there was one
+   */
+  bool sweep(/** The top left of the box */
+	     int left, int top,
+	     /** The size of the box */
+	     int width, int height,
+	     /** How far it moves across and down */
+	     int dx, int dy,
+	     /** The kinds of thing to look for, from Hit */
+	     unsigned kinds,
+	     /** Set to what was hit, if anything */
+	     Hit& hit) const noexcept;
+
+  /**
+   * Casts many rays or sweeps at once, spread over the job system's
+   * threads if there are enough of them. 
+   */
+  void cast(/** The rays */
+	    const Ray* rays,
+	    /** The number of rays */
+	    int count,
+	    /** Set to what each ray hit, with a kind of 0 if nothing */
+	    Hit* hits) const noexcept;
+
   /**
    * Get the list of sprites.
-   * @return the list of sprites.
+   * @return the list of sprites, which is only valid until the 
+   * level next changes
+   */
+  const std::vector<std::shared_ptr<Sprite>>& getList() const noexcept;
+
+  /**
+   * Get the platform tiles that are on the level's grid, which are
+   * not in the list of sprites.
+   * @return the tiles
+   */
+  const TileMap& getTiles() const noexcept;
+
+  /**
+   * Get the scripted hazards.
+   * @return the hazards
+   */
+  const Hazards& getHazards() const noexcept;
+
+  /**
+   * Get the level number
+   * @return the level number
    */
-  std::vector<std::shared_ptr<Sprite>> getList() const noexcept;
+  int getNumber() const noexcept;
 
   /**
    * Get the player sprite
@@ -77,11 +273,76 @@ public:
    */
   bool next() const noexcept;
 
+  /**
+   * Get the x coordinate the player must pass to reach the end
+   * @return the x coordinate of the end
+   */
+  int getWidth() const noexcept;
+
   /**
    * Resets the position of the player and all other sprites in the 
    * level to their starting position. 
    */
   void resetPlayer() noexcept;
+
+  /**
+   * Saves the state of the level. 
+   */
+  void save(/** Where to save the state */
+	    State& state) const;
+
+  /**
+   * Restores a state previously saved from this level. 
+   */
+  void restore(/** The state to restore */
+	       const State& state) noexcept;
+
+  /**
+   * Starts keeping a journal of every sprite and scripted hazard each
+   * tick changes, as it was before the tick, or stops. The sprites
+   * changed are those the level moves, wakes, takes away or restores,
+   * and the player, whatever changes it, so keeping the journal costs
+   * as much as the sprites awake rather than the whole level. Makes
+   * room for every sprite, so that keeping it doesn't allocate.
+   */
+  void setJournal(/** Whether to keep the journal */
+		  bool journal);
+
+  /**
+   * Get the sprites changed since the journal was last cleared, each
+   * as it was the first time it changed. The scripted hazards are in 
+   * the hazards' own journal.
+   * @return the changes, in the order they were made
+   */
+  const std::vector<Change>& getJournal() const noexcept;
+
+  /**
+   * Clears the journal, keeping the player as it is now, since it can
+   * change between ticks as well as in them. 
+   */
+  void clearJournal() noexcept;
+
+  /**
+   * Puts a sprite back as it was in a change from the journal. Once
+   * every change of the last tick is put back, along with those of 
+   * the hazards, back must be called.
+   */
+  void undo(/** The change */
+	    const Change& change) noexcept;
+
+  /**
+   * Puts a scripted hazard back as it was in a change from the
+   * hazards' journal.
+   */
+  void undo(/** The change */
+	    const Hazards::Change& change) noexcept;
+
+  /**
+   * Goes back to the tick before, once everything it changed is put
+   * back, so that the fireballs asleep are back where they were too,
+   * and clears the journal.
+   */
+  void back() noexcept;
   
 private:
 
@@ -95,15 +356,316 @@ private:
    */
   std::vector<std::shared_ptr<Sprite>> spriteList_;
 
+  /** 
+   * Every sprite the level started with, including those that have
+   * since been removed, in the same order as the sprite list. 
+   */
+  std::vector<std::shared_ptr<Sprite>> allSprites_;
+
+  /**
+   * The state the level started in, which resetting goes back to
+   * without creating the sprites again
+   */
+  State start_;
+
+  /**
+   * The platform tiles that line up with the level's grid
+   */
+  TileMap tiles_;
+
+  /**
+   * The platform tiles that don't, which are also in the sprite list
+   */
+  std::vector<std::shared_ptr<Sprite>> terrain_;
+
+  /**
+   * The sprites that follow a behavior, which are also in the
+   * sprite list
+   */
+  Hazards hazards_;
+
+  /**
+   * How a sprite takes part in the level while it is awake. 
+   */
+  enum class Kind {
+    /** It never moves. */ STILL,
+    /** It is a fireball, which can skip the ticks it slept. */ BALL,
+    /** It is moved by the hazards, which move it on past the ticks
+	it slept when it wakes. */ HAZARD,
+    /** It moves itself some other way, like the player, so it
+	never sleeps. */ OTHER
+  };
+
+  /**
+   * Whether a sprite is awake, and where it can reach
+   */
+  struct Activity {
+    /** How it takes part */
+    Kind kind;
+    /** The left and right of everywhere it can reach */
+    int left;
+    int right;
+    /** Whether there's no telling where it can reach, so it never
+	sleeps */
+    bool restless;
+    /** The tick it fell asleep on */
+    int since;
+    /** The last time the sprites awake were found that it was */
+    unsigned stamp;
+    /** Whether it is awake */
+    bool awake;
+    /** Whether it is still in the sprite list */
+    bool present;
+    /** Its proxy in the tree of moving sprites, or -1 */
+    int proxy;
+    /** Its frame among the scripted hazards, or -1 */
+    int frame;
+    /** The number of times the journal was cleared when it was last
+	kept in it */
+    unsigned noted;
+  };
+
+  /**
+   * The width of a region the level is cut into across
+   */
+  static const int REGION = 256;
+
+  /**
+   * Every sprite the level started with, in the same order
+   */
+  std::vector<Activity> activity_;
+
+  /**
+   * The sprites that can reach somewhere in each region, one region
+   * after another, and where each region starts in them
+   */
+  std::vector<int> members_;
+  std::vector<int> regions_;
+
+  /**
+   * The x coordinate of the left of the first region
+   */
+  int origin_ = 0;
+
+  /**
+   * The width and height of the cells the sprites that never move
+   * are sorted into for the queries, and how far the sprites that
+   * never sleep move before going elsewhere in the tree
+   */
+  static const int CELL = 100;
+  static const int MARGIN = 32;
+
+  /**
+   * The sprites that never move in each cell, one cell after
+   * another, and where each cell starts in them
+   */
+  std::vector<int> cellMembers_;
+  std::vector<int> cells_;
+
+  /**
+   * The top left of the first cell, and the number of cells across
+   * and down
+   */
+  int cellLeft_ = 0;
+  int cellTop_ = 0;
+  int columns_ = 0;
+  int rows_ = 0;
+
+  /**
+   * Every sprite that moves, by everywhere it can reach, or for
+   * those that never sleep where they are now
+   */
+  BoxTree movers_;
+
+  /**
+   * The sprites that never sleep
+   */
+  std::vector<int> restless_;
+
+  /**
+   * The sprites awake, in the same order as the sprite list, and
+   * those that were before they were last found
+   */
+  std::vector<int> awake_;
+  std::vector<int> previous_;
+
+  /**
+   * The sprites awake that move themselves
+   */
+  std::vector<Sprite*> moving_;
+
+  /**
+   * The platform tiles off the grid that are awake
+   */
+  std::vector<std::shared_ptr<Sprite>> nearTerrain_;
+
+  /**
+   * The regions around the player and the view that were awake,
+   * first and last, or none yet
+   */
+  int window_[4] = {-1, -1, -1, -1};
+
+  /**
+   * Counts the times the sprites awake are found
+   */
+  unsigned stamp_ = 0;
+
+  /**
+   * How far either side of the player sprites stay awake, or a
+   * negative number for every sprite
+   */
+  int radius_ = 1080;
+
+  /**
+   * The left and right of the view
+   */
+  int viewLeft_ = 0;
+  int viewRight_ = 1080;
+
+  /**
+   * The number of ticks the level has evolved
+   */
+  int tick_ = 0;
+
+  /**
+   * Whether to keep the journal, the journal, and the number of times
+   * it has been cleared
+   */
+  bool journal_ = false;
+  std::vector<Change> changes_;
+  unsigned cleared_ = 1;
+
+  /**
+   * The sprite of each scripted hazard, in the order of their frames,
+   * and the player's, or -1
+   */
+  std::vector<int> hazardSprites_;
+  int playerSprite_ = -1;
+
+  /**
+   * Whether a sprite put back from the journal came back or went
+   */
+  bool relist_ = false;
+
+  /**
+   * The job system to spread the work over, if any
+   */
+  Jobs* jobs_ = nullptr;
+
+  /**
+   * The collision masks to check, if any
+   */
+  const Masks* masks_ = nullptr;
+
   /**
    * The level number
    */
   int level_;
 
+  /**
+   * The seed and rough number of sprites of a generated level, 
+   * which has no sprites if it is not generated
+   */
+  unsigned seed_ = 0;
+  int sprites_ = 0;
+
+  /**
+   * The number of threads to generate the level with
+   */
+  int threads_ = 1;
+
+  /**
+   * The x coordinate the player must pass to reach the end
+   */
+  int width_ = 1080;
+
   /**
    * Adds all the sprites needed for this level to the sprite list. 
    */
   void init() noexcept;
+
+  /**
+   * Get whether the level is big enough to spread over the jobs.
+   * @return whether to use the jobs
+   */
+  bool parallel() const noexcept;
+
+  /**
+   * Keeps a sprite in the journal as it is now, unless it already is
+   * or there is no journal.
+   */
+  void note(/** The sprite */
+	    int sprite) noexcept;
+
+  /**
+   * Keeps a sprite in the journal as it was in a state, unless it 
+   * already is or there is no journal.
+   */
+  void note(/** The sprite */
+	    int sprite,
+	    /** Its state */
+	    const SpriteState& state) noexcept;
+
+  /**
+   * Sorts the sprites into the regions they can reach. 
+   */
+  void buildRegions();
+
+  /**
+   * Sorts the sprites that never move into cells and the rest into
+   * the tree, for the queries. 
+   */
+  void buildSpace();
+
+  /**
+   * Moves the sprites that never sleep in the tree. 
+   */
+  void refit() noexcept;
+
+  /**
+   * Finds where a sprite is now, even if it is asleep. 
+   * @return whether it is present and one of the kinds
+   */
+  bool locate(/** The sprite */
+	      int sprite,
+	      /** The kinds of thing to look for */
+	      unsigned kinds,
+	      /** Set to the sprite and where it is */
+	      Hit& hit) const noexcept;
+
+  /**
+   * Wakes the sprites that could reach near the player or the view,
+   * moving on those that slept, and puts the rest to sleep. 
+   */
+  void activate() noexcept;
+
+  /**
+   * Adds the sprites in some regions to those awake, unless they
+   * already are. 
+   */
+  void gather(/** The first and last region */
+	      int first, int last) noexcept;
+
+  /**
+   * Removes the first sprite awake with one of two images that the
+   * player is touching, searching on every thread if there are
+   * enough awake.
+   * @return whether there was one
+   */
+  bool removeTouching(/** The images */
+		      int image, int otherImage) noexcept;
+
+  /**
+   * Adds the sprites of the built-in level to the sprite list, and
+   * its platform tiles on its grid to the tile map. 
+   */
+  void load();
+
+  /**
+   * Moves the platform tiles on the most common grid out of the 
+   * sprite list and into the tile map. 
+   */
+  void buildTiles();
 };
 
 }
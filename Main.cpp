@@ -1,3 +1,5 @@
+#include <chrono>
+#include <ctime>
 #include "World.h"
 
 using namespace std;
@@ -12,18 +14,212 @@ using namespace medieval;
  * @author Alexander Zilbersher
  */
 
+/**
+ * Queues a key event as though the user had pressed or released 
+ * a key. Used to drive the game when there is no one to play it. 
+ */
+static void pushKey(/** SDL_KEYDOWN or SDL_KEYUP */
+		    Uint32 type,
+		    /** The key */
+		    SDL_Keycode key) {
+  SDL_Event event = {};
+  event.type = type;
+  event.key.keysym.sym = key;
+  SDL_PushEvent(&event);
+}
+
+/**
+ * Pretends something happened to the window. 
+ */
+static void pushWindow(/** What happened, such as SDL_WINDOWEVENT_FOCUS_LOST */
+		       Uint8 what) {
+  SDL_Event event = {};
+  event.type = SDL_WINDOWEVENT;
+  event.window.event = what;
+  SDL_PushEvent(&event);
+}
+
+/**
+ * Get the number of allocations made during the last frame. 
+ */
+static long allocations(const World& world) {
+  long total = 0;
+  for (int phase = 0; phase < static_cast<int>(FramePhase::COUNT); ++phase) {
+    total += world.getAllocations(static_cast<FramePhase>(phase));
+  }
+  return total;
+}
+
+/**
+ * Prints how a race went. 
+ */
+static void report(/** The local side of the race */
+		   const Rollback& race) {
+  cerr << "Rollbacks: " << race.getRollbacks()
+       << ", deepest: " << race.getMaxRollbackDepth() << " ticks"
+       << ", slowest resimulation: " << race.getMaxResimulationTime() << " ms"
+       << ", stalled ticks: " << race.getStalls()
+       << (race.desynced() ? ", out of sync" : "") << endl;
+}
+
+/**
+ * Finishes writing a capture and prints how it went. 
+ */
+static void report(/** The capture */
+		   Capture& capture) {
+  capture.close();
+  cerr << "Captured " << capture.getWritten() << " frames, dropped "
+       << capture.getDropped() << (capture.failed() ? ", failed to write them all" : "") << endl;
+}
+
+/**
+ * Finishes writing analytics and prints how it went. 
+ */
+static void report(/** The analytics */
+		   Analytics& analytics) {
+  analytics.close();
+  cerr << analytics.getWritten() << " analytics records written, " << analytics.getDropped()
+       << " dropped" << (analytics.failed() ? ", failed to write them all" : "") << endl;
+}
+
+/**
+ * Runs the game for a while, waiting for events whenever the world
+ * is idle, and measures how busy it kept the processor. 
+ * @return the percentage of one core used, or -1 if the game was quit
+ */
+static double run(/** The world */
+		  World& world,
+		  /** The seconds to run for */
+		  double seconds) {
+  clock_t cpu = clock();
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  double elapsed = 0;
+  while (elapsed < seconds) {
+    int wait = world.getIdleWait();
+    if (wait > 0) {
+      SDL_WaitEventTimeout(nullptr, min(wait, static_cast<int>((seconds - elapsed) * 1000) + 1));
+    }
+    if (world.checkForRelevantEvent() == RelevantEvent::QUIT) {
+      return -1;
+    }
+    world.refresh();
+    elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+  return 100.0 * (clock() - cpu) / CLOCKS_PER_SEC / elapsed;
+}
+
+/**
+ * Runs the game for a while drawing every frame, then for as long
+ * again idling, and prints how much of a core each used. 
+ * @return false if the game was quit
+ */
+static bool compare(/** The world */
+		    World& world,
+		    /** What is on screen */
+		    const char* what,
+		    /** The seconds to run each way for */
+		    double seconds) {
+  world.setIdling(false);
+  int frames = world.getFrameCount();
+  double busy = run(world, seconds);
+  int busyFrames = world.getFrameCount() - frames;
+  world.setIdling(true);
+  frames = world.getFrameCount();
+  int skipped = world.getIdleFrames();
+  double idle = busy < 0 ? -1 : run(world, seconds);
+  if (idle < 0) {
+    return false;
+  }
+  cout << what << " for " << seconds << " seconds: " << busy << "% of a core drawing "
+       << busyFrames << " frames, " << idle << "% idling with " << world.getFrameCount() - frames
+       << " frames drawn and " << world.getIdleFrames() - skipped << " refreshes skipped" << endl;
+  return true;
+}
+
 /**
  * The main program for our task. This adds all of our images
  * and creates our world. It checks for relevant events to exit. 
+ * Run as "main --offscreen frames [scale]" it instead plays the 
+ * given number of frames without a display, drawing levels at the
+ * given fraction of the resolution, and prints a hash of each 
+ * frame and the frame rate. Run as "main --race player port host
+ * hostPort [delay loss]" it races another machine, optionally 
+ * delaying outgoing packets by the given milliseconds and dropping
+ * the given percentage of them. Starting with "--capture path" 
+ * also records every frame to the path, or the standard output if
+ * it is "-", as Y4M video if it ends in ".y4m" and raw RGBA frames
+ * otherwise. Offscreen no frame is dropped. Starting with 
+ * "--telemetry name" shares how the game is running through the 
+ * named shared memory segment, for tools/Monitor to watch, and 
+ * with "--textures megabytes" keeps images no screen needs loaded
+ * within that many megabytes rather than World::TEXTURE_BUDGET, and
+ * with "--analytics path" records where the player goes, gets hurt
+ * and dies to the path, for tools/Heatmap. Run as "main --idle 
+ * seconds" it sits on the title screen for the given seconds drawing
+ * every frame, then for as long again idling, and prints how much of
+ * a core each used, then does the same with the first level paused
+ * by the window losing the keyboard and then by it being minimized.
  * @return the exit status. Normal status is 0. 
  */
 
-int main() {
+int main(int argc, char* argv[]) {
   try {
 
+    // Check whether to capture the frames, share telemetry, change
+    // the texture budget or record analytics, and whether to render
+    // offscreen or race
+
+    string program = argv[0];
+    string capturePath;
+    string telemetryName;
+    string analyticsPath;
+    double textureBudget = -1;
+    for (;;) {
+      string prefix = argc > 2 ? argv[1] : "";
+      if (prefix == "--capture") {
+	capturePath = argv[2];
+      } else if (prefix == "--telemetry") {
+	telemetryName = argv[2];
+      } else if (prefix == "--textures") {
+	textureBudget = stod(argv[2]);
+      } else if (prefix == "--analytics") {
+	analyticsPath = argv[2];
+      } else {
+	break;
+      }
+      argc -= 2;
+      argv += 2;
+    }
+    RenderMode mode = RenderMode::WINDOW;
+    int frames = 0;
+    unique_ptr<Rollback> race;
+    string option = argc > 1 ? argv[1] : "";
+    bool checkAllocations = false;
+    double scale = 1;
+    double idleSeconds = 0;
+    if ((argc == 3 && (option == "--offscreen" || option == "--allocations")) ||
+	(argc == 4 && option == "--offscreen")) {
+      mode = RenderMode::OFFSCREEN;
+      frames = stoi(argv[2]);
+      checkAllocations = option == "--allocations";
+      scale = argc == 4 ? stod(argv[3]) : 1;
+    } else if (argc == 3 && option == "--idle") {
+      idleSeconds = stod(argv[2]);
+    } else if ((argc == 6 || argc == 8) && option == "--race") {
+      race.reset(new Rollback(stoi(argv[2]), 1, stoi(argv[3]), argv[4], stoi(argv[5]),
+			      argc == 8 ? stoi(argv[6]) : 0,
+			      argc == 8 ? stoi(argv[7]) : 0));
+    } else if (argc != 1) {
+      cerr << "Usage: " << program << " [options] [--offscreen frames [scale] | --allocations frames]" << endl
+	   << "       " << program << " [options] --race player port host hostPort [delay loss]" << endl
+	   << "       " << program << " [options] --idle seconds" << endl
+	   << "Options: --capture path, --telemetry name, --textures megabytes, --analytics path" << endl;
+      return 1;
+    }
+    
     // Initialize the world
 
-    World world;
+    World world(mode);
 
     // Add our images to the display
 
@@ -39,10 +235,175 @@ int main() {
     world.addImage("graphics/lives.bmp");
     world.addImage("graphics/gameover.bmp");
     world.addImage("graphics/win.bmp");
+    if (textureBudget >= 0) {
+      world.setTextureBudget(static_cast<size_t>(textureBudget * (1 << 20)));
+    }
+
+    // Pre-render the rotations of the fireballs, which turn by 30
+    // and 20 degrees every frame
+
+    world.addRotations(5, 30, 50, 50);
+    world.addRotations(6, 20, 50, 50);
+
+    // Only the solid parts of the player, fireballs and pickups touch,
+    // at every angle the fireballs turn to
+
+    world.addMask(2, 80, 80);
+    world.addMask(3, 80, 80);
+    world.addMask(5, 50, 50, 30);
+    world.addMask(6, 50, 50, 20);
+    world.addMask(7, 50, 50);
+    world.addMask(8, 50, 50);
+
+    // Start capturing if asked to, at the display's usual rate
+
+    unique_ptr<Capture> capture;
+    if (!capturePath.empty()) {
+      bool y4m = capturePath.size() > 4 && capturePath.compare(capturePath.size() - 4, 4, ".y4m") == 0;
+      capture.reset(new Capture(capturePath, y4m ? Capture::Format::Y4M : Capture::Format::RAW,
+				1080, 720, 60, mode == RenderMode::OFFSCREEN));
+      world.setCapture(capture.get());
+    }
+
+    // Share how the game is running if asked to, for as long as it
+    // runs
+
+    unique_ptr<Telemetry> telemetry;
+    if (!telemetryName.empty()) {
+      telemetry.reset(new Telemetry(telemetryName, true));
+      world.setTelemetry(telemetry.get());
+    }
+
+    // Record what happens to the player if asked to, telling this
+    // game apart from others by when it started
+
+    unique_ptr<Analytics> analytics;
+    if (!analyticsPath.empty()) {
+      analytics.reset(new Analytics(analyticsPath,
+				    chrono::system_clock::now().time_since_epoch().count()));
+      world.setAnalytics(analytics.get());
+    }
+
+    // Offscreen, start the first level and run right, jumping
+    // now and then, for the given number of frames. Every frame 
+    // after the first second of a level must not allocate at all,
+    // whether or not only the allocations are being checked
+
+    if (mode == RenderMode::OFFSCREEN) {
+      world.setScale(scale);
+      pushKey(SDL_KEYUP, SDLK_SPACE);
+      pushKey(SDL_KEYDOWN, SDLK_RIGHT);
+      int levelFrames = 0;
+      int steadyFrames = 0;
+      int allocatingFrames = 0;
+      for (int frame = 0; frame < frames; ++frame) {
+	if (frame % 40 == 0) {
+	  pushKey(SDL_KEYDOWN, SDLK_UP);
+	}
+	if (world.checkForRelevantEvent() == RelevantEvent::QUIT) {
+	  return 0;
+	}
+	int level = world.getLevel();
+	world.refresh();
+
+	// the hashes would get in the way of a capture to the output,
+	// and go to the standard output unless only the allocations
+	// are being checked, when they do
+	if (!checkAllocations && capturePath != "-") {
+	  cout << frame << " " << hex << world.getFrameHash() << dec << '\n';
+	}
+	ostream& out = checkAllocations ? cout : cerr;
+	levelFrames = level > 0 && world.getLevel() == level ? levelFrames + 1 : 0;
+	if (levelFrames > 40) {
+	  ++steadyFrames;
+	  if (allocations(world) > 0) {
+	    ++allocatingFrames;
+	    out << "Frame " << frame << " allocated: " << world.getAllocations(FramePhase::EVENTS)
+		<< " between frames, " << world.getAllocations(FramePhase::OVERLAY)
+		<< " drawing the overlay, " << world.getAllocations(FramePhase::SIMULATE)
+		<< " simulating, " << world.getAllocations(FramePhase::DRAW)
+		<< " drawing and " << world.getAllocations(FramePhase::PRESENT)
+		<< " presenting" << endl;
+	  }
+	}
+      }
+      if (checkAllocations) {
+	cout << allocatingFrames << " of " << steadyFrames
+	     << " frames in a level allocated" << endl;
+	return allocatingFrames == 0 ? 0 : 1;
+      }
+      cerr << world.getFrameCount() << " frames at "
+	   << world.getFramesPerSecond() << " frames per second, levels drawn at "
+	   << world.getScale() * 100 << "% of the resolution" << endl;
+      world.reportImages(cerr);
+      const Particles& particles = world.getParticles();
+      cerr << particles.size() << " particles, the last update took "
+	   << particles.getUpdateTime() << " ms, " << particles.getDropped()
+	   << " dropped" << endl;
+      const History& history = world.getHistory();
+      cerr << history.getTicks() << " ticks (" << history.getSeconds()
+	   << " seconds) of history to rewind through, "
+	   << history.getChanges() << " sprite changes in " << history.getBytes() << " bytes" << endl;
+      const Audio& audio = world.getAudio();
+      if (audio.isOpen()) {
+	cerr << "Audio through the " << SDL_GetCurrentAudioDriver() << " driver at "
+	     << audio.getFrequency() << " Hz with " << audio.getLatency()
+	     << " ms of latency, " << audio.getMixed() << " samples mixed, "
+	     << audio.getDropped() << " sounds dropped" << endl;
+      }
+      if (capture) {
+	report(*capture);
+      }
+      if (analytics) {
+	report(*analytics);
+      }
+
+      // and whatever else it does, a frame in the middle of a level
+      // must not allocate at all
+      if (allocatingFrames > 0) {
+	cerr << allocatingFrames << " of " << steadyFrames
+	     << " frames in a level allocated" << endl;
+	return 1;
+      }
+      return 0;
+    }
+
+    // Compare drawing every frame with idling on the title screen,
+    // then in the first level with the window in the background,
+    // first without the keyboard and then minimized
+
+    if (idleSeconds > 0) {
+      if (!compare(world, "Title screen", idleSeconds)) {
+	return 0;
+      }
+      pushKey(SDL_KEYUP, SDLK_SPACE);
+      pushWindow(SDL_WINDOWEVENT_FOCUS_LOST);
+      if (!compare(world, "Level without the keyboard", idleSeconds)) {
+	return 0;
+      }
+      pushWindow(SDL_WINDOWEVENT_FOCUS_GAINED);
+      pushWindow(SDL_WINDOWEVENT_MINIMIZED);
+      compare(world, "Level minimized", idleSeconds);
+      return 0;
+    }
+
+    // Start the race if there is one
+
+    if (race) {
+      world.setRace(race.get());
+    }
 
     // Run until quit.
     
     for (;;) {
+
+      // Wait for something to happen if nothing on screen can
+      // change until it does
+
+      int wait = world.getIdleWait();
+      if (wait > 0) {
+	SDL_WaitEventTimeout(nullptr, wait);
+      }
       
       // Check for relevant events.
       
@@ -50,6 +411,15 @@ int main() {
       case RelevantEvent::NONE:
         break;
       case RelevantEvent::QUIT:
+	if (race) {
+	  report(*race);
+	}
+	if (capture) {
+	  report(*capture);
+	}
+	if (analytics) {
+	  report(*analytics);
+	}
         return 0;
       default:
 	cerr << "Unexpected event" << endl;
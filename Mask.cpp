@@ -0,0 +1,128 @@
+#include "Mask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace medieval;
+
+Mask::Mask() noexcept {}
+
+Mask::Mask(int width, int height) : width_(width), height_(height), words_((width + 63) / 64) {
+  if (width < 0 || height < 0) {
+    throw domain_error("A mask can't be " + to_string(width) + " by " + to_string(height));
+  }
+  bits_.assign(static_cast<size_t>(words_) * height_, 0);
+}
+
+void Mask::set(int x, int y) noexcept {
+  if (x >= 0 && x < width_ && y >= 0 && y < height_) {
+    bits_[y * words_ + x / 64] |= uint64_t(1) << (x % 64);
+    if (left_ == right_) {
+      left_ = x;
+      top_ = y;
+      right_ = x + 1;
+      bottom_ = y + 1;
+    } else {
+      left_ = min(left_, x);
+      top_ = min(top_, y);
+      right_ = max(right_, x + 1);
+      bottom_ = max(bottom_, y + 1);
+    }
+  }
+}
+
+bool Mask::at(int x, int y) const noexcept {
+  return x >= 0 && x < width_ && y >= 0 && y < height_ &&
+    (bits_[y * words_ + x / 64] >> (x % 64) & 1);
+}
+
+int Mask::getWidth() const noexcept {
+  return width_;
+}
+
+int Mask::getHeight() const noexcept {
+  return height_;
+}
+
+int Mask::getCount() const noexcept {
+  int count = 0;
+  for (uint64_t word : bits_) {
+    for (; word; word &= word - 1) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+Mask Mask::fit(int width, int height, int degrees) const {
+  // each new pixel's centre is turned back by the angle about the
+  // centre, then stretched back to this mask's size
+  Mask fitted(width, height);
+  double radians = degrees * 3.14159265358979323846 / 180;
+  double cosine = cos(radians);
+  double sine = sin(radians);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      double across = x + 0.5 - width / 2.0;
+      double down = y + 0.5 - height / 2.0;
+      double sourceX = (across * cosine + down * sine + width / 2.0) * width_ / width;
+      double sourceY = (down * cosine - across * sine + height / 2.0) * height_ / height;
+      if (at(static_cast<int>(floor(sourceX)), static_cast<int>(floor(sourceY)))) {
+	fitted.set(x, y);
+      }
+    }
+  }
+  return fitted;
+}
+
+bool Mask::any(int left, int top, int right, int bottom) const noexcept {
+  left = max(left, left_);
+  top = max(top, top_);
+  right = min(right, right_);
+  bottom = min(bottom, bottom_);
+  for (int y = top; y < bottom; ++y) {
+    for (int x = left; x < right; x += 64) {
+      uint64_t pixels = row(y, x);
+      if (right - x < 64) {
+	pixels &= (uint64_t(1) << (right - x)) - 1;
+      }
+      if (pixels) {
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool Mask::overlap(const Mask& a, int ax, int ay, const Mask& b, int bx, int by) noexcept {
+  // only the rows and columns inside the solid part of both are
+  // looked at, 64 columns at a time
+  int left = max(ax + a.left_, bx + b.left_);
+  int right = min(ax + a.right_, bx + b.right_);
+  int top = max(ay + a.top_, by + b.top_);
+  int bottom = min(ay + a.bottom_, by + b.bottom_);
+  for (int y = top; y < bottom; ++y) {
+    for (int x = left; x < right; x += 64) {
+      uint64_t both = a.row(y - ay, x - ax) & b.row(y - by, x - bx);
+      if (right - x < 64) {
+	both &= (uint64_t(1) << (right - x)) - 1;
+      }
+      if (both) {
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+uint64_t Mask::row(int y, int x) const noexcept {
+  const uint64_t* words = &bits_[y * words_ + x / 64];
+  int shift = x % 64;
+  uint64_t pixels = words[0] >> shift;
+  if (shift > 0 && x / 64 + 1 < words_) {
+    pixels |= words[1] << (64 - shift);
+  }
+  return pixels;
+}
@@ -0,0 +1,129 @@
+#ifndef MEDIEVAL_MASK_H
+#define MEDIEVAL_MASK_H
+
+#include <cstdint>
+#include <vector>
+
+namespace medieval {
+
+/**
+ * A collision mask class. This class holds one bit for each pixel of
+ * an image, set where the image is solid, 64 pixels to a word, so
+ * that whether two images overlap anywhere takes a word AND for each
+ * 64 pixels of each row where their boxes overlap. Only the box
+ * around the solid pixels is looked at, so masks whose boxes only
+ * overlap at empty corners are passed over straight away. The bits
+ * past the right of each row are always clear.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Mask {
+public:
+
+  /**
+   * Construct a mask with no pixels.
+   */
+  Mask() noexcept;
+
+  /**
+   * Construct a mask with every pixel clear.
+   * @throw domain_error if the size is negative
+   */
+  Mask(/** The width and height */
+       int width, int height);
+
+  /**
+   * Sets a pixel solid.
+   */
+  void set(/** The pixel */
+	   int x, int y) noexcept;
+
+  /**
+   * Get whether a pixel is solid.
+   * @return whether it is solid, which it isn't outside the mask
+   */
+  bool at(/** The pixel */
+	  int x, int y) const noexcept;
+
+  /**
+   * Get the width of the mask.
+   * @return the width
+   */
+  int getWidth() const noexcept;
+
+  /**
+   * Get the height of the mask.
+   * @return the height
+   */
+  int getHeight() const noexcept;
+
+  /**
+   * Get the number of solid pixels.
+   * @return the number of solid pixels
+   */
+  int getCount() const noexcept;
+
+  /**
+   * Get this mask stretched to another size and turned about its
+   * centre, as the image is drawn, taking each pixel from the nearest
+   * one. Whatever is turned past the edges is cut off.
+   * @return the new mask
+   */
+  Mask fit(/** The width and height */
+	   int width, int height,
+	   /** The degrees to turn clockwise */
+	   int degrees) const;
+
+  /**
+   * Get whether any pixel in a box is solid.
+   * @return whether one is
+   */
+  bool any(/** The top left of the box */
+	   int left, int top,
+	   /** The right and bottom of the box, which aren't in it */
+	   int right, int bottom) const noexcept;
+
+  /**
+   * Get whether two masks have a solid pixel in the same place.
+   * @return whether they overlap
+   */
+  static bool overlap(/** The first mask and where its top left is */
+		      const Mask& a, int ax, int ay,
+		      /** The second mask and where its top left is */
+		      const Mask& b, int bx, int by) noexcept;
+
+private:
+
+  /**
+   * The size, and the number of words in each row
+   */
+  int width_ = 0;
+  int height_ = 0;
+  int words_ = 0;
+
+  /**
+   * The box around the solid pixels, which is empty if there are none
+   */
+  int left_ = 0;
+  int top_ = 0;
+  int right_ = 0;
+  int bottom_ = 0;
+
+  /**
+   * The bits, one row after another, with the leftmost pixel of a
+   * word in its lowest bit
+   */
+  std::vector<std::uint64_t> bits_;
+
+  /**
+   * Get the 64 pixels of a row starting at a column.
+   * @return the pixels, with those past the right clear
+   */
+  std::uint64_t row(/** The row */ int y,
+		    /** The column, which is inside the mask */ int x) const noexcept;
+};
+
+}
+
+#endif
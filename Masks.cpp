@@ -0,0 +1,75 @@
+#include "Masks.h"
+
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace medieval;
+
+void Masks::add(int index, const Mask& mask) {
+  if (index < 0) {
+    throw domain_error("Invalid image index " + to_string(index));
+  }
+  if (static_cast<int>(images_.size()) <= index) {
+    images_.resize(index + 1);
+  }
+  images_[index] = Image();
+  images_[index].loaded = mask;
+}
+
+void Masks::fit(int index, int width, int height, int step) {
+  if (index < 0 || index >= static_cast<int>(images_.size()) ||
+      images_[index].loaded.getWidth() == 0) {
+    throw domain_error("No mask for image " + to_string(index));
+  }
+  if (step <= 0 || 360 % step != 0) {
+    throw domain_error("Can't turn a mask in steps of " + to_string(step) + " degrees");
+  }
+  Image& image = images_[index];
+  image.width = width;
+  image.height = height;
+  image.step = step;
+  image.angles.clear();
+  for (int angle = 0; angle < 360; angle += step) {
+    image.angles.push_back(image.loaded.fit(width, height, angle));
+  }
+}
+
+const Mask* Masks::find(const Sprite& sprite) const noexcept {
+  int index = sprite.getImageIndex();
+  if (index < 0 || index >= static_cast<int>(images_.size())) {
+    return nullptr;
+  }
+  const Image& image = images_[index];
+  if (image.angles.empty() || image.width != sprite.getWidth() ||
+      image.height != sprite.getHeight()) {
+    return nullptr;
+  }
+
+  // an angle between two steps takes the nearest
+  int angle = (sprite.getAngle() % 360 + 360) % 360;
+  int frame = (angle + image.step / 2) / image.step % static_cast<int>(image.angles.size());
+  return &image.angles[frame];
+}
+
+bool Masks::hit(const Sprite& a, const Sprite& b) const noexcept {
+  const Mask* first = find(a);
+  const Mask* second = find(b);
+  if (first && second) {
+    return Mask::overlap(*first, a.getXCoordinate(), a.getYCoordinate(),
+			 *second, b.getXCoordinate(), b.getYCoordinate());
+  }
+  if (!first && !second) {
+    return true;
+  }
+
+  // a sprite without a mask is solid over the part of its box inside
+  // the other's
+  const Sprite& masked = first ? a : b;
+  const Sprite& solid = first ? b : a;
+  int x = masked.getXCoordinate();
+  int y = masked.getYCoordinate();
+  return (first ? first : second)->any(solid.getXCoordinate() - x, solid.getYCoordinate() - y,
+				       solid.getXCoordinate() + solid.getWidth() - x,
+				       solid.getYCoordinate() + solid.getHeight() - y);
+}
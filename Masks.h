@@ -0,0 +1,85 @@
+#ifndef MEDIEVAL_MASKS_H
+#define MEDIEVAL_MASKS_H
+
+#include <vector>
+#include "Mask.h"
+#include "Sprite.h"
+
+namespace medieval {
+
+/**
+ * A class for the collision masks of every image. Each image's mask
+ * is kept at the size it was loaded, and fitted ahead of time to the
+ * size sprites draw it at and to every angle they turn it to, so
+ * that checking whether two sprites really touch never has to make a
+ * mask.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Masks {
+public:
+
+  /**
+   * Adds the mask of an image as it was loaded.
+   */
+  void add(/** The index of the image */
+	   int index,
+	   /** Its mask */
+	   const Mask& mask);
+
+  /**
+   * Fits an image's mask to the size sprites draw it at, turned to
+   * every angle they turn it to.
+   * @throw domain_error if the image has no mask, or the step doesn't
+   * divide 360
+   */
+  void fit(/** The index of the image */
+	   int index,
+	   /** The width and height it is drawn at */
+	   int width, int height,
+	   /** The number of degrees between the angles it is turned to,
+	       or 360 if it isn't turned */
+	   int step = 360);
+
+  /**
+   * Get the mask for a sprite as it is now.
+   * @return the mask, or nullptr if there is none fitted for its
+   * image and size
+   */
+  const Mask* find(/** The sprite */
+		   const Sprite& sprite) const noexcept;
+
+  /**
+   * Get whether two sprites whose boxes overlap really touch. A sprite
+   * without a mask is solid all over its box.
+   * @return whether they touch
+   */
+  bool hit(/** The sprites */
+	   const Sprite& a, const Sprite& b) const noexcept;
+
+private:
+
+  /**
+   * The masks of one image
+   */
+  struct Image {
+    /** The mask as it was loaded */
+    Mask loaded;
+    /** The size it is fitted to, and the degrees between angles */
+    int width = 0;
+    int height = 0;
+    int step = 360;
+    /** The mask fitted at each angle */
+    std::vector<Mask> angles;
+  };
+
+  /**
+   * The masks, by image index
+   */
+  std::vector<Image> images_;
+};
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include "Particles.h"
+
+#include <chrono>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * How much faster particles fall each tick. 
+ */
+static const float GRAVITY = 0.15f;
+
+/**
+ * Particles below this have fallen off the screen. 
+ */
+static const float BOTTOM = 720;
+
+Particles::Particles() :
+  x_(CAPACITY), y_(CAPACITY), speedH_(CAPACITY), speedV_(CAPACITY),
+  life_(CAPACITY), kind_(CAPACITY) {}
+
+void Particles::trail(const Sprite& ball) noexcept {
+  // a couple of embers from the middle of the ball, drifting up
+  float x = ball.getXCoordinate() + ball.getWidth() / 2.0f;
+  float y = ball.getYCoordinate() + ball.getHeight() / 2.0f;
+  for (int i = 0; i < 2; ++i) {
+    emit(x + uniform(-8, 8), y + uniform(-8, 8), uniform(-0.5f, 0.5f),
+	 uniform(-2.5f, -1), uniform(LIFE / 3, LIFE / 2), FIRE);
+  }
+}
+
+void Particles::burst(int x, int y, Kind kind) noexcept {
+  // sparks flying out in every direction
+  for (int i = 0; i < 48; ++i) {
+    float angle = uniform(0, 6.2831853f);
+    float speed = uniform(1.5f, 4.5f);
+    emit(x, y, speed * cos(angle), speed * sin(angle) - 2, uniform(LIFE / 2, LIFE), kind);
+  }
+}
+
+void Particles::update() noexcept {
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  float* x = x_.data();
+  float* y = y_.data();
+  float* speedH = speedH_.data();
+  float* speedV = speedV_.data();
+  float* life = life_.data();
+  int dead = 0;
+
+  // moves the particles four at a time, noting whether any died
+  int i = 0;
+#ifdef __SSE2__
+  const __m128 gravity = _mm_set1_ps(GRAVITY);
+  const __m128 one = _mm_set1_ps(1);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 bottom = _mm_set1_ps(BOTTOM);
+  for (; i + 4 <= size_; i += 4) {
+    __m128 v = _mm_add_ps(_mm_loadu_ps(speedV + i), gravity);
+    __m128 py = _mm_add_ps(_mm_loadu_ps(y + i), v);
+    __m128 px = _mm_add_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(speedH + i));
+    __m128 left = _mm_sub_ps(_mm_loadu_ps(life + i), one);
+    _mm_storeu_ps(speedV + i, v);
+    _mm_storeu_ps(y + i, py);
+    _mm_storeu_ps(x + i, px);
+    _mm_storeu_ps(life + i, left);
+    dead |= _mm_movemask_ps(_mm_or_ps(_mm_cmple_ps(left, zero), _mm_cmpgt_ps(py, bottom)));
+  }
+#endif
+  for (; i < size_; ++i) {
+    speedV[i] += GRAVITY;
+    y[i] += speedV[i];
+    x[i] += speedH[i];
+    life[i] -= 1;
+    dead |= life[i] <= 0 || y[i] > BOTTOM;
+  }
+
+  // removes the dead by moving the last particle into their place,
+  // which only needs doing on the ticks that some died
+  if (dead) {
+    for (i = 0; i < size_;) {
+      if (life[i] <= 0 || y[i] > BOTTOM) {
+	--size_;
+	x[i] = x[size_];
+	y[i] = y[size_];
+	speedH[i] = speedH[size_];
+	speedV[i] = speedV[size_];
+	life[i] = life[size_];
+	kind_[i] = kind_[size_];
+      } else {
+	++i;
+      }
+    }
+  }
+  updateTime_ = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void Particles::clear() noexcept {
+  size_ = 0;
+}
+
+int Particles::size() const noexcept {
+  return size_;
+}
+
+float Particles::getX(int i) const noexcept {
+  return x_[i];
+}
+
+float Particles::getY(int i) const noexcept {
+  return y_[i];
+}
+
+float Particles::getLife(int i) const noexcept {
+  return life_[i];
+}
+
+Particles::Kind Particles::getKind(int i) const noexcept {
+  return kind_[i];
+}
+
+long Particles::getDropped() const noexcept {
+  return dropped_;
+}
+
+double Particles::getUpdateTime() const noexcept {
+  return updateTime_;
+}
+
+void Particles::emit(float x, float y, float speedH, float speedV, float life, Kind kind) noexcept {
+  if (size_ == CAPACITY) {
+    ++dropped_;
+    return;
+  }
+  x_[size_] = x;
+  y_[size_] = y;
+  speedH_[size_] = speedH;
+  speedV_[size_] = speedV;
+  life_[size_] = life;
+  kind_[size_] = kind;
+  ++size_;
+}
+
+float Particles::uniform(float low, float high) noexcept {
+  return low + (high - low) * (random_() - random_.min()) / float(random_.max() - random_.min());
+}
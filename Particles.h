@@ -0,0 +1,163 @@
+#ifndef MEDIEVAL_PARTICLES_H
+#define MEDIEVAL_PARTICLES_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "Sprite.h"
+
+namespace medieval {
+
+/**
+ * A particle class. This class holds the small sparks drawn behind
+ * fireballs and when the player is hurt or picks something up. Each
+ * property of the particles is kept in its own array, which never
+ * grows past a fixed capacity, so that they can all be moved four at
+ * a time and none of it allocates once the game is running. 
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Particles {
+public:
+
+  /**
+   * What made a particle, which decides its color. 
+   */
+  enum Kind : std::uint8_t {
+    FIRE,
+    HEALTH,
+    COIN,
+    KINDS
+  };
+
+  /**
+   * The most particles there can be at once. 
+   */
+  static const int CAPACITY = 1 << 17;
+
+  /**
+   * The most ticks a particle lives for. 
+   */
+  static const int LIFE = 48;
+
+  /**
+   * Construct an empty set of particles. 
+   */
+  Particles();
+
+  /**
+   * Emits a few embers behind a fireball. 
+   */
+  void trail(/** The fireball */
+	     const Sprite& ball) noexcept;
+
+  /**
+   * Emits a ring of sparks. 
+   */
+  void burst(/** The center of the ring */
+	     int x, int y,
+	     /** What made the sparks */
+	     Kind kind) noexcept;
+
+  /**
+   * Moves every particle by a tick, and removes those that have 
+   * died or fallen off the bottom of the screen. 
+   */
+  void update() noexcept;
+
+  /**
+   * Removes every particle. 
+   */
+  void clear() noexcept;
+
+  /**
+   * Get the number of live particles.
+   * @return the number of particles
+   */
+  int size() const noexcept;
+
+  /**
+   * Get the position of a particle.
+   * @return the coordinate
+   */
+  float getX(/** The particle */ int i) const noexcept;
+  float getY(/** The particle */ int i) const noexcept;
+
+  /**
+   * Get the ticks a particle has left to live.
+   * @return the ticks left
+   */
+  float getLife(/** The particle */ int i) const noexcept;
+
+  /**
+   * Get what made a particle.
+   * @return the kind of particle
+   */
+  Kind getKind(/** The particle */ int i) const noexcept;
+
+  /**
+   * Get the number of particles that could not be emitted because
+   * there were already as many as there can be.
+   * @return the number of particles dropped
+   */
+  long getDropped() const noexcept;
+
+  /**
+   * Get how long the last update took.
+   * @return the time in milliseconds
+   */
+  double getUpdateTime() const noexcept;
+  
+private:
+
+  /**
+   * The position, velocity and life left of each particle
+   */
+  std::vector<float> x_;
+  std::vector<float> y_;
+  std::vector<float> speedH_;
+  std::vector<float> speedV_;
+  std::vector<float> life_;
+
+  /**
+   * What made each particle
+   */
+  std::vector<Kind> kind_;
+
+  /**
+   * The number of live particles, which are the first ones in 
+   * each array
+   */
+  int size_ = 0;
+
+  /**
+   * The number of particles that didn't fit
+   */
+  long dropped_ = 0;
+
+  /**
+   * How long the last update took in milliseconds
+   */
+  double updateTime_ = 0;
+
+  /**
+   * Where the random spread of new particles comes from
+   */
+  std::minstd_rand random_;
+
+  /**
+   * Adds a particle if there is room. 
+   */
+  void emit(float x, float y, float speedH, float speedV, float life, Kind kind) noexcept;
+
+  /**
+   * Get a random number in a range.
+   * @return the number
+   */
+  float uniform(float low, float high) noexcept;
+};
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "Patrols.h"
+
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * How far a moving fireball turns each tick. 
+ */
+static const int SPIN = -20;
+
+void Patrols::reserve(size_t count) {
+  for (vector<double>* v : {&from_, &early_, &x_, &step_, &angle_, &turn_, &period_, &half_,
+	&inverse_, &phase_}) {
+    v->reserve(count);
+  }
+  left_.reserve(count);
+}
+
+void Patrols::add(const Balls& ball, int tick) {
+  if (ball.getImageIndex() != 6) {
+    throw domain_error("Only moving fireballs patrol");
+  }
+  Balls::Patrol patrol = ball.getPatrol();
+  from_.push_back(tick);
+  early_.push_back(patrol.early);
+  x_.push_back(patrol.x);
+  left_.push_back(patrol.left);
+  step_.push_back(patrol.left ? -5 : 5);
+  angle_.push_back(patrol.angle);
+  turn_.push_back(patrol.turn);
+  period_.push_back(patrol.period);
+  half_.push_back(patrol.period / 2);
+  inverse_.push_back(1.0 / patrol.period);
+  phase_.push_back(patrol.phase);
+}
+
+size_t Patrols::size() const noexcept {
+  return from_.size();
+}
+
+void Patrols::at(int tick, int* x, uint8_t* left, int* angle) const noexcept {
+  int count = static_cast<int>(from_.size());
+  int i = 0;
+
+  // goes round the paths two at a time. Every number fits in a
+  // double, so the round of each path is found by multiplying by one
+  // over the period, which can only come out a period too many or too
+  // few, rather than by dividing
+#ifdef __SSE2__
+  const __m128d now = _mm_set1_pd(tick);
+  const __m128d five = _mm_set1_pd(5);
+  const __m128d spin = _mm_set1_pd(SPIN);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d turn = _mm_set1_pd(360);
+  const __m128d perTurn = _mm_set1_pd(1.0 / 360);
+  for (; i + 2 <= count; i += 2) {
+    __m128d ticks = _mm_sub_pd(now, _mm_loadu_pd(&from_[i]));
+    __m128d period = _mm_loadu_pd(&period_[i]);
+    __m128d round = _mm_add_pd(_mm_loadu_pd(&phase_[i]), ticks);
+    __m128d rounds = _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_mul_pd(round, _mm_loadu_pd(&inverse_[i]))));
+    round = _mm_sub_pd(round, _mm_mul_pd(rounds, period));
+    round = _mm_add_pd(round, _mm_and_pd(_mm_cmplt_pd(round, zero), period));
+    round = _mm_sub_pd(round, _mm_and_pd(_mm_cmpge_pd(round, period), period));
+    __m128d going = _mm_add_pd(_mm_loadu_pd(&turn_[i]),
+			       _mm_mul_pd(five, _mm_min_pd(round, _mm_sub_pd(period, round))));
+    __m128d turned = _mm_cmpge_pd(round, _mm_loadu_pd(&half_[i]));
+
+    // before going round, one more step the way it was going
+    __m128d early = _mm_cmplt_pd(ticks, _mm_loadu_pd(&early_[i]));
+    __m128d stepping = _mm_add_pd(_mm_loadu_pd(&x_[i]), _mm_mul_pd(_mm_loadu_pd(&step_[i]), ticks));
+    going = _mm_or_pd(_mm_and_pd(early, stepping), _mm_andnot_pd(early, going));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(x + i), _mm_cvttpd_epi32(going));
+
+    // and the angle within a turn, the same way, which can come out
+    // up to two turns too few or one too many
+    __m128d spun = _mm_add_pd(_mm_loadu_pd(&angle_[i]), _mm_mul_pd(spin, ticks));
+    __m128d spins = _mm_cvtepi32_pd(_mm_cvttpd_epi32(_mm_mul_pd(spun, perTurn)));
+    spun = _mm_sub_pd(spun, _mm_mul_pd(spins, turn));
+    spun = _mm_add_pd(spun, _mm_and_pd(_mm_cmplt_pd(spun, zero), turn));
+    spun = _mm_add_pd(spun, _mm_and_pd(_mm_cmplt_pd(spun, zero), turn));
+    spun = _mm_sub_pd(spun, _mm_and_pd(_mm_cmpge_pd(spun, turn), turn));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(angle + i), _mm_cvttpd_epi32(spun));
+    int turns = _mm_movemask_pd(turned);
+    int earlies = _mm_movemask_pd(early);
+    int moved = _mm_movemask_pd(_mm_cmpgt_pd(ticks, zero));
+    for (int lane = 0; lane < 2; ++lane) {
+      left[i + lane] = (earlies >> lane & 1) ? left_[i + lane] ^ (moved >> lane & 1) : turns >> lane & 1;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    Balls::Patrol patrol;
+    patrol.turn = static_cast<int>(turn_[i]);
+    patrol.period = static_cast<int>(period_[i]);
+    patrol.phase = static_cast<int>(phase_[i]);
+    patrol.early = static_cast<int>(early_[i]);
+    patrol.x = static_cast<int>(x_[i]);
+    patrol.left = left_[i];
+    bool going;
+    patrol.at(tick - static_cast<int>(from_[i]), x[i], going);
+    left[i] = going;
+    long long spun = static_cast<long long>(angle_[i]) +
+      SPIN * ((tick - static_cast<long long>(from_[i])) % 360);
+    angle[i] = static_cast<int>((spun % 360 + 360) % 360);
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef MEDIEVAL_PATROLS_H
+#define MEDIEVAL_PATROLS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Balls.h"
+
+namespace medieval {
+
+/**
+ * A class for working out where many moving fireballs are at once.
+ * Each fireball's patrol is kept as plain numbers, one array for
+ * each, so that where they all are at any tick can be worked out two
+ * at a time without moving any of them, and in the same time for a
+ * tick far ahead as for the next one.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Patrols {
+public:
+
+  /**
+   * Makes room for a number of fireballs, so that adding them
+   * allocates at most once.
+   */
+  void reserve(/** The number of fireballs */
+	       std::size_t count);
+
+  /**
+   * Adds a moving fireball as it is now.
+   * @throw domain_error if the fireball doesn't move
+   */
+  void add(/** The fireball */
+	   const Balls& ball,
+	   /** The tick it is on now */
+	   int tick);
+
+  /**
+   * Get the number of fireballs.
+   * @return the number of fireballs
+   */
+  std::size_t size() const noexcept;
+
+  /**
+   * Works out where every fireball is at a tick, in the order they
+   * were added. Each angle is from 0 to 359, however far ahead the
+   * tick is.
+   */
+  void at(/** The tick, which is no earlier than any was added on */
+	  int tick,
+	  /** Set to each x coordinate */
+	  int* x,
+	  /** Set to whether each is going left */
+	  std::uint8_t* left,
+	  /** Set to each angle */
+	  int* angle) const noexcept;
+
+private:
+
+  /**
+   * The tick each fireball was added on, and the number of ticks
+   * after it before it is going round its path
+   */
+  std::vector<double> from_;
+  std::vector<double> early_;
+
+  /**
+   * Where each was when added, which way it was going, the step it
+   * was taking and its angle
+   */
+  std::vector<double> x_;
+  std::vector<std::uint8_t> left_;
+  std::vector<double> step_;
+  std::vector<double> angle_;
+
+  /**
+   * Where each turns back by the start of its path, how long it takes
+   * to go round it, half that, one over it, and where round it was
+   * when added
+   */
+  std::vector<double> turn_;
+  std::vector<double> period_;
+  std::vector<double> half_;
+  std::vector<double> inverse_;
+  std::vector<double> phase_;
+};
+
+}
+
+#endif
@@ -38,7 +38,7 @@ void Player::setH(int v) noexcept {
   speedH_ = v;
 }
 
-void Player::jump() noexcept {
+bool Player::jump() noexcept {
   if (!inAir_) {
     speedV_ = -20;
     
@@ -46,7 +46,9 @@ void Player::jump() noexcept {
     // of the jump
     y_ -= 20;
     inAir_ = true;
+    return true;
   }
+  return false;
 }
 
 void Player::stopH() noexcept {
@@ -57,12 +59,23 @@ void Player::stopV() noexcept {
   speedV_ = 0;
 }
 
-bool Player::touchingGround(vector<shared_ptr<Sprite>> sprites) noexcept {
+bool Player::touchingGround(const TileMap& tiles, const vector<shared_ptr<Sprite>>& sprites) noexcept {
   inAir_ = true;
   // checks if the player is moving
   if (speedV_ >= 0) {
-    // if the player is it will check through the sprites
-    for(shared_ptr<Sprite> s : sprites) {
+    // looks for a tile on the grid under you, but not so far to the side
+    // that you'd be hitting it as a wall, which is the same test as below
+    int x;
+    int y;
+    if (tiles.find(x_ - TileMap::TILE + 10, y_ + height_ - 34,
+		   x_ + width_ - 10, y_ + height_ - 1, x, y)) {
+      y_ = y - height_ + 1;
+      speedV_ = 0;
+      inAir_ = false;
+      return inAir_;
+    }
+    // otherwise it will check through the tiles off the grid
+    for(const shared_ptr<Sprite>& s : sprites) {
       // checks if the player's not currently hitting this as a wall
       // and that it's underneath you
       if(!(s->hits(*this) && ((x_ + width_ - (s->getXCoordinate())) < 10) && (s->getImageIndex() == 4)) &&
@@ -80,11 +93,27 @@ bool Player::touchingGround(vector<shared_ptr<Sprite>> sprites) noexcept {
   return inAir_;
 }
 
-bool Player::touchingWall(vector<shared_ptr<Sprite>> sprites) noexcept {
+bool Player::touchingWall(const TileMap& tiles, const vector<shared_ptr<Sprite>>& sprites) noexcept {
   // checks if the player is moving
   if (speedH_ != 0) {
-    // if the player is it will check through the sprites
-    for(shared_ptr<Sprite> s : sprites) {
+    // looks for a tile on the grid beside you, skipping the ones
+    // you're standing on, which is the same test as below
+    int top = y_ - TileMap::TILE + 1;
+    int bottom = inAir_ ? y_ + height_ - 1 : y_ + height_ - 35;
+    int x;
+    int y;
+    if (speedH_ > 0 && tiles.find(x_ + width_ - 9, top, x_ + width_ - 1, bottom, x, y)) {
+      x_ = x - width_ + 1;
+      speedH_ = 0;
+      return true;
+    }
+    if (speedH_ < 0 && tiles.find(x_ - TileMap::TILE + 1, top, x_ - TileMap::TILE + 9, bottom, x, y)) {
+      x_ = x + TileMap::TILE - 1;
+      speedH_ = 0;
+      return true;
+    }
+    // otherwise it will check through the tiles off the grid
+    for(const shared_ptr<Sprite>& s : sprites) {
       // checks if the player's not currently touching the sprite on the ground,
       // or that you're in the air after recently falling
       if(!(s->hits(*this) && ((y_ + height_ - (s->getYCoordinate())) < 35) && (s->getImageIndex() == 4)) || inAir_) {
@@ -152,3 +181,17 @@ bool Player::touchingCoin(vector<shared_ptr<Sprite>>& sprites) const noexcept {
   }
   return false;
 }
+
+void Player::save(SpriteState& state) const noexcept {
+  Sprite::save(state);
+  state.speedH = speedH_;
+  state.speedV = speedV_;
+  state.inAir = inAir_;
+}
+
+void Player::restore(const SpriteState& state) noexcept {
+  Sprite::restore(state);
+  speedH_ = state.speedH;
+  speedV_ = state.speedV;
+  inAir_ = state.inAir;
+}
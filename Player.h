@@ -2,6 +2,7 @@
 #define MEDIEVAL_PLAYER_H
 
 #include "Sprite.h"
+#include "TileMap.h"
 #include <vector>
 #include <memory>
 
@@ -33,6 +34,18 @@ public:
    */
   void move() noexcept override;
 
+  /**
+   * Saves the state of the player, including its momentum. 
+   */
+  void save(/** Where to save the state */
+	    SpriteState& state) const noexcept override;
+
+  /**
+   * Restores a previously saved state of the player. 
+   */
+  void restore(/** The state to restore */
+	       const SpriteState& state) noexcept override;
+
   /**
    * Sets the player's x coordinate
    */
@@ -50,8 +63,9 @@ public:
 
   /**
    * Tells the player to jump
+   * @return whether the player was on the ground to jump from
    */
-  void jump() noexcept;
+  bool jump() noexcept;
 
   /**
    * Stops the player's horizontal momentum
@@ -68,16 +82,20 @@ public:
    * accordingly. 
    * @return whether the player is touching the ground
    */
-  bool touchingGround(/** The list of sprites to check if touching */
-		      std::vector<std::shared_ptr<Sprite>> sprites) noexcept;
+  bool touchingGround(/** The tiles on the level's grid */
+		      const TileMap& tiles,
+		      /** The tiles that are not on the grid */
+		      const std::vector<std::shared_ptr<Sprite>>& sprites) noexcept;
 
   /**
    * Determines if the player is touching a wall and responds 
    * accordingly. 
    * @return whether the player is touching a wall
    */
-  bool touchingWall(/** The list of sprites to check if touching */
-		    std::vector<std::shared_ptr<Sprite>> sprites) noexcept;
+  bool touchingWall(/** The tiles on the level's grid */
+		    const TileMap& tiles,
+		    /** The tiles that are not on the grid */
+		    const std::vector<std::shared_ptr<Sprite>>& sprites) noexcept;
 
   /**
    * Determines if the player is touching an obstacle and responds 
@@ -0,0 +1,147 @@
+#include "Race.h"
+
+using namespace std;
+using namespace medieval;
+
+Race::Race(int level) : levels_{Level(level), Level(level)} {}
+
+void Race::step(const uint8_t inputs[2]) noexcept {
+  if (over()) {
+    return;
+  }
+  for (int i = 0; i < 2; ++i) {
+    step(levels_[i], racers_[i], inputs[i], tick_);
+  }
+  ++tick_;
+}
+
+void Race::step(Level& level, Racer& racer, uint8_t input, int tick) noexcept {
+  shared_ptr<Player> player = level.getPlayer().lock();
+
+  // Move the player as the world does for held keys
+  if (input & LEFT) {
+    player->setH(-8);
+  } else if (input & RIGHT) {
+    player->setH(8);
+  } else {
+    player->stopH();
+  }
+  if (input & UP) {
+    player->jump();
+  }
+  level.evolve();
+
+  // If the player takes damage reduce one health
+  if (level.damaged()) {
+    --racer.health;
+    racer.score -= 10;
+  }
+
+  // If the player picks up health, heal them
+  if (level.healed() && racer.health < 3) {
+    ++racer.health;
+  }
+
+  // If the player picks up a coin, add score
+  if (level.scored()) {
+    racer.score += 25;
+  }
+
+  // If the player is dead reset health, reduce lives, lose score and reset player
+  if (level.dead() || racer.health <= 0) {
+    --racer.lives;
+    racer.health = 3;
+    level.resetPlayer();
+    racer.score -= 50;
+  }
+
+  // Note when the player reaches the end
+  if (level.next()) {
+    racer.finished = tick;
+  }
+}
+
+void Race::save(State& state) const {
+  for (int i = 0; i < 2; ++i) {
+    levels_[i].save(state.levels[i]);
+    state.racers[i] = racers_[i];
+  }
+  state.tick = tick_;
+}
+
+void Race::restore(const State& state) noexcept {
+  for (int i = 0; i < 2; ++i) {
+    levels_[i].restore(state.levels[i]);
+    racers_[i] = state.racers[i];
+  }
+  tick_ = state.tick;
+}
+
+uint64_t Race::checksum(const State& state) noexcept {
+  // 64 bit FNV-1a over every value in the state
+  uint64_t hash = 14695981039346656037ULL;
+  auto add = [&hash](int value) {
+    for (int byte = 0; byte < 4; ++byte) {
+      hash ^= (static_cast<uint32_t>(value) >> (byte * 8)) & 0xff;
+      hash *= 1099511628211ULL;
+    }
+  };
+  for (int i = 0; i < 2; ++i) {
+    const Level::State& level = state.levels[i];
+    for (size_t s = 0; s < level.sprites.size(); ++s) {
+      const SpriteState& sprite = level.sprites[s];
+      add(level.present[s]);
+      add(sprite.imageIndex);
+      add(sprite.x);
+      add(sprite.y);
+      add(sprite.angle);
+      add(sprite.speedH);
+      add(sprite.speedV);
+      add(sprite.inAir);
+      add(sprite.left);
+    }
+
+    // and where each scripted hazard is in its behavior, which can
+    // differ well before it moves the hazard differently
+    for (const Hazards::Frame& frame : level.hazards) {
+      add(frame.step);
+      add(frame.left);
+      add(frame.phase);
+      add(frame.speed);
+      add(frame.wake);
+    }
+    const Racer& racer = state.racers[i];
+    add(racer.health);
+    add(racer.lives);
+    add(racer.score);
+    add(racer.finished);
+  }
+  add(state.tick);
+  return hash;
+}
+
+void Race::setMasks(const Masks* masks) noexcept {
+  levels_[0].setMasks(masks);
+  levels_[1].setMasks(masks);
+}
+
+const Level& Race::getLevel(int player) const noexcept {
+  return levels_[player];
+}
+
+const Race::Racer& Race::getRacer(int player) const noexcept {
+  return racers_[player];
+}
+
+int Race::getTick() const noexcept {
+  return tick_;
+}
+
+bool Race::over() const noexcept {
+  for (const Racer& racer : racers_) {
+    if (racer.finished >= 0 || racer.lives <= 0) {
+      return true;
+    }
+  }
+  return false;
+}
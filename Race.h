@@ -0,0 +1,157 @@
+#ifndef MEDIEVAL_RACE_H
+#define MEDIEVAL_RACE_H
+
+#include <cstdint>
+#include "Level.h"
+
+namespace medieval {
+
+/**
+ * A race class. This class simulates two players racing through
+ * their own copies of the same level, one tick at a time, from
+ * nothing but each player's input for that tick. The simulation is
+ * deterministic, so two machines given the same inputs stay in
+ * step, and its whole state can be saved, restored and checksummed
+ * to rewind and replay ticks when a late input arrives.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Race {
+public:
+
+  /**
+   * The keys a player is holding during a tick. 
+   */
+  enum Input : std::uint8_t {
+    /** Move left */ LEFT = 1,
+    /** Move right */ RIGHT = 2,
+    /** Jump */ UP = 4
+  };
+
+  /**
+   * The progress of one of the players. 
+   */
+  struct Racer {
+    /** The player's health, lives and score, as in the world */
+    int health = 3;
+    int lives = 5;
+    int score = 0;
+    /** The tick the player reached the end on, or -1 */
+    int finished = -1;
+  };
+
+  /**
+   * The state of the whole race at one moment. 
+   */
+  struct State {
+    /** The state of each player's level */
+    Level::State levels[2];
+    /** The progress of each player */
+    Racer racers[2];
+    /** The number of ticks simulated */
+    int tick = 0;
+  };
+
+  /**
+   * Construct a race through a level. 
+   */
+  Race(/** The level to race through */
+       int level);
+
+  /**
+   * Simulates one tick of the race. 
+   */
+  void step(/** The keys each player is holding, as a combination 
+		of Input values */
+	    const std::uint8_t inputs[2]) noexcept;
+
+  /**
+   * Simulates one tick of a single player's level by the rules of 
+   * the race. 
+   */
+  static void step(/** The player's level */
+		   Level& level,
+		   /** The player's progress */
+		   Racer& racer,
+		   /** The keys the player is holding */
+		   std::uint8_t input,
+		   /** The tick being simulated */
+		   int tick) noexcept;
+
+  /**
+   * Saves the state of the race. 
+   */
+  void save(/** Where to save the state */
+	    State& state) const;
+
+  /**
+   * Restores a state previously saved from this race. 
+   */
+  void restore(/** The state to restore */
+	       const State& state) noexcept;
+
+  /**
+   * Get a checksum of a saved state, which is the same on every 
+   * machine whose race is in the same state. 
+   * @return the checksum of the state
+   */
+  static std::uint64_t checksum(/** The state to checksum */
+				const State& state) noexcept;
+
+  /**
+   * Checks what each player touches against collision masks, as 
+   * Level::setMasks does. 
+   */
+  void setMasks(/** The masks, which must outlive the race, or
+		    nullptr to check the boxes alone */
+		const Masks* masks) noexcept;
+
+  /**
+   * Get one of the players' levels.
+   * @return the level the player is racing through
+   */
+  const Level& getLevel(/** The player */
+			int player) const noexcept;
+
+  /**
+   * Get the progress of one of the players.
+   * @return the player's progress
+   */
+  const Racer& getRacer(/** The player */
+			int player) const noexcept;
+
+  /**
+   * Get the number of ticks simulated.
+   * @return the current tick
+   */
+  int getTick() const noexcept;
+
+  /**
+   * Get whether the race is over, which is when either player has
+   * reached the end or run out of lives. 
+   * @return whether the race is over
+   */
+  bool over() const noexcept;
+
+private:
+
+  /**
+   * Each player's copy of the level
+   */
+  Level levels_[2];
+
+  /**
+   * Each player's progress
+   */
+  Racer racers_[2];
+
+  /**
+   * The number of ticks simulated
+   */
+  int tick_ = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef MEDIEVAL_RENDERMODE_H
+#define MEDIEVAL_RENDERMODE_H
+
+namespace medieval {
+
+/**
+ * Render Mode Enumeration.
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+  
+enum class RenderMode {
+  /** Render into a window with an accelerated, vsynced renderer. */ WINDOW,
+  /** Render into an offscreen surface with the software renderer. */ OFFSCREEN
+};
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef MEDIEVAL_RING_H
+#define MEDIEVAL_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace medieval {
+
+/**
+ * A ring buffer class. This class passes values from one thread to
+ * one other thread without locking or allocating, so that it is 
+ * safe to read from somewhere that must never wait, such as an 
+ * audio callback. Only one thread may push and only one may pop.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+template <typename T, std::size_t Capacity>
+class Ring {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+		"The capacity of a ring must be a power of two");
+public:
+
+  /**
+   * Adds a value to the back of the ring, from the pushing thread.
+   * @return whether there was room for it
+   */
+  bool push(/** The value */ const T& value) noexcept {
+    std::size_t back = back_.load(std::memory_order_relaxed);
+    if (back - front_.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    values_[back & (Capacity - 1)] = value;
+    back_.store(back + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Takes the value from the front of the ring, from the popping 
+   * thread.
+   * @return whether there was one
+   */
+  bool pop(/** Set to the value */ T& value) noexcept {
+    std::size_t front = front_.load(std::memory_order_relaxed);
+    if (front == back_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = values_[front & (Capacity - 1)];
+    front_.store(front + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+
+  /**
+   * The values, which wrap around
+   */
+  T values_[Capacity];
+
+  /**
+   * The number of values ever popped and pushed, each kept on its 
+   * own cache line so the two threads don't slow each other down
+   */
+  std::atomic<std::size_t> front_{0};
+  char frontPadding_[64 - sizeof(std::atomic<std::size_t>)];
+  std::atomic<std::size_t> back_{0};
+  char backPadding_[64 - sizeof(std::atomic<std::size_t>)];
+};
+
+}
+
+#endif
@@ -0,0 +1,283 @@
+#include "Rollback.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * Marks the packets of this game. 
+ */
+static const uint32_t MAGIC = 0x4d44564c;
+
+/**
+ * Writes a value into a packet, least significant byte first. 
+ */
+template <typename T>
+static void put(uint8_t*& bytes, T value) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    *bytes++ = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (i * 8));
+  }
+}
+
+/**
+ * Reads a value from a packet, least significant byte first. 
+ */
+template <typename T>
+static T get(const uint8_t*& bytes) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    value |= static_cast<uint64_t>(*bytes++) << (i * 8);
+  }
+  return static_cast<T>(value);
+}
+
+Rollback::Rollback(int player, int level, unsigned short localPort,
+		   const string& remoteHost, unsigned short remotePort,
+		   int delay, int loss) :
+  race_(level), player_(player), delay_(delay), loss_(loss), random_(player + 1) {
+
+  if (player != 0 && player != 1) {
+    throw domain_error("The player must be 0 or 1");
+  }
+
+  // Look up the remote machine
+
+  addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  addrinfo* address = nullptr;
+  if (getaddrinfo(remoteHost.c_str(), nullptr, &hints, &address) != 0 || !address) {
+    throw domain_error("Unable to find the host " + remoteHost);
+  }
+  memcpy(&remote_, address->ai_addr, sizeof(remote_));
+  remote_.sin_port = htons(remotePort);
+  freeaddrinfo(address);
+
+  // Open a non-blocking socket on the local port
+
+  socket_ = socket(AF_INET, SOCK_DGRAM, 0);
+  if (socket_ < 0) {
+    throw domain_error(string("Unable to open a socket due to: ") + strerror(errno));
+  }
+  sockaddr_in local = {};
+  local.sin_family = AF_INET;
+  local.sin_addr.s_addr = htonl(INADDR_ANY);
+  local.sin_port = htons(localPort);
+  if (::bind(socket_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0 ||
+      fcntl(socket_, F_SETFL, fcntl(socket_, F_GETFL) | O_NONBLOCK) != 0) {
+    string error = strerror(errno);
+    close(socket_);
+    throw domain_error("Unable to listen on port " + to_string(localPort)
+		       + " due to: " + error);
+  }
+}
+
+Rollback::~Rollback() {
+  if (socket_ >= 0) {
+    close(socket_);
+  }
+}
+
+bool Rollback::advance(uint8_t input) {
+  int tick = race_.getTick();
+
+  // Roll back to the first mispredicted tick and resimulate from
+  // there with the real inputs
+
+  int mispredicted = receive();
+  if (mispredicted >= 0) {
+    Clock::time_point start = Clock::now();
+    race_.restore(states_[mispredicted % HISTORY]);
+    for (int t = mispredicted; t < tick; ++t) {
+      simulate(t);
+    }
+    rollbackDepth_ = tick - mispredicted;
+    maxRollbackDepth_ = max(maxRollbackDepth_, rollbackDepth_);
+    ++rollbacks_;
+    resimulationTime_ = chrono::duration<double, milli>(Clock::now() - start).count();
+    maxResimulationTime_ = max(maxResimulationTime_, resimulationTime_);
+  }
+
+  // Wait for the remote player if they are too far behind, since
+  // the ticks to roll back to would be lost from the history
+
+  bool advanced = tick - remoteKnown_ <= MAX_PREDICTION;
+  if (advanced) {
+    localInputs_[tick % HISTORY] = input;
+    simulate(tick);
+  } else {
+    ++stalls_;
+  }
+  check();
+  send();
+  flush();
+  return advanced;
+}
+
+void Rollback::simulate(int tick) {
+  race_.save(states_[tick % HISTORY]);
+
+  // the remote input is predicted to be the last one known
+  uint8_t remote = 0;
+  if (tick <= remoteKnown_) {
+    remote = remoteInputs_[tick % HISTORY];
+  } else if (remoteKnown_ >= 0) {
+    remote = remoteInputs_[remoteKnown_ % HISTORY];
+  }
+  usedInputs_[tick % HISTORY] = remote;
+
+  uint8_t inputs[2];
+  inputs[player_] = localInputs_[tick % HISTORY];
+  inputs[1 - player_] = remote;
+  race_.step(inputs);
+}
+
+int Rollback::receive() noexcept {
+  int tick = race_.getTick();
+  int mispredicted = -1;
+  uint8_t bytes[PACKET_SIZE];
+  for (;;) {
+    ssize_t size = recv(socket_, bytes, sizeof(bytes), 0);
+    if (size < 0) {
+      break;
+    }
+
+    // ignore anything that isn't a whole packet of ours
+    const uint8_t* read = bytes;
+    if (size < 9 || get<uint32_t>(read) != MAGIC) {
+      continue;
+    }
+    int first = get<int32_t>(read);
+    int count = get<uint8_t>(read);
+    if (count > MAX_INPUTS || size != 9 + count + 16) {
+      continue;
+    }
+
+    // take the inputs that follow on from those already known,
+    // noting any that differ from what was predicted
+    for (int t = first; t < first + count; ++t) {
+      uint8_t input = *read++;
+      if (t == remoteKnown_ + 1 && t > tick - HISTORY) {
+	remoteInputs_[t % HISTORY] = input;
+	remoteKnown_ = t;
+	if (t < tick && usedInputs_[t % HISTORY] != input && mispredicted < 0) {
+	  mispredicted = t;
+	}
+      }
+    }
+    remoteAck_ = max(remoteAck_, static_cast<int>(get<int32_t>(read)));
+    int checksumTick = get<int32_t>(read);
+    uint64_t checksum = get<uint64_t>(read);
+    if (checksumTick > remoteChecksumTick_) {
+      remoteChecksumTick_ = checksumTick;
+      remoteChecksum_ = checksum;
+    }
+  }
+  return mispredicted;
+}
+
+void Rollback::send() {
+  int tick = race_.getTick();
+  int first = max(remoteAck_ + 1, tick - MAX_INPUTS);
+  int count = tick - first;
+
+  // some packets are lost on purpose to simulate a poor connection
+  if (loss_ > 0 && static_cast<int>(random_() % 100) < loss_) {
+    return;
+  }
+
+  Packet packet;
+  packet.due = Clock::now() + chrono::milliseconds(delay_);
+  uint8_t* write = packet.bytes;
+  put<uint32_t>(write, MAGIC);
+  put<int32_t>(write, first);
+  put<uint8_t>(write, count);
+  for (int t = first; t < tick; ++t) {
+    *write++ = localInputs_[t % HISTORY];
+  }
+  put<int32_t>(write, remoteKnown_);
+  put<int32_t>(write, checksummed_);
+  put<uint64_t>(write, checksummed_ >= 0 ? checksums_[checksummed_ % HISTORY] : 0);
+  packet.size = write - packet.bytes;
+  outgoing_.push_back(packet);
+}
+
+void Rollback::flush() noexcept {
+  Clock::time_point now = Clock::now();
+  while (!outgoing_.empty() && outgoing_.front().due <= now) {
+    const Packet& packet = outgoing_.front();
+    sendto(socket_, packet.bytes, packet.size, 0,
+	   reinterpret_cast<const sockaddr*>(&remote_), sizeof(remote_));
+    outgoing_.pop_front();
+  }
+}
+
+void Rollback::check() noexcept {
+  // the state before a tick is final once the remote input for
+  // every tick before it is known
+  int confirmed = min(remoteKnown_ + 1, race_.getTick() - 1);
+  for (int t = max(checksummed_ + 1, race_.getTick() - HISTORY); t <= confirmed; ++t) {
+    checksums_[t % HISTORY] = Race::checksum(states_[t % HISTORY]);
+    checksummed_ = t;
+  }
+
+  // compare with the remote side's latest checksum if it is for a
+  // tick that still has one here
+  if (remoteChecksumTick_ >= 0 && remoteChecksumTick_ <= checksummed_ &&
+      remoteChecksumTick_ > checksummed_ - HISTORY &&
+      checksums_[remoteChecksumTick_ % HISTORY] != remoteChecksum_) {
+    desynced_ = true;
+  }
+}
+
+const Race& Rollback::getRace() const noexcept {
+  return race_;
+}
+
+void Rollback::setMasks(const Masks* masks) noexcept {
+  race_.setMasks(masks);
+}
+
+int Rollback::getPlayer() const noexcept {
+  return player_;
+}
+
+int Rollback::getRollbackDepth() const noexcept {
+  return rollbackDepth_;
+}
+
+int Rollback::getMaxRollbackDepth() const noexcept {
+  return maxRollbackDepth_;
+}
+
+int Rollback::getRollbacks() const noexcept {
+  return rollbacks_;
+}
+
+double Rollback::getResimulationTime() const noexcept {
+  return resimulationTime_;
+}
+
+double Rollback::getMaxResimulationTime() const noexcept {
+  return maxResimulationTime_;
+}
+
+int Rollback::getStalls() const noexcept {
+  return stalls_;
+}
+
+int Rollback::getConfirmedTick() const noexcept {
+  return remoteKnown_;
+}
+
+bool Rollback::desynced() const noexcept {
+  return desynced_;
+}
@@ -0,0 +1,285 @@
+#ifndef MEDIEVAL_ROLLBACK_H
+#define MEDIEVAL_ROLLBACK_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <netinet/in.h>
+#include "Race.h"
+
+namespace medieval {
+
+/**
+ * A rollback class. This class plays one side of a race against
+ * another machine over UDP. Every tick it simulates the race straight
+ * away with the local player's input and a prediction of the remote
+ * player's, which is assumed to be whatever they held last. When the
+ * remote player's real input for a tick arrives and differs from the
+ * prediction, the race is rolled back to that tick and resimulated up
+ * to the present within the same frame. Checksums of confirmed ticks
+ * are exchanged to detect the two sides drifting apart.
+ *
+ * Outgoing packets can be held back and randomly dropped to simulate
+ * a poor connection when testing on loopback.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Rollback {
+public:
+
+  /**
+   * The number of ticks of inputs and saved states kept. 
+   */
+  static const int HISTORY = 64;
+
+  /**
+   * The furthest the race may get ahead of the last confirmed remote
+   * input before it waits for the remote player to catch up. 
+   */
+  static const int MAX_PREDICTION = 12;
+
+  /**
+   * The most inputs sent in one packet. Every input the remote side
+   * has not acknowledged is resent, so lost packets need no special
+   * handling. 
+   */
+  static const int MAX_INPUTS = 48;
+
+  /**
+   * Construct one side of a race, listening on the local port. 
+   * @throw domain_error if the player is not 0 or 1, or the socket
+   * could not be set up
+   */
+  Rollback(/** Which player is local, 0 or 1 */
+	   int player,
+	   /** The level to race through */
+	   int level,
+	   /** The port to listen on */
+	   unsigned short localPort,
+	   /** The remote machine's host name or address, and port */
+	   const std::string& remoteHost, unsigned short remotePort,
+	   /** Milliseconds to hold back every outgoing packet */
+	   int delay = 0,
+	   /** The percentage of outgoing packets to drop */
+	   int loss = 0);
+
+  /**
+   * Close the socket. 
+   */
+  ~Rollback();
+
+  Rollback(const Rollback&) = delete;
+  Rollback& operator=(const Rollback&) = delete;
+
+  /**
+   * Advance the race by one tick, first rolling back and
+   * resimulating any ticks that were predicted wrongly. 
+   * @return whether the race advanced, which it does not while 
+   * waiting for the remote player to catch up
+   */
+  bool advance(/** The keys the local player is holding, as a 
+		   combination of Race::Input values */
+	       std::uint8_t input);
+
+  /**
+   * Get the race as it currently stands. 
+   * @return the race
+   */
+  const Race& getRace() const noexcept;
+
+  /**
+   * Checks what the players touch against collision masks. Both
+   * sides must use the same masks to stay in step.
+   */
+  void setMasks(/** The masks, which must outlive the race */
+		const Masks* masks) noexcept;
+
+  /**
+   * Get which player is local.
+   * @return 0 or 1
+   */
+  int getPlayer() const noexcept;
+
+  /**
+   * Get the number of ticks resimulated by the last rollback.
+   * @return the last rollback depth
+   */
+  int getRollbackDepth() const noexcept;
+
+  /**
+   * Get the largest number of ticks resimulated by one rollback.
+   * @return the largest rollback depth
+   */
+  int getMaxRollbackDepth() const noexcept;
+
+  /**
+   * Get the number of rollbacks so far.
+   * @return the number of rollbacks
+   */
+  int getRollbacks() const noexcept;
+
+  /**
+   * Get how long the last rollback took to resimulate. 
+   * @return the time in milliseconds
+   */
+  double getResimulationTime() const noexcept;
+
+  /**
+   * Get the longest any rollback took to resimulate. 
+   * @return the time in milliseconds
+   */
+  double getMaxResimulationTime() const noexcept;
+
+  /**
+   * Get the number of times the race waited for the remote player.
+   * @return the number of stalled ticks
+   */
+  int getStalls() const noexcept;
+
+  /**
+   * Get the last tick the remote player's input is known for.
+   * @return the last confirmed tick, or -1
+   */
+  int getConfirmedTick() const noexcept;
+
+  /**
+   * Get whether the two sides' races have been found to differ. 
+   * @return whether the races are out of sync
+   */
+  bool desynced() const noexcept;
+
+private:
+
+  /**
+   * The clock used for delays and timing. 
+   */
+  typedef std::chrono::steady_clock Clock;
+
+  /**
+   * The largest packet sent. 
+   */
+  static const int PACKET_SIZE = 4 + 4 + 1 + MAX_INPUTS + 4 + 4 + 8;
+
+  /**
+   * A packet waiting to be sent. 
+   */
+  struct Packet {
+    /** When to send it */
+    Clock::time_point due;
+    /** The number of bytes in it */
+    int size;
+    /** Its contents */
+    std::uint8_t bytes[PACKET_SIZE];
+  };
+
+  /**
+   * The race being played
+   */
+  Race race_;
+
+  /**
+   * Which player is local
+   */
+  int player_;
+
+  /**
+   * The socket and the remote address
+   */
+  int socket_ = -1;
+  sockaddr_in remote_;
+
+  /**
+   * The simulated delay in milliseconds and loss percentage
+   */
+  int delay_;
+  int loss_;
+
+  /**
+   * Packets waiting for their simulated delay to pass
+   */
+  std::deque<Packet> outgoing_;
+
+  /**
+   * Decides which packets are lost
+   */
+  std::minstd_rand random_;
+
+  /**
+   * The local and remote inputs, the remote input each tick was
+   * last simulated with, and the state before each tick, by tick
+   */
+  std::uint8_t localInputs_[HISTORY] = {};
+  std::uint8_t remoteInputs_[HISTORY] = {};
+  std::uint8_t usedInputs_[HISTORY] = {};
+  Race::State states_[HISTORY];
+
+  /**
+   * The checksum of the state before each confirmed tick, by tick
+   */
+  std::uint64_t checksums_[HISTORY] = {};
+
+  /**
+   * The last tick the remote input is known for, and the last tick
+   * the remote side has acknowledged receiving local input for
+   */
+  int remoteKnown_ = -1;
+  int remoteAck_ = -1;
+
+  /**
+   * The last tick whose checksum has been taken
+   */
+  int checksummed_ = -1;
+
+  /**
+   * The latest checksum received from the remote side and its tick
+   */
+  int remoteChecksumTick_ = -1;
+  std::uint64_t remoteChecksum_ = 0;
+
+  /**
+   * Rollback statistics
+   */
+  int rollbackDepth_ = 0;
+  int maxRollbackDepth_ = 0;
+  int rollbacks_ = 0;
+  double resimulationTime_ = 0;
+  double maxResimulationTime_ = 0;
+  int stalls_ = 0;
+  bool desynced_ = false;
+
+  /**
+   * Simulates a tick, saving the state before it. 
+   */
+  void simulate(/** The tick to simulate */
+		int tick);
+
+  /**
+   * Reads every packet that has arrived. 
+   * @return the earliest simulated tick whose remote input turned 
+   * out to be mispredicted, or -1 if there is none
+   */
+  int receive() noexcept;
+
+  /**
+   * Queues a packet with every unacknowledged local input. 
+   */
+  void send();
+
+  /**
+   * Sends the queued packets whose delay has passed. 
+   */
+  void flush() noexcept;
+
+  /**
+   * Takes the checksums of newly confirmed ticks and compares them
+   * with the remote side's. 
+   */
+  void check() noexcept;
+};
+
+}
+
+#endif
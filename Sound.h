@@ -0,0 +1,22 @@
+#ifndef MEDIEVAL_SOUND_H
+#define MEDIEVAL_SOUND_H
+
+namespace medieval {
+
+/**
+ * Sound Enumeration.
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+  
+enum class Sound {
+  /** The player leaving the ground. */ JUMP,
+  /** The player touching an obstacle. */ DAMAGE,
+  /** The player picking up a coin. */ COIN,
+  /** The player picking up health. */ HEALTH,
+  /** The player reaching the end of a level. */ LEVEL,
+  /** The number of sounds. */ COUNT
+};
+
+}
+
+#endif
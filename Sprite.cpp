@@ -38,16 +38,30 @@ int Sprite::getImageIndex() const noexcept {
 
 void Sprite::move() noexcept {}
 
+void Sprite::save(SpriteState& state) const noexcept {
+  state.imageIndex = imageIndex_;
+  state.x = x_;
+  state.y = y_;
+  state.angle = angle_;
+}
+
+void Sprite::restore(const SpriteState& state) noexcept {
+  imageIndex_ = state.imageIndex;
+  x_ = state.x;
+  y_ = state.y;
+  angle_ = state.angle;
+}
+
 bool Sprite::hits(const Sprite& other) const noexcept {
   // creates hitboxes to calculate whether the two sprites collide
-  vector<int> hitbox1 = {x_, x_ + width_, y_, y_ + width_};
-  vector<int> hitbox2 = {other.getXCoordinate(),
-			 other.getXCoordinate() + other.getWidth(),
-			 other.getYCoordinate(),
-			 other.getYCoordinate() + other.getHeight()};
+  int hitbox1[4] = {x_, x_ + width_, y_, y_ + width_};
+  int hitbox2[4] = {other.getXCoordinate(),
+		    other.getXCoordinate() + other.getWidth(),
+		    other.getYCoordinate(),
+		    other.getYCoordinate() + other.getHeight()};
   // uses the hitboxes to return the collision status
-  return (hitbox1.at(0) < hitbox2.at(1) &&
-	  hitbox1.at(1) > hitbox2.at(0) &&
-	  hitbox1.at(2) < hitbox2.at(3) &&
-	  hitbox1.at(3) > hitbox2.at(2));  
+  return (hitbox1[0] < hitbox2[1] &&
+	  hitbox1[1] > hitbox2[0] &&
+	  hitbox1[2] < hitbox2[3] &&
+	  hitbox1[3] > hitbox2[2]);  
 }
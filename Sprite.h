@@ -3,6 +3,26 @@
 
 namespace medieval {
 
+/**
+ * The state of a sprite at one moment, which can be saved and 
+ * later restored. The fields past the angle are only used by the 
+ * kinds of sprites that have that state. 
+ */
+struct SpriteState {
+  /** The image index, position and angle of the sprite */
+  int imageIndex = 0;
+  int x = 0;
+  int y = 0;
+  int angle = 0;
+  /** The horizontal and vertical momentum of a player */
+  int speedH = 0;
+  int speedV = 0;
+  /** Whether a player is in the air */
+  bool inAir = false;
+  /** Whether a ball is moving left */
+  bool left = false;
+};
+
 /**
  * A sprite class. This class represents a basic sprite and is 
  * a super class to more specific instantiations such as fireballs
@@ -72,6 +92,18 @@ public:
    */
   virtual void move() noexcept;
 
+  /**
+   * Saves the state of the sprite. 
+   */
+  virtual void save(/** Where to save the state */
+		    SpriteState& state) const noexcept;
+
+  /**
+   * Restores a previously saved state of the sprite. 
+   */
+  virtual void restore(/** The state to restore */
+		       const SpriteState& state) noexcept;
+
 protected:
   
   /** 
@@ -0,0 +1,104 @@
+#include "Telemetry.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * Marks a segment as telemetry, changing whenever the counters do.
+ */
+static const uint64_t MAGIC = 0x4d45444956414c00 + sizeof(Telemetry::Counters);
+
+Telemetry::Telemetry(const string& name, bool write) :
+  name_(name), write_(write), process_(getpid()) {
+  static_assert(sizeof(Counters) == WORDS * sizeof(uint64_t), "Every counter must be 64 bits");
+  static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The counters must be shared without locks");
+
+  // the writer makes a new segment, so that one left behind by a
+  // game that crashed is never mixed up with this one
+  if (write) {
+    shm_unlink(name.c_str());
+  }
+  int file = shm_open(name.c_str(), write ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0644);
+  if (file < 0) {
+    throw domain_error("Unable to open the telemetry segment " + name + " due to: " +
+		       strerror(errno));
+  }
+  struct stat status;
+  if ((write && ftruncate(file, sizeof(Segment)) != 0) || fstat(file, &status) != 0 ||
+      status.st_size < static_cast<off_t>(sizeof(Segment))) {
+    ::close(file);
+    if (write) {
+      shm_unlink(name.c_str());
+    }
+    throw domain_error("The telemetry segment " + name + " is the wrong size");
+  }
+  void* memory = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  ::close(file);
+  if (memory == MAP_FAILED) {
+    if (write) {
+      shm_unlink(name.c_str());
+    }
+    throw domain_error("Unable to map the telemetry segment " + name + " due to: " +
+		       strerror(errno));
+  }
+  segment_ = static_cast<Segment*>(memory);
+
+  // a new segment is all zeros, which is a sequence of nothing shared
+  if (write) {
+    segment_->magic = MAGIC;
+  } else if (segment_->magic != MAGIC) {
+    munmap(segment_, sizeof(Segment));
+    throw domain_error(name + " isn't telemetry from this version of the game");
+  }
+}
+
+Telemetry::~Telemetry() {
+  munmap(segment_, sizeof(Segment));
+  if (write_) {
+    shm_unlink(name_.c_str());
+  }
+}
+
+void Telemetry::publish(const Counters& counters) noexcept {
+  Counters shared = counters;
+  shared.process = process_;
+  uint64_t words[WORDS];
+  memcpy(words, &shared, sizeof(words));
+
+  // the sequence is odd while the counters are written, and the
+  // fence keeps their stores after it goes odd
+  uint64_t sequence = segment_->sequence.load(memory_order_relaxed);
+  segment_->sequence.store(sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  for (int i = 0; i < WORDS; ++i) {
+    segment_->words[i].store(words[i], memory_order_relaxed);
+  }
+  segment_->sequence.store(sequence + 2, memory_order_release);
+}
+
+int64_t Telemetry::read(Counters& counters) const noexcept {
+  uint64_t words[WORDS];
+  for (;;) {
+    uint64_t before = segment_->sequence.load(memory_order_acquire);
+    if (before % 2 == 0) {
+      for (int i = 0; i < WORDS; ++i) {
+	words[i] = segment_->words[i].load(memory_order_relaxed);
+      }
+      atomic_thread_fence(memory_order_acquire);
+      if (segment_->sequence.load(memory_order_relaxed) == before) {
+	memcpy(&counters, words, sizeof(words));
+	return static_cast<int64_t>(before / 2);
+      }
+    }
+    sched_yield();
+  }
+}
@@ -0,0 +1,144 @@
+#ifndef MEDIEVAL_TELEMETRY_H
+#define MEDIEVAL_TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace medieval {
+
+/**
+ * A telemetry class. This class shares a few counters about how the
+ * game is running through a POSIX shared memory segment, so that a
+ * separate process can watch them live. The game writes them once a
+ * frame behind a sequence number that is odd while it writes, and a
+ * reader copies them out and tries again if the number was odd or
+ * changed, so neither side ever waits for the other. Publishing is
+ * a few stores to memory, with no system calls and no allocation.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Telemetry {
+public:
+
+  /**
+   * The counters shared. Every one is 64 bits, so that they copy in
+   * and out of the segment as whole words.
+   */
+  struct Counters {
+    /** The process writing them, which is filled in as they are
+	shared */
+    std::int64_t process = 0;
+    /** The number of frames drawn */
+    std::int64_t frames = 0;
+    /** The level, which is 0 on the title screen, -1 on the game over
+	screen and -2 on the win screen */
+    std::int64_t level = 0;
+    /** The median, 90th and 99th percentile and longest of the
+	times taken by recent frames, in milliseconds */
+    double frame50 = 0;
+    double frame90 = 0;
+    double frame99 = 0;
+    double frameMax = 0;
+    /** How long the last frame took to simulate and to draw, in
+	milliseconds */
+    double simulate = 0;
+    double draw = 0;
+    /** The number of times the last frame drew something */
+    std::int64_t drawCalls = 0;
+    /** The number of sprites in the level, and those awake */
+    std::int64_t sprites = 0;
+    std::int64_t awake = 0;
+    /** The number of heap allocations the last frame made */
+    std::int64_t allocations = 0;
+    /** The fraction of the resolution the level is drawn at */
+    double scale = 0;
+    /** How long updating the particles took, averaged over about
+	the last second, in milliseconds */
+    double effects = 0;
+    /** How many seconds of the level can be run backwards */
+    double rewind = 0;
+  };
+
+  /**
+   * Construct a segment to write to, replacing any of the same name,
+   * or open one to read from.
+   * @throw domain_error if the segment can't be made or opened, or
+   * one opened isn't telemetry.
+   */
+  Telemetry(/** The name of the segment, starting with a slash */
+	    const std::string& name,
+	    /** Whether to write to it rather than read from it */
+	    bool write);
+
+  /**
+   * The segment is mapped by address, so it can't be copied.
+   */
+  Telemetry(const Telemetry&) = delete;
+  Telemetry& operator=(const Telemetry&) = delete;
+
+  /**
+   * Unmap the segment, and remove it if it was written to.
+   */
+  ~Telemetry();
+
+  /**
+   * Shares a new set of counters.
+   */
+  void publish(/** The counters */
+	       const Counters& counters) noexcept;
+
+  /**
+   * Copies out the counters last shared, trying again while they are
+   * being written.
+   * @return the number of times they have been shared, or 0 if they
+   * never have
+   */
+  std::int64_t read(/** Set to the counters */
+		    Counters& counters) const noexcept;
+
+private:
+
+  /**
+   * The number of words of counters.
+   */
+  static const int WORDS = sizeof(Counters) / sizeof(std::uint64_t);
+
+  /**
+   * What is in the segment
+   */
+  struct Segment {
+    /** Marks the segment as telemetry of this layout */
+    std::uint64_t magic;
+    /** Twice the number of times the counters have been shared, plus
+	one while they are being written */
+    std::atomic<std::uint64_t> sequence;
+    /** The counters, word by word */
+    std::atomic<std::uint64_t> words[WORDS];
+  };
+
+  /**
+   * The name of the segment
+   */
+  std::string name_;
+
+  /**
+   * Whether this side writes to the segment
+   */
+  bool write_;
+
+  /**
+   * The segment mapped into memory
+   */
+  Segment* segment_ = nullptr;
+
+  /**
+   * The process this is
+   */
+  std::int64_t process_;
+};
+
+}
+
+#endif
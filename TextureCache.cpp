@@ -0,0 +1,152 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+
+using namespace std;
+using namespace medieval;
+
+TextureCache::TextureCache(Loader load, Unloader unload, size_t budget) noexcept :
+  load_(load), unload_(unload), budget_(budget) {
+}
+
+int TextureCache::add() {
+  entries_.emplace_back();
+  return static_cast<int>(entries_.size()) - 1;
+}
+
+int TextureCache::size() const noexcept {
+  return static_cast<int>(entries_.size());
+}
+
+SDL_Texture* TextureCache::get(int id) noexcept {
+  if (id < 0 || id >= size()) {
+    return nullptr;
+  }
+  Entry& entry = entries_[id];
+  entry.used = ++clock_;
+  if (entry.texture) {
+    ++stats_.hits;
+  } else {
+    ++stats_.misses;
+    if (!load(id)) {
+      return nullptr;
+    }
+    trim(id);
+  }
+  return entry.texture;
+}
+
+void TextureCache::hold(int id) noexcept {
+  if (id < 0 || id >= size()) {
+    return;
+  }
+  Entry& entry = entries_[id];
+  ++entry.holds;
+  entry.used = ++clock_;
+  if (!entry.texture && load(id)) {
+    trim();
+  }
+}
+
+void TextureCache::release(int id) noexcept {
+  if (id < 0 || id >= size() || entries_[id].holds == 0) {
+    return;
+  }
+  if (--entries_[id].holds == 0) {
+    trim();
+  }
+}
+
+void TextureCache::prefetch(int id) noexcept {
+  if (id < 0 || id >= size() || entries_[id].texture || stats_.bytes >= budget_) {
+    return;
+  }
+  entries_[id].used = ++clock_;
+  if (load(id)) {
+    ++stats_.prefetches;
+    trim(id);
+  }
+}
+
+bool TextureCache::isLoaded(int id) const noexcept {
+  return id >= 0 && id < size() && entries_[id].texture;
+}
+
+int TextureCache::getHolds(int id) const noexcept {
+  return id >= 0 && id < size() ? entries_[id].holds : 0;
+}
+
+size_t TextureCache::getBytes(int id) const noexcept {
+  return id >= 0 && id < size() ? entries_[id].bytes : 0;
+}
+
+void TextureCache::setBudget(size_t budget) noexcept {
+  budget_ = budget;
+  trim();
+}
+
+size_t TextureCache::getBudget() const noexcept {
+  return budget_;
+}
+
+const TextureCache::Stats& TextureCache::getStats() const noexcept {
+  return stats_;
+}
+
+void TextureCache::clear() noexcept {
+  for (int id = 0; id < size(); ++id) {
+    if (entries_[id].texture) {
+      unload(id);
+    }
+  }
+  entries_.clear();
+}
+
+bool TextureCache::load(int id) noexcept {
+  Entry& entry = entries_[id];
+  if (entry.failed) {
+    return false;
+  }
+  size_t bytes = 0;
+  entry.texture = load_(id, bytes);
+  if (!entry.texture) {
+    entry.failed = true;
+    ++stats_.failures;
+    return false;
+  }
+  entry.bytes = bytes;
+  ++stats_.loads;
+  ++stats_.resident;
+  stats_.bytes += bytes;
+  stats_.peak = max(stats_.peak, stats_.bytes);
+  return true;
+}
+
+void TextureCache::unload(int id) noexcept {
+  Entry& entry = entries_[id];
+  unload_(id, entry.texture);
+  entry.texture = nullptr;
+  --stats_.resident;
+  stats_.bytes -= entry.bytes;
+  entry.bytes = 0;
+}
+
+void TextureCache::trim(int keep) noexcept {
+  // there are only ever a few images, so the one used longest ago
+  // is found by looking at them all
+  while (stats_.bytes > budget_) {
+    int oldest = -1;
+    for (int id = 0; id < size(); ++id) {
+      const Entry& entry = entries_[id];
+      if (entry.texture && entry.holds == 0 && id != keep &&
+	  (oldest < 0 || entry.used < entries_[oldest].used)) {
+	oldest = id;
+      }
+    }
+    if (oldest < 0) {
+      return;
+    }
+    unload(oldest);
+    ++stats_.evictions;
+  }
+}
@@ -0,0 +1,232 @@
+#ifndef MEDIEVAL_TEXTURECACHE_H
+#define MEDIEVAL_TEXTURECACHE_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+struct SDL_Texture;
+
+namespace medieval {
+
+/**
+ * A texture cache class. This class keeps track of which images are
+ * loaded into textures, so that only those the game needs take up
+ * memory. Each image is loaded the first time it is needed, and
+ * stays loaded while a screen holds it. Images no screen holds are
+ * kept too, in case they are needed again, until the textures loaded
+ * go over a budget, when those used longest ago are unloaded first.
+ * Images can also be loaded ahead of time, ready for the next screen.
+ * Getting a texture that is loaded is only a lookup, so drawing
+ * doesn't slow down.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class TextureCache {
+public:
+
+  /**
+   * Loads an image into a texture.
+   * @return the texture, or nullptr if it couldn't be loaded
+   */
+  typedef std::function<SDL_Texture*(/** The number of the image */
+				     int id,
+				     /** Set to the memory the texture
+					 takes */
+				     std::size_t& bytes)> Loader;
+
+  /**
+   * Unloads an image's texture.
+   */
+  typedef std::function<void(/** The number of the image */
+			     int id,
+			     /** Its texture */
+			     SDL_Texture* texture)> Unloader;
+
+  /**
+   * How the cache has been used.
+   */
+  struct Stats {
+    /** The number of textures got that were loaded, and that had
+	to be loaded */
+    long hits = 0;
+    long misses = 0;
+    /** The number of images loaded for any reason, and of those
+	the number loaded ahead of time */
+    long loads = 0;
+    long prefetches = 0;
+    /** The number of images unloaded to stay in budget */
+    long evictions = 0;
+    /** The number of images that couldn't be loaded */
+    long failures = 0;
+    /** The number of images loaded now, and the memory they take */
+    int resident = 0;
+    std::size_t bytes = 0;
+    /** The most memory they have taken at once */
+    std::size_t peak = 0;
+  };
+
+  /**
+   * Construct an empty cache.
+   */
+  TextureCache(/** Loads images */
+	       Loader load,
+	       /** Unloads them */
+	       Unloader unload,
+	       /** The memory the images no screen holds can be kept
+		   loaded within, in bytes */
+	       std::size_t budget) noexcept;
+
+  /**
+   * Adds an image, which isn't loaded until it is needed.
+   * @return its number, which counts up from 0
+   */
+  int add();
+
+  /**
+   * Get the number of images.
+   * @return the number of images
+   */
+  int size() const noexcept;
+
+  /**
+   * Get an image's texture, loading it if it isn't loaded.
+   * @return the texture, or nullptr if it can't be loaded
+   */
+  SDL_Texture* get(/** The number of the image */
+		   int id) noexcept;
+
+  /**
+   * Holds an image loaded until it is released, loading it now if
+   * it isn't.
+   */
+  void hold(/** The number of the image */
+	    int id) noexcept;
+
+  /**
+   * Lets go of an image held, which can then be unloaded to stay in
+   * budget once nothing else holds it.
+   */
+  void release(/** The number of the image */
+	       int id) noexcept;
+
+  /**
+   * Loads an image ahead of time if there is room in the budget for
+   * it, without holding it.
+   */
+  void prefetch(/** The number of the image */
+		int id) noexcept;
+
+  /**
+   * Get whether an image is loaded.
+   * @return whether it is loaded
+   */
+  bool isLoaded(/** The number of the image */
+		int id) const noexcept;
+
+  /**
+   * Get the number of times an image is held.
+   * @return the number of times it is held
+   */
+  int getHolds(/** The number of the image */
+	       int id) const noexcept;
+
+  /**
+   * Get the memory an image's texture takes.
+   * @return the bytes, or 0 if it isn't loaded
+   */
+  std::size_t getBytes(/** The number of the image */
+		       int id) const noexcept;
+
+  /**
+   * Changes the budget, unloading images that no longer fit.
+   */
+  void setBudget(/** The budget in bytes */
+		 std::size_t budget) noexcept;
+
+  /**
+   * Get the budget.
+   * @return the budget in bytes
+   */
+  std::size_t getBudget() const noexcept;
+
+  /**
+   * Get how the cache has been used.
+   * @return the statistics
+   */
+  const Stats& getStats() const noexcept;
+
+  /**
+   * Unloads every image and forgets them all.
+   */
+  void clear() noexcept;
+
+private:
+
+  /**
+   * An image
+   */
+  struct Entry {
+    /** Its texture, or nullptr if it isn't loaded */
+    SDL_Texture* texture = nullptr;
+    /** The memory its texture takes */
+    std::size_t bytes = 0;
+    /** The number of times it is held */
+    int holds = 0;
+    /** When it was last used */
+    unsigned long used = 0;
+    /** Whether it couldn't be loaded, so isn't tried again */
+    bool failed = false;
+  };
+
+  /**
+   * Loads and unloads images
+   */
+  Loader load_;
+  Unloader unload_;
+
+  /**
+   * The images, by number
+   */
+  std::vector<Entry> entries_;
+
+  /**
+   * The budget in bytes
+   */
+  std::size_t budget_;
+
+  /**
+   * Counts up every time an image is used
+   */
+  unsigned long clock_ = 0;
+
+  /**
+   * How the cache has been used
+   */
+  Stats stats_;
+
+  /**
+   * Loads an image that isn't loaded.
+   * @return whether it was loaded
+   */
+  bool load(/** The number of the image */
+	    int id) noexcept;
+
+  /**
+   * Unloads an image that is loaded.
+   */
+  void unload(/** The number of the image */
+	      int id) noexcept;
+
+  /**
+   * Unloads the images no one holds, used longest ago first, until
+   * those loaded are within budget.
+   */
+  void trim(/** An image to keep loaded anyway, or -1 */
+	    int keep = -1) noexcept;
+};
+
+}
+
+#endif
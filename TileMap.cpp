@@ -0,0 +1,106 @@
+#include "TileMap.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * Divides, rounding down rather than towards 0. 
+ */
+static int floorDivide(int a, int b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+TileMap::TileMap(int originX, int originY, const vector<pair<int, int>>& tiles) :
+  originX_(floorDivide(originX, TILE) * -TILE + originX),
+  originY_(floorDivide(originY, TILE) * -TILE + originY) {
+  if (tiles.empty()) {
+    return;
+  }
+
+  // find the columns and rows the tiles cover
+  int minColumn = INT_MAX;
+  int maxColumn = INT_MIN;
+  int minRow = INT_MAX;
+  int maxRow = INT_MIN;
+  for (const pair<int, int>& tile : tiles) {
+    minColumn = min(minColumn, getColumn(tile.first));
+    maxColumn = max(maxColumn, getColumn(tile.first));
+    minRow = min(minRow, getRow(tile.second));
+    maxRow = max(maxRow, getRow(tile.second));
+  }
+  column_ = minColumn;
+  row_ = minRow;
+  columns_ = maxColumn - minColumn + 1;
+  rows_ = maxRow - minRow + 1;
+  words_ = (columns_ + 63) / 64;
+  cells_.assign(static_cast<size_t>(words_) * rows_, 0);
+
+  for (const pair<int, int>& tile : tiles) {
+    int column = getColumn(tile.first) - column_;
+    int row = getRow(tile.second) - row_;
+    uint64_t& word = cells_[static_cast<size_t>(row) * words_ + column / 64];
+    uint64_t bit = uint64_t(1) << (column % 64);
+    if (!(word & bit)) {
+      word |= bit;
+      ++count_;
+    }
+  }
+}
+
+bool TileMap::aligned(int x, int y) const noexcept {
+  return getX(getColumn(x)) == x && getY(getRow(y)) == y;
+}
+
+bool TileMap::find(int left, int top, int right, int bottom, int& x, int& y) const noexcept {
+  // the cells whose corners are inside the rectangle
+  int firstColumn = max(getColumn(left - 1) + 1, column_);
+  int lastColumn = min(getColumn(right), column_ + columns_ - 1);
+  int firstRow = max(getRow(top - 1) + 1, row_);
+  int lastRow = min(getRow(bottom), row_ + rows_ - 1);
+  for (int row = firstRow; row <= lastRow; ++row) {
+    for (int column = firstColumn; column <= lastColumn; ++column) {
+      if (at(column, row)) {
+	x = getX(column);
+	y = getY(row);
+	return true;
+      }
+    }
+  }
+  return false;
+}
+
+int TileMap::getColumn(int x) const noexcept {
+  return floorDivide(x - originX_, TILE);
+}
+
+int TileMap::getRow(int y) const noexcept {
+  return floorDivide(y - originY_, TILE);
+}
+
+int TileMap::getX(int column) const noexcept {
+  return column * TILE + originX_;
+}
+
+int TileMap::getY(int row) const noexcept {
+  return row * TILE + originY_;
+}
+
+bool TileMap::at(int column, int row) const noexcept {
+  column -= column_;
+  row -= row_;
+  if (column < 0 || column >= columns_ || row < 0 || row >= rows_) {
+    return false;
+  }
+  return (cells_[static_cast<size_t>(row) * words_ + column / 64] >> (column % 64)) & 1;
+}
+
+int TileMap::getCount() const noexcept {
+  return count_;
+}
+
+size_t TileMap::getBytes() const noexcept {
+  return cells_.size() * sizeof(uint64_t);
+}
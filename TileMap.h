@@ -0,0 +1,135 @@
+#ifndef MEDIEVAL_TILEMAP_H
+#define MEDIEVAL_TILEMAP_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace medieval {
+
+/**
+ * A tile map class. This class stores the platform tiles of a level
+ * that line up on a grid of tile sized cells, one bit per cell, so
+ * that whether there is a tile near a point can be answered by
+ * looking at a few cells rather than every sprite in the level. 
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class TileMap {
+public:
+
+  /**
+   * The width and height of a tile and a cell. 
+   */
+  static const int TILE = 50;
+
+  /**
+   * Construct an empty map. 
+   */
+  TileMap() = default;
+
+  /**
+   * Construct a map of tiles. 
+   */
+  TileMap(/** A point on the grid, which every tile's top left 
+	      corner must be on */
+	  int originX, int originY,
+	  /** The top left corner of each tile */
+	  const std::vector<std::pair<int, int>>& tiles);
+
+  /**
+   * Get whether a tile's top left corner is on the grid.
+   * @return whether the point lines up with the grid
+   */
+  bool aligned(/** The point */
+	       int x, int y) const noexcept;
+
+  /**
+   * Find a tile whose top left corner is within a rectangle.
+   * @return whether there is one
+   */
+  bool find(/** The top left and bottom right of the rectangle, 
+		inclusive */
+	    int left, int top, int right, int bottom,
+	    /** Set to the top left corner of the tile */
+	    int& x, int& y) const noexcept;
+
+  /**
+   * Get the column containing an x coordinate.
+   * @return the column
+   */
+  int getColumn(/** The x coordinate */ int x) const noexcept;
+
+  /**
+   * Get the row containing a y coordinate.
+   * @return the row
+   */
+  int getRow(/** The y coordinate */ int y) const noexcept;
+
+  /**
+   * Get the x coordinate of the left of a column.
+   * @return the x coordinate
+   */
+  int getX(/** The column */ int column) const noexcept;
+
+  /**
+   * Get the y coordinate of the top of a row.
+   * @return the y coordinate
+   */
+  int getY(/** The row */ int row) const noexcept;
+
+  /**
+   * Get whether there is a tile in a cell.
+   * @return whether the cell has a tile
+   */
+  bool at(/** The column and row of the cell */
+	  int column, int row) const noexcept;
+
+  /**
+   * Get the number of tiles.
+   * @return the number of tiles
+   */
+  int getCount() const noexcept;
+
+  /**
+   * Get the memory used for the cells.
+   * @return the number of bytes
+   */
+  std::size_t getBytes() const noexcept;
+
+private:
+
+  /**
+   * The offset of the grid from 0, 0 
+   */
+  int originX_ = 0;
+  int originY_ = 0;
+
+  /**
+   * The first column and row, and the number of each
+   */
+  int column_ = 0;
+  int row_ = 0;
+  int columns_ = 0;
+  int rows_ = 0;
+
+  /**
+   * The number of 64 bit words in a row
+   */
+  int words_ = 0;
+
+  /**
+   * The number of tiles
+   */
+  int count_ = 0;
+
+  /**
+   * One bit per cell, row by row
+   */
+  std::vector<std::uint64_t> cells_;
+};
+
+}
+
+#endif
@@ -1,13 +1,75 @@
 #include "World.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include "Allocations.h"
+
 using namespace std;
 using namespace medieval;
 
-World::World() {
+/**
+ * SDL's own memory functions, which the counting ones call. 
+ */
+static SDL_malloc_func sdlMalloc = nullptr;
+static SDL_calloc_func sdlCalloc = nullptr;
+static SDL_realloc_func sdlRealloc = nullptr;
+static SDL_free_func sdlFree = nullptr;
+
+static void* SDLCALL countMalloc(size_t size) {
+  Allocations::add();
+  return sdlMalloc(size);
+}
+
+static void* SDLCALL countCalloc(size_t count, size_t size) {
+  Allocations::add();
+  return sdlCalloc(count, size);
+}
+
+static void* SDLCALL countRealloc(void* memory, size_t size) {
+  Allocations::add();
+  return sdlRealloc(memory, size);
+}
+
+constexpr double World::MIN_SCALE;
 
-  // Initialize SDL2
+/**
+ * The number of frames in a level to average the time taken to draw
+ * them over before changing the scale, and the steps the scale
+ * changes in. 
+ */
+static const int SCALE_FRAMES = 30;
+static const double SCALE_STEP = 0.05;
 
-  if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+/**
+ * How long to wait for an event while idle before looking again
+ * anyway, and how long a race waits between frames while the window
+ * is hidden, in milliseconds. 
+ */
+static const int IDLE_WAIT = 250;
+static const int THROTTLE_WAIT = 1000 / 60;
+
+World::World(RenderMode mode) :
+  textures_([this](int index, size_t& bytes) { return loadImage(index, bytes); },
+	    [this](int index, SDL_Texture* texture) { unloadImage(index, texture); },
+	    TEXTURE_BUDGET) {
+
+  // Count SDL's allocations along with ours. This has to happen
+  // before SDL allocates anything, and only once
+
+  if (!sdlMalloc) {
+    SDL_GetMemoryFunctions(&sdlMalloc, &sdlCalloc, &sdlRealloc, &sdlFree);
+    SDL_SetMemoryFunctions(countMalloc, countCalloc, countRealloc, sdlFree);
+  }
+
+  // Initialize SDL2. Offscreen there is no display to use, so
+  // only the subsystems that work without one are started
+
+  Uint32 subsystems = SDL_INIT_EVERYTHING;
+  if (mode == RenderMode::OFFSCREEN) {
+    subsystems = SDL_INIT_TIMER | SDL_INIT_EVENTS;
+  }
+  if (SDL_Init(subsystems) != 0) {
     throw domain_error(string("SDL Initialization failed due to: ") + SDL_GetError());
   }
 
@@ -25,24 +87,63 @@ World::World() {
     throw domain_error ("Couldn't find graphics/font.ttf");
   }
 
-  // Construct the screen window
+  if (mode == RenderMode::OFFSCREEN) {
 
-  window_ = SDL_CreateWindow("Display", SDL_WINDOWPOS_UNDEFINED, 
-                             SDL_WINDOWPOS_UNDEFINED, 
-                             width_, height_, SDL_WINDOW_SHOWN);
-  if (!window_) {
-    close();
-    throw domain_error(string("Unable to create the window due to: ") + SDL_GetError());
-  }
+    // Construct the offscreen surface
+
+    surface_ = SDL_CreateRGBSurfaceWithFormat(0, width_, height_, 32,
+					      SDL_PIXELFORMAT_ARGB8888);
+    if (!surface_) {
+      close();
+      throw domain_error(string("Unable to create the surface due to: ") + SDL_GetError());
+    }
 
-  // Construct the renderer
+    // Construct a software renderer for the surface, which
+    // never waits for vsync
 
-  renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    renderer_ = SDL_CreateSoftwareRenderer(surface_);
+    targetFormat_ = surface_->format->format;
+  } else {
+
+    // Construct the screen window
+
+    window_ = SDL_CreateWindow("Display", SDL_WINDOWPOS_UNDEFINED, 
+			       SDL_WINDOWPOS_UNDEFINED, 
+			       width_, height_, SDL_WINDOW_SHOWN);
+    if (!window_) {
+      close();
+      throw domain_error(string("Unable to create the window due to: ") + SDL_GetError());
+    }
+
+    // Construct the renderer
+
+    renderer_ = SDL_CreateRenderer(window_, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    targetFormat_ = SDL_GetWindowPixelFormat(window_);
+
+    // Draw levels at whatever resolution lets frames finish well 
+    // inside the display's refresh
+
+    SDL_DisplayMode display;
+    if (SDL_GetWindowDisplayMode(window_, &display) == 0 && display.refresh_rate > 0) {
+      frameBudget_ = 850.0 / display.refresh_rate;
+    }
+    autoScale_ = true;
+  }
   if (!renderer_) {
     close();
     throw domain_error(string("Unable to create the renderer due to: ") + SDL_GetError());
   }
 
+  // Render the text and make room for the particles up front, so 
+  // that frames don't have to
+
+  loadGlyphs();
+  particleRects_.resize(Particles::CAPACITY);
+
+  // Open the audio last, and carry on silently without it
+
+  audio_.open();
+
   // Clear the window
   
   clearBackground();
@@ -55,18 +156,53 @@ World::~World() {
 void World::close() noexcept {
 
   // Delete the SDL2 resources in reverse order of
-  // their construction, starting with the images
+  // their construction, starting with the audio, then the images
 
-  for (SDL_Texture* image : images_) {
-    if (image) {
-      SDL_DestroyTexture(image);
-    }
-  }
+  audio_.close();
+
+  // Unloading the images also destroys their rotations
+
+  textures_.clear();
+  held_.clear();
+  holding_ = false;
 
   // Clear the collection of images to ensure
   // idempotence
 
-  images_.clear();
+  assets_.clear();
+
+  // Likewise for the pre-rendered rotations
+
+  for (Rotations& rotations : rotations_) {
+    if (rotations.strip) {
+      SDL_DestroyTexture(rotations.strip);
+    }
+  }
+  rotations_.clear();
+
+  // Likewise for the rendered characters
+
+  for (Glyph& glyph : glyphs_) {
+    if (glyph.texture) {
+      SDL_DestroyTexture(glyph.texture);
+      glyph.texture = nullptr;
+    }
+  }
+
+  // Destroy the cached overlay, which belongs to the renderer
+
+  if (overlay_) {
+    SDL_DestroyTexture(overlay_);
+    overlay_ = nullptr;
+  }
+  overlayValid_ = false;
+
+  // Likewise the scene
+
+  if (scene_) {
+    SDL_DestroyTexture(scene_);
+    scene_ = nullptr;
+  }
 
   // Destroy the renderer and window, and set the
   // variables to nullptr to ensure idempotence
@@ -79,6 +215,10 @@ void World::close() noexcept {
     SDL_DestroyWindow(window_);
     window_ = nullptr;
   }
+  if (surface_) {
+    SDL_FreeSurface(surface_);
+    surface_ = nullptr;
+  }
 
   // The last step is to quit SDL
 
@@ -86,36 +226,364 @@ void World::close() noexcept {
   SDL_Quit();
 }
 
-void World::addImage(const string& fileLocation) noexcept {
+void World::addImage(const string& fileLocation, int colorKey, bool premultiply) noexcept {
   if (renderer_) {
 
-    // Load the image from the file
+    // Note where the image comes from, to load it when it is needed
 
-    SDL_Surface* imageSurface = SDL_LoadBMP(fileLocation.c_str());
-    if (imageSurface) {
+    Asset asset;
+    asset.file = fileLocation;
+    asset.colorKey = colorKey;
+    asset.premultiply = premultiply;
+    assets_.push_back(asset);
+    textures_.add();
+  }
+}
 
-      // Convert the image to a texture
+void World::addRotations(int index, int step, int width, int height) noexcept {
+  if (!renderer_) {
+    return;
+  }
+  if (index < 0 || index >= static_cast<int>(assets_.size())) {
+    cerr << "Unable to rotate the image at index " << index
+	 << " because it was not added" << endl;
+    return;
+  }
+  if (step <= 0 || 360 % step != 0) {
+    cerr << "Unable to rotate the image at index " << index
+	 << " in steps of " << step << " degrees" << endl;
+    return;
+  }
+  if (!SDL_RenderTargetSupported(renderer_)) {
+    cerr << "Unable to rotate the image at index " << index
+	 << " because the renderer cannot render to textures" << endl;
+    return;
+  }
 
-      SDL_Texture* imageTexture = 
-	SDL_CreateTextureFromSurface(renderer_, imageSurface);
-      if (imageTexture) {
+  // Replace any rotations there were for this image, which are
+  // rendered whenever it is loaded. One already loaded is rotated
+  // straight away, and the memory the rotations take is counted
+  // from when it is next loaded
 
-	// Add the image to the collection
+  if (static_cast<int>(rotations_.size()) <= index) {
+    rotations_.resize(index + 1);
+  }
+  Rotations& rotations = rotations_.at(index);
+  if (rotations.strip) {
+    SDL_DestroyTexture(rotations.strip);
+    rotations.strip = nullptr;
+  }
+  rotations.step = step;
+  rotations.width = width;
+  rotations.height = height;
+  if (textures_.isLoaded(index)) {
+    renderRotations(index, textures_.get(index));
+  }
+}
 
-        images_.push_back(imageTexture);
-      } else {
-        cerr << "Unable to load the image file at " << fileLocation
-             << " due to: " << SDL_GetError() << endl;
-      } 
+size_t World::renderRotations(int index, SDL_Texture* texture) noexcept {
+  if (index >= static_cast<int>(rotations_.size()) || rotations_.at(index).step == 0) {
+    return 0;
+  }
 
-      // The surface is not longer needed
+  // Each frame must fit the image's diagonal so that the corners
+  // are not cut off at any angle
 
-      SDL_FreeSurface(imageSurface);
-    } else {
-      cerr << "Unable to load the image file at " << fileLocation
-           << " due to: " << SDL_GetError() << endl;
+  Rotations& rotations = rotations_.at(index);
+  int step = rotations.step;
+  int width = rotations.width;
+  int height = rotations.height;
+  rotations.frameSize = static_cast<int>(ceil(sqrt(width * width + height * height)));
+  int frames = 360 / step;
+
+  // The image may be loaded in the middle of drawing a frame, so
+  // whatever was being drawn into is drawn into again afterwards
+
+  SDL_Texture* target = SDL_GetRenderTarget(renderer_);
+  Uint32 format = nativeFormat(true);
+  rotations.strip = SDL_CreateTexture(renderer_, format, SDL_TEXTUREACCESS_TARGET,
+				      rotations.frameSize * frames, rotations.frameSize);
+  if (!rotations.strip || SDL_SetRenderTarget(renderer_, rotations.strip) != 0) {
+    cerr << "Unable to rotate the image at index " << index
+	 << " due to: " << SDL_GetError() << endl;
+    if (rotations.strip) {
+      SDL_DestroyTexture(rotations.strip);
+      rotations.strip = nullptr;
     }
+    return 0;
   }
+  SDL_SetTextureBlendMode(rotations.strip, SDL_BLENDMODE_BLEND);
+
+  // Render each rotation into its frame on a transparent strip
+
+  Uint8 r, g, b, a;
+  SDL_GetRenderDrawColor(renderer_, &r, &g, &b, &a);
+  SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 0);
+  SDL_RenderClear(renderer_);
+  for (int frame = 0; frame < frames; ++frame) {
+    SDL_Rect destination = { frame * rotations.frameSize + (rotations.frameSize - width) / 2,
+			     (rotations.frameSize - height) / 2, width, height };
+    SDL_RenderCopyEx(renderer_, texture, nullptr, &destination,
+		     frame * step, nullptr, SDL_FLIP_NONE);
+  }
+  SDL_SetRenderTarget(renderer_, target);
+  SDL_SetRenderDrawColor(renderer_, r, g, b, a);
+
+  ImageInfo info;
+  info.name = "rotations of image " + to_string(index);
+  info.source = format;
+  info.format = format;
+  info.width = rotations.frameSize * frames;
+  info.height = rotations.frameSize;
+  info.bytes = static_cast<size_t>(info.width) * info.height * SDL_BYTESPERPIXEL(format);
+  info.blend = SDL_BLENDMODE_BLEND;
+  noteImage(info);
+  return info.bytes;
+}
+
+void World::addMask(int index, int width, int height, int step) noexcept {
+  if (index < 0 || index >= static_cast<int>(assets_.size())) {
+    cerr << "Unable to fit the mask of the image at index " << index
+	 << " because it was not added" << endl;
+    return;
+  }
+
+  // The mask is made from the image file now rather than when the
+  // texture is loaded, so what sprites touch never depends on which
+  // textures happen to be loaded
+
+  Asset& asset = assets_.at(index);
+  asset.maskWidth = width;
+  asset.maskHeight = height;
+  asset.maskStep = step;
+  if (!asset.masked) {
+    makeMask(index);
+  }
+  if (asset.masked) {
+    fitMask(index);
+  }
+}
+
+void World::makeMask(int index) noexcept {
+  Asset& asset = assets_.at(index);
+  SDL_Surface* imageSurface = SDL_LoadBMP(asset.file.c_str());
+  if (!imageSurface) {
+    cerr << "Unable to make the mask of the image file at " << asset.file
+	 << " due to: " << SDL_GetError() << endl;
+    return;
+  }
+
+  // A color key becomes alpha when the surface is converted, and the
+  // format converted to is always the same, whatever the renderer
+  // would draw it in
+
+  if (asset.colorKey >= 0) {
+    SDL_SetColorKey(imageSurface, SDL_TRUE,
+		    SDL_MapRGB(imageSurface->format, (asset.colorKey >> 16) & 0xff,
+			       (asset.colorKey >> 8) & 0xff, asset.colorKey & 0xff));
+  }
+  SDL_Surface* converted = SDL_ConvertSurfaceFormat(imageSurface, SDL_PIXELFORMAT_ARGB8888, 0);
+  SDL_FreeSurface(imageSurface);
+  if (!converted) {
+    cerr << "Unable to make the mask of the image file at " << asset.file
+	 << " due to: " << SDL_GetError() << endl;
+    return;
+  }
+
+  // A pixel is solid if it is at least half opaque
+
+  try {
+    Mask mask(converted->w, converted->h);
+    SDL_LockSurface(converted);
+    for (int y = 0; y < converted->h; ++y) {
+      const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(converted->pixels)
+							 + y * converted->pitch);
+      for (int x = 0; x < converted->w; ++x) {
+	if ((row[x] >> 24) >= 128) {
+	  mask.set(x, y);
+	}
+      }
+    }
+    SDL_UnlockSurface(converted);
+    masks_.add(index, mask);
+    asset.masked = true;
+  } catch (const exception& e) {
+    cerr << "Unable to make the mask of the image file at " << asset.file
+	 << " due to: " << e.what() << endl;
+  }
+  SDL_FreeSurface(converted);
+}
+
+void World::fitMask(int index) noexcept {
+  const Asset& asset = assets_.at(index);
+  if (asset.maskWidth == 0) {
+    return;
+  }
+  try {
+    masks_.fit(index, asset.maskWidth, asset.maskHeight, asset.maskStep);
+  } catch (const exception& e) {
+    cerr << "Unable to fit the mask of the image at index " << index
+	 << " due to: " << e.what() << endl;
+  }
+}
+
+SDL_Texture* World::loadImage(int index, size_t& bytes) noexcept {
+  Asset& asset = assets_.at(index);
+  if (!renderer_) {
+    return nullptr;
+  }
+
+  // Load the image from the file
+
+  SDL_Surface* imageSurface = SDL_LoadBMP(asset.file.c_str());
+  if (!imageSurface) {
+    cerr << "Unable to load the image file at " << asset.file
+	 << " due to: " << SDL_GetError() << endl;
+    return nullptr;
+  }
+
+  // Convert the image to a texture
+
+  ImageInfo info;
+  info.name = asset.file;
+  SDL_Texture* imageTexture = createTexture(imageSurface, asset.colorKey, asset.premultiply, info);
+
+  // The surface is not longer needed
+
+  SDL_FreeSurface(imageSurface);
+  if (!imageTexture) {
+    cerr << "Unable to load the image file at " << asset.file
+	 << " due to: " << SDL_GetError() << endl;
+    return nullptr;
+  }
+  noteImage(info);
+  bytes = info.bytes + renderRotations(index, imageTexture);
+  return imageTexture;
+}
+
+void World::unloadImage(int index, SDL_Texture* texture) noexcept {
+  SDL_DestroyTexture(texture);
+  if (index < static_cast<int>(rotations_.size()) && rotations_.at(index).strip) {
+    SDL_DestroyTexture(rotations_.at(index).strip);
+    rotations_.at(index).strip = nullptr;
+  }
+}
+
+void World::noteImage(const ImageInfo& info) {
+  for (ImageInfo& noted : imageInfo_) {
+    if (noted.name == info.name) {
+      noted = info;
+      return;
+    }
+  }
+  imageInfo_.push_back(info);
+}
+
+void World::screenImages(int level, bool sprites, vector<int>& images) const {
+  images.clear();
+  if (level == 0) {
+    images.push_back(TITLE);
+  } else if (level == -1) {
+    images.push_back(GAME_OVER);
+  } else if (level == -2) {
+    images.push_back(WIN);
+  } else {
+    // Every level has the background, platforms, player and the
+    // lives and health drawn over it, and whatever its sprites use
+
+    images.insert(images.end(), { BACKGROUND, PLATFORM, PLAYER_RIGHT, PLAYER_LEFT, LIVES, HEALTH });
+    if (sprites) {
+      const Level& shown = race_ ? race_->getRace().getLevel(race_->getPlayer()) : level_;
+      for (const shared_ptr<Sprite>& sprite : shown.getList()) {
+	images.push_back(sprite->getImageIndex());
+      }
+      sort(images.begin(), images.end());
+      images.erase(unique(images.begin(), images.end()), images.end());
+    }
+  }
+}
+
+void World::holdImages() {
+  if (holding_ && heldLevel_ == currentLevel_) {
+    return;
+  }
+  holding_ = true;
+  heldLevel_ = currentLevel_;
+
+  // Hold the images of the new screen before letting go of the last
+  // one's, so that those both need stay loaded
+
+  vector<int> images;
+  screenImages(currentLevel_, true, images);
+  for (int image : images) {
+    textures_.hold(image);
+  }
+  for (int image : held_) {
+    textures_.release(image);
+  }
+  held_.swap(images);
+
+  // A level is followed by the next one or the win screen, or the
+  // game over screen, and a menu screen by the title or the first
+  // level
+
+  int next[2] = { 0, 0 };
+  if (currentLevel_ > 0) {
+    next[0] = currentLevel_ == 2 ? -2 : currentLevel_ + 1;
+    next[1] = -1;
+  } else if (currentLevel_ == 0) {
+    next[0] = next[1] = 1;
+  }
+  for (int level : next) {
+    screenImages(level, false, images);
+    for (int image : images) {
+      textures_.prefetch(image);
+    }
+  }
+}
+
+void World::recordTick() noexcept {
+  int values[History::VALUES] = { score_, health_, lives_, time_, timeCounter_ };
+  if (historyLevel_ != currentLevel_) {
+    // Starting the history makes room for all of it, once a level
+    try {
+      history_.start(level_, values);
+      historyLevel_ = currentLevel_;
+    } catch (const exception& e) {
+      cerr << "Unable to remember the level due to: " << e.what() << endl;
+    }
+    return;
+  }
+  history_.record(level_, values);
+}
+
+void World::rewindTick() noexcept {
+  int values[History::VALUES];
+  if (historyLevel_ == currentLevel_ && history_.rewind(level_, values)) {
+    score_ = values[0];
+    health_ = values[1];
+    lives_ = values[2];
+    time_ = values[3];
+    timeCounter_ = values[4];
+  }
+}
+
+void World::recordEvent(Analytics::Event event, int x, int y) noexcept {
+  if (analytics_) {
+    analytics_->record(level_.getTick(), currentLevel_, event, x, y);
+  }
+}
+
+const History& World::getHistory() const noexcept {
+  return history_;
+}
+
+void World::setTextureBudget(size_t budget) noexcept {
+  textures_.setBudget(budget);
+}
+
+const TextureCache& World::getTextures() const noexcept {
+  return textures_;
 }
 
 RelevantEvent World::checkForRelevantEvent() noexcept {
@@ -132,6 +600,39 @@ RelevantEvent World::checkForRelevantEvent() noexcept {
 
       close();
       return RelevantEvent::QUIT;
+    case SDL_RENDER_TARGETS_RESET:
+    case SDL_RENDER_DEVICE_RESET:
+      // The contents of the cached overlay were lost, so it
+      // must be rebuilt
+      
+      overlayValid_ = false;
+      presented_ = false;
+      break;
+    case SDL_WINDOWEVENT:
+      // Follow whether the window is in the background, and draw
+      // the screen again whatever happened to it
+
+      switch (event.window.event) {
+      case SDL_WINDOWEVENT_FOCUS_GAINED:
+	focused_ = true;
+	break;
+      case SDL_WINDOWEVENT_FOCUS_LOST:
+	focused_ = false;
+	break;
+      case SDL_WINDOWEVENT_SHOWN:
+      case SDL_WINDOWEVENT_RESTORED:
+      case SDL_WINDOWEVENT_MAXIMIZED:
+	visible_ = true;
+	break;
+      case SDL_WINDOWEVENT_HIDDEN:
+      case SDL_WINDOWEVENT_MINIMIZED:
+	visible_ = false;
+	break;
+      default:
+	break;
+      }
+      presented_ = false;
+      break;
     case SDL_KEYDOWN:
       switch( event.key.keysym.sym ){
 	
@@ -147,7 +648,13 @@ RelevantEvent World::checkForRelevantEvent() noexcept {
 	(player_.lock())->setH(8);
 	break;
       case SDLK_UP:
-	(player_.lock())->jump();
+	if ((player_.lock())->jump()) {
+	  audio_.play(Sound::JUMP);
+	}
+	jump_ = true;
+	break;
+      case SDLK_r:
+	rewind_ = true;
 	break;
       default:
 	break;
@@ -164,9 +671,11 @@ RelevantEvent World::checkForRelevantEvent() noexcept {
 	    ++currentLevel_;
 	  }
 	  level_ = Level(currentLevel_);
+	  level_.setMasks(&masks_);
 	  player_ = level_.getPlayer();
 	  right_ = false;
 	  left_ = false;
+	  race_ = nullptr;
 	  break;
 	default:
 	  break;
@@ -183,6 +692,15 @@ RelevantEvent World::checkForRelevantEvent() noexcept {
 	  right_ = false;
 	  (player_.lock())->stopH();
 	  break;
+
+	  // carries on from wherever the level was run back to,
+	  // moving only if told to now
+	case SDLK_r:
+	  rewind_ = false;
+	  if (!left_ && !right_) {
+	    (player_.lock())->stopH();
+	  }
+	  break;
 	default:
 	  break;
 	}
@@ -198,7 +716,20 @@ RelevantEvent World::checkForRelevantEvent() noexcept {
 }
 
 void World::refresh() {
+  // Anything allocated since the last frame was allocated between
+  // frames, and the menus skip some of the phases
+
+  endPhase(FramePhase::EVENTS);
+  fill(allocations_ + 1, allocations_ + static_cast<int>(FramePhase::COUNT), 0);
+  fill(phaseTimes_ + 1, phaseTimes_ + static_cast<int>(FramePhase::COUNT), 0.0);
+  frameStart_ = phaseMark_;
+  drawCalls_ = 0;
+
   if (renderer_) {
+
+    // Load what the screen shown needs if it has just changed
+
+    holdImages();
     
     // Clear the window
     
@@ -209,149 +740,182 @@ void World::refresh() {
     if(lives_ == 0) {
       currentLevel_ = -1;
       level_ = Level(currentLevel_);
+      level_.setMasks(&masks_);
       player_ = level_.getPlayer();
       lives_ = 5;
       health_ = 3;
     }
+
+    // Nothing has changed since the last frame was presented, so
+    // it is left as it is
+
+    if (idle()) {
+      ++idleFrames_;
+      endPhase(FramePhase::PRESENT);
+      return;
+    }
+    
     // if on title screen
     if(currentLevel_ == 0) {
-      // Draw the title screen
-      
-      draw(0, 0, 1080, 720, 1);
       score_ = 0; 
-    } // if on game over screen
-    else if(currentLevel_ == -1) {
-      // Draw the game over screen
+      particles_.clear();
+      historyLevel_ = 0;
+      audio_.playMusic(false);
       
-      draw(0, 0, 1080, 720, 10);
-      // Draw score
+      // Draw the title screen
       
-      drawText(635, 590, to_string(score_), 2);
+      drawOverlay();
+    } // if on game over or win screen
+    else if(currentLevel_ == -1 || currentLevel_ == -2) {
+      // Keep answering the other side of a finished race so that
+      // it can confirm the result too
       
-    } // if on win screen
-    else if(currentLevel_ == -2) {
-      // Draw the win screen
+      if (race_) {
+	race_->advance(0);
+      }
+      particles_.clear();
+      historyLevel_ = 0;
+      audio_.playMusic(false);
       
-      draw(0, 0, 1080, 720, 11);
-      // Draw score
-      drawText(640, 400, to_string(score_), 3);
-
-      // Draw high score
-      drawText(900, 580, "High Score: " + to_string(highScore_), 2);
+      // Draw the screen along with the score
       
+      drawOverlay();
     } else {
       
-      // Draw the background
-      draw(0, 0, 1080, 720, 0);
+      // Draw the background, into the scene if the level is drawn
+      // below the window's resolution
+      bool scene = beginScene();
+      draw(0, 0, 1080, 720, BACKGROUND);
+      audio_.playMusic(true);
 
-      // Add to time
-      ++timeCounter_;
-      if(timeCounter_ > 40) {
+      // Add to time, unless paused or running the level backwards,
+      // which a race can't do
+      bool paused = this->paused();
+      bool rewinding = rewind_ && !race_ && !paused;
+      if(!paused && !rewinding && ++timeCounter_ > 40) {
 	++time_;
 	timeCounter_ = 0;
       }
 
-      // Draw time
-      drawText(1040, 10, "Time: " + to_string(time_), 1);
-      
-      // Draw lives
-      for(int x = lives_; x > 0; --x) {
-	draw((x * 55) - 40, 20, 50, 50, 9);
-      }
-
-      // Draw health
-      for(int x = health_; x > 0; --x) {
-	draw((x * 55) - 18, 70, 50, 50, 7);
+      // Draw time, lives, health and score, which go over the
+      // level instead once it is stretched over the window
+      if (!scene) {
+	drawOverlay();
       }
-
-      // Draw score
-      drawText(1040, 60, to_string(score_), 1);
+      endPhase(FramePhase::OVERLAY);
 			 
-      // Move the player and all the other sprites
-      if(left_) {
-	(player_.lock())->setH(-8);
-      } else if (right_) {
-	(player_.lock())->setH(8);
-      }
-      level_.evolve();
-
-      // If the player takes damage reduce one health
-      if(level_.damaged()) {
-	--health_;
-	score_ -= 10;
-      }
-
-      // If the player picks up health, heal them
-      if(level_.healed()) {
-	if(health_ < 3) {
-	  ++health_;
+      if (race_) {
+	// Advance the race and show the local player's progress
+	advanceRace();
+      } else if (rewinding) {
+	// Run the level back a tick
+	rewindTick();
+      } else if (!paused) {
+	// Move the player and all the other sprites
+	if(left_) {
+	  (player_.lock())->setH(-8);
+	} else if (right_) {
+	  (player_.lock())->setH(8);
 	}
-      }
-
-      // If the player picks up a coin, add score
-      if(level_.scored()) {
-	score_ += 25;
-      }
+	level_.evolve();
 
-      // If the player is dead reset health, reduce lives, lose score and reset player
-      if(level_.dead() || health_ <= 0) {
-	--lives_;
-	health_ = 3;
-	level_.resetPlayer();
-	score_ -= 50;
-      }
-      
-      // Draw all of the sprites
+	// Sparks fly from the middle of the player when they
+	// touch something
+	shared_ptr<Player> player = player_.lock();
+	int centerX = player->getXCoordinate() + player->getWidth() / 2;
+	int centerY = player->getYCoordinate() + player->getHeight() / 2;
+	recordEvent(Analytics::Event::POSITION, centerX, centerY);
 
-      for (const shared_ptr<Sprite>& sprite : level_.getList()) {
-	
-	// The location of the sprite is a square
+	// If the player takes damage reduce one health
+	if(level_.damaged()) {
+	  --health_;
+	  score_ -= 10;
+	  particles_.burst(centerX, centerY, Particles::FIRE);
+	  audio_.play(Sound::DAMAGE);
+	  recordEvent(Analytics::Event::DAMAGE, centerX, centerY);
+	}
 
-	SDL_Rect destination = { sprite->getXCoordinate(), sprite->getYCoordinate(), 
-				 sprite->getWidth(), sprite->getHeight() };
+	// If the player picks up health, heal them
+	if(level_.healed()) {
+	  if(health_ < 3) {
+	    ++health_;
+	  }
+	  particles_.burst(centerX, centerY, Particles::HEALTH);
+	  audio_.play(Sound::HEALTH);
+	  recordEvent(Analytics::Event::HEAL, centerX, centerY);
+	}
 
-	// Get the image index and check that it is valid
+	// If the player picks up a coin, add score
+	if(level_.scored()) {
+	  score_ += 25;
+	  particles_.burst(centerX, centerY, Particles::COIN);
+	  audio_.play(Sound::COIN);
+	  recordEvent(Analytics::Event::SCORE, centerX, centerY);
+	}
 
-	unsigned int imageIndex = sprite->getImageIndex();
-	if (imageIndex >= 0 && imageIndex < images_.size()) {
+	// If the player is dead reset health, reduce lives, lose score and reset player
+	if(level_.dead() || health_ <= 0) {
+	  recordEvent(Analytics::Event::DEATH, centerX, centerY);
+	  --lives_;
+	  health_ = 3;
+	  level_.resetPlayer();
+	  score_ -= 50;
+	}
 
-	  // Get the image for the sprite
+	// Remember the tick, to run back through it
+	recordTick();
+      }
 
-	  SDL_Texture* imageTexture = images_.at(imageIndex);
-	  if (imageTexture) {
+      endPhase(FramePhase::SIMULATE);
 
-	    // Render the image at the location,
-	    // rotated by its angle
+      // Draw all of the sprites
 
-	    if (SDL_RenderCopyEx(renderer_, imageTexture, nullptr,
-				 &destination, sprite->getAngle(), 
-				 nullptr, SDL_FLIP_NONE) != 0) {
-	      close();
-	      throw domain_error(string("Unable to render a sprite due to: ")
-				 + SDL_GetError());
-	    }
-	  } else {
-	    close();
-	    throw domain_error("Missing image texture at index "
-			       + to_string(imageIndex));          
-	  }
-	} else {
-	  close();
-	  throw domain_error("Invalid image index " 
-			     + to_string(imageIndex));
+      if (race_) {
+	updateParticles(race_->getRace().getLevel(race_->getPlayer()));
+	drawRace();
+      } else {
+	updateParticles(level_);
+	drawTiles(level_.getTiles());
+	for (const shared_ptr<Sprite>& sprite : level_.getList()) {
+	  drawSprite(*sprite);
 	}
       }
+      drawParticles();
+      if (scene) {
+	endScene();
+	drawOverlay();
+      }
+      adjustScale();
+      endPhase(FramePhase::DRAW);
+    }
+    if (capture_) {
+      captureFrame();
     }
     SDL_RenderPresent(renderer_);
+    presented_ = true;
+    presentedLevel_ = currentLevel_;
+
+    // Keep track of the frame rate, and hash the frame if
+    // it was rendered offscreen
+
+    if (frameCount_ == 0) {
+      firstFrame_ = SDL_GetPerformanceCounter();
+    }
+    ++frameCount_;
+    if (surface_) {
+      hashFrame();
+    }
   }
 
   // if the next level is reached proceed to next level or
   // win screen if last level is reached
   if(level_.next()) {
       score_ += 100;
+      audio_.play(Sound::LEVEL);
       if(currentLevel_ == 2) {
 	currentLevel_ = -2;
 	level_ = Level(currentLevel_);
+	level_.setMasks(&masks_);
 	player_ = level_.getPlayer();
 	score_ += (lives_ * 50) + (health_ * 10) + (100 - time_);
 	if(highScore_ < score_) {
@@ -362,9 +926,14 @@ void World::refresh() {
       } else {
 	++currentLevel_;
 	level_ = Level(currentLevel_);
+	level_.setMasks(&masks_);
 	player_ = level_.getPlayer();
       }
     }
+  endPhase(FramePhase::PRESENT);
+  if (telemetry_ && renderer_) {
+    shareTelemetry();
+  }
 }
 
 void World::clearBackground() {
@@ -390,12 +959,13 @@ void World::draw(int x, int y, int width, int height, int index) {
 
   // Get the image for the background
 
-  SDL_Texture* imageTexture = images_.at(index);
+  SDL_Texture* imageTexture = textures_.get(index);
   if (imageTexture) {
 
     // Render the image at the location,
     // rotated by its angle
 
+    ++drawCalls_;
     if (SDL_RenderCopyEx(renderer_, imageTexture, nullptr,
 			 &destination, 0, 
 			 nullptr, SDL_FLIP_NONE) != 0) {
@@ -410,13 +980,840 @@ void World::draw(int x, int y, int width, int height, int index) {
   }
 }
 
-void World::drawText(int x, int y, string text, int size) {
-  SDL_Surface* textSurface = TTF_RenderText_Solid(font_, text.c_str(), textColor_);
-  SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer_, textSurface);
-  int text_width = textSurface->w * size;
-  int text_height = textSurface->h * size;
-  SDL_FreeSurface(textSurface);
-  SDL_Rect destination = { x - text_width, y, text_width, text_height };
-  SDL_RenderCopy(renderer_, texture, NULL, &destination);
-  SDL_DestroyTexture(texture);
+void World::drawText(int x, int y, const char* text, int size) {
+  // The text ends at x, so measure it first
+  int text_width = 0;
+  for (const char* c = text; *c; ++c) {
+    if (*c >= FIRST_GLYPH && *c < FIRST_GLYPH + GLYPHS) {
+      text_width += glyphs_[*c - FIRST_GLYPH].advance * size;
+    }
+  }
+  x -= text_width;
+  for (const char* c = text; *c; ++c) {
+    if (*c >= FIRST_GLYPH && *c < FIRST_GLYPH + GLYPHS) {
+      const Glyph& glyph = glyphs_[*c - FIRST_GLYPH];
+      if (glyph.texture) {
+	SDL_Rect destination = { x, y, glyph.width * size, glyph.height * size };
+	++drawCalls_;
+	SDL_RenderCopy(renderer_, glyph.texture, NULL, &destination);
+      }
+      x += glyph.advance * size;
+    }
+  }
+}
+
+void World::loadGlyphs() {
+  ImageInfo font;
+  font.name = "graphics/font.ttf (" + to_string(GLYPHS) + " characters)";
+  for (int i = 0; i < GLYPHS; ++i) {
+    char text[2] = { static_cast<char>(FIRST_GLYPH + i), 0 };
+    Glyph& glyph = glyphs_[i];
+    if (TTF_SizeText(font_, text, &glyph.advance, &glyph.height) != 0) {
+      close();
+      throw domain_error(string("Unable to measure text due to: ") + SDL_GetError());
+    }
+
+    // Blank characters have nothing to draw
+
+    SDL_Surface* textSurface = TTF_RenderText_Solid(font_, text, textColor_);
+    if (textSurface) {
+      ImageInfo info;
+      glyph.texture = createTexture(textSurface, -1, false, info);
+      glyph.width = textSurface->w;
+      glyph.height = textSurface->h;
+      SDL_FreeSurface(textSurface);
+
+      // The characters are reported together
+      font.source = info.source;
+      font.format = info.format;
+      font.width += info.width;
+      font.height = max(font.height, info.height);
+      font.bytes += info.bytes;
+      font.blend = info.blend;
+    }
+  }
+  imageInfo_.push_back(font);
+}
+
+Uint32 World::nativeFormat(bool alpha) const noexcept {
+  SDL_RendererInfo info;
+  if (SDL_GetRendererInfo(renderer_, &info) == 0) {
+
+    // Drawing in the format of the target needs no conversion at all
+
+    for (Uint32 i = 0; i < info.num_texture_formats; ++i) {
+      if (info.texture_formats[i] == targetFormat_ &&
+	  (!alpha || SDL_ISPIXELFORMAT_ALPHA(targetFormat_))) {
+	return targetFormat_;
+      }
+    }
+
+    // Otherwise use the first packed format the renderer prefers
+
+    for (Uint32 i = 0; i < info.num_texture_formats; ++i) {
+      Uint32 format = info.texture_formats[i];
+      if (!SDL_ISPIXELFORMAT_FOURCC(format) && !SDL_ISPIXELFORMAT_INDEXED(format) &&
+	  (!alpha || SDL_ISPIXELFORMAT_ALPHA(format))) {
+	return format;
+      }
+    }
+  }
+  return SDL_PIXELFORMAT_ARGB8888;
+}
+
+SDL_Texture* World::createTexture(SDL_Surface* surface, int colorKey, bool premultiply,
+				  ImageInfo& info) noexcept {
+  info.source = surface->format->format;
+
+  // A color key becomes alpha when the surface is converted
+
+  if (colorKey >= 0) {
+    SDL_SetColorKey(surface, SDL_TRUE, SDL_MapRGB(surface->format, (colorKey >> 16) & 0xff,
+						   (colorKey >> 8) & 0xff, colorKey & 0xff));
+  }
+  Uint32 key;
+  bool alpha = SDL_ISPIXELFORMAT_ALPHA(info.source) || SDL_GetColorKey(surface, &key) == 0;
+  Uint32 format = nativeFormat(alpha);
+  SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, format, 0);
+  if (!converted) {
+    return nullptr;
+  }
+  SDL_LockSurface(converted);
+
+  // An image with an alpha channel that is opaque everywhere can be
+  // copied without blending
+
+  bool fourBytes = SDL_BYTESPERPIXEL(format) == 4;
+  if (alpha && fourBytes) {
+    Uint32 mask = converted->format->Amask;
+    alpha = false;
+    for (int y = 0; y < converted->h && !alpha; ++y) {
+      const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<const Uint8*>(converted->pixels)
+							 + y * converted->pitch);
+      for (int x = 0; x < converted->w; ++x) {
+	if ((row[x] & mask) != mask) {
+	  alpha = true;
+	  break;
+	}
+      }
+    }
+  }
+
+  SDL_Texture* texture = SDL_CreateTexture(renderer_, format, SDL_TEXTUREACCESS_STATIC,
+					   converted->w, converted->h);
+  if (texture) {
+    info.blend = alpha ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE;
+
+    // Premultiplied alpha needs a blend mode the renderer may not have
+
+    if (alpha && premultiply && fourBytes) {
+      SDL_BlendMode blend =
+	SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+				   SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE,
+				   SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+      if (SDL_SetTextureBlendMode(texture, blend) == 0) {
+	info.blend = blend;
+	info.premultiplied = true;
+	for (int y = 0; y < converted->h; ++y) {
+	  Uint32* row = reinterpret_cast<Uint32*>(static_cast<Uint8*>(converted->pixels)
+						  + y * converted->pitch);
+	  for (int x = 0; x < converted->w; ++x) {
+	    Uint8 r, g, b, a;
+	    SDL_GetRGBA(row[x], converted->format, &r, &g, &b, &a);
+	    row[x] = SDL_MapRGBA(converted->format, r * a / 255, g * a / 255, b * a / 255, a);
+	  }
+	}
+      }
+    }
+    if (!info.premultiplied) {
+      SDL_SetTextureBlendMode(texture, info.blend);
+    }
+    SDL_UpdateTexture(texture, nullptr, converted->pixels, converted->pitch);
+  }
+  info.format = format;
+  info.width = converted->w;
+  info.height = converted->h;
+  info.bytes = static_cast<size_t>(converted->h) * converted->pitch;
+  SDL_UnlockSurface(converted);
+  SDL_FreeSurface(converted);
+  return texture;
+}
+
+void World::reportImages(ostream& out) const {
+  for (const ImageInfo& info : imageInfo_) {
+    out << info.name << ": " << info.width << "x" << info.height << " "
+	<< SDL_GetPixelFormatName(info.format);
+    if (info.source != info.format) {
+      out << " (converted from " << SDL_GetPixelFormatName(info.source) << ")";
+    }
+    out << ", " << info.bytes << " bytes, ";
+    if (info.format == targetFormat_ && info.blend == SDL_BLENDMODE_NONE) {
+      out << "straight copy";
+    } else if (info.premultiplied) {
+      out << "premultiplied blend";
+    } else if (info.blend == SDL_BLENDMODE_NONE) {
+      out << "copy with conversion";
+    } else {
+      out << "blend";
+    }
+    out << endl;
+  }
+
+  // Then which images are loaded now, and how the cache did
+
+  const TextureCache::Stats& stats = textures_.getStats();
+  for (int index = 0; index < textures_.size(); ++index) {
+    out << assets_.at(index).file << ": ";
+    if (textures_.isLoaded(index)) {
+      out << "loaded, " << textures_.getBytes(index) << " bytes, held "
+	  << textures_.getHolds(index) << " times" << endl;
+    } else {
+      out << "not loaded" << endl;
+    }
+  }
+  out << stats.resident << " of " << textures_.size() << " images loaded in "
+      << stats.bytes << " bytes, at most " << stats.peak << " with a budget of "
+      << textures_.getBudget() << ", " << stats.hits << " hits, " << stats.misses
+      << " misses, " << stats.loads << " loads (" << stats.prefetches << " ahead of time), "
+      << stats.evictions << " evictions, " << stats.failures << " failures" << endl;
+}
+
+void World::endPhase(FramePhase phase) noexcept {
+  long count = Allocations::getCount();
+  allocations_[static_cast<int>(phase)] = count - allocationMark_;
+  allocationMark_ = count;
+  Uint64 now = SDL_GetPerformanceCounter();
+  phaseTimes_[static_cast<int>(phase)] = static_cast<double>(now - phaseMark_) * 1000
+    / SDL_GetPerformanceFrequency();
+  phaseMark_ = now;
+}
+
+void World::shareTelemetry() noexcept {
+  // Note the time since the last frame shared started, and take
+  // the percentiles of the recent ones by partly sorting a copy
+  // of them, which is quick enough for a few hundred every frame
+
+  if (sharedStart_ != 0) {
+    frameTimes_[frameTimeCount_++ % FRAME_TIMES] = static_cast<double>(frameStart_ - sharedStart_)
+      * 1000 / SDL_GetPerformanceFrequency();
+  }
+  sharedStart_ = frameStart_;
+  int count = static_cast<int>(min<long>(frameTimeCount_, FRAME_TIMES));
+  copy(frameTimes_, frameTimes_ + count, sortedTimes_);
+  auto percentile = [&](int percent) {
+    if (count == 0) {
+      return 0.0;
+    }
+    double* nth = sortedTimes_ + min(count - 1, count * percent / 100);
+    nth_element(sortedTimes_, nth, sortedTimes_ + count);
+    return *nth;
+  };
+
+  Telemetry::Counters counters;
+  counters.frames = frameCount_;
+  counters.level = currentLevel_;
+  counters.frame50 = percentile(50);
+  counters.frame90 = percentile(90);
+  counters.frame99 = percentile(99);
+  counters.frameMax = count == 0 ? 0 : *max_element(sortedTimes_, sortedTimes_ + count);
+  counters.simulate = phaseTimes_[static_cast<int>(FramePhase::SIMULATE)];
+  counters.draw = phaseTimes_[static_cast<int>(FramePhase::DRAW)];
+  counters.drawCalls = drawCalls_;
+  const Level& level = race_ ? race_->getRace().getLevel(race_->getPlayer()) : level_;
+  counters.sprites = level.getList().size();
+  counters.awake = level.getAwake();
+  for (long allocations : allocations_) {
+    counters.allocations += allocations;
+  }
+  counters.scale = scale_;
+  counters.effects = effectsCost_ / 100.0;
+  counters.rewind = historyLevel_ == currentLevel_ ? history_.getSeconds() : 0;
+  telemetry_->publish(counters);
+}
+
+long World::getAllocations(FramePhase phase) const noexcept {
+  return allocations_[static_cast<int>(phase)];
+}
+
+int World::getLevel() const noexcept {
+  return currentLevel_;
+}
+
+void World::setCapture(Capture* capture) noexcept {
+  capture_ = capture;
+}
+
+void World::setTelemetry(Telemetry* telemetry) noexcept {
+  telemetry_ = telemetry;
+  frameTimeCount_ = 0;
+  sharedStart_ = 0;
+}
+
+void World::setAnalytics(Analytics* analytics) noexcept {
+  if (analytics_) {
+    analytics_->flush();
+  }
+  analytics_ = analytics;
+}
+
+void World::setScale(double scale) noexcept {
+  autoScale_ = scale <= 0;
+  scale_ = autoScale_ ? 1 : max(MIN_SCALE, min(scale, 1.0));
+  drawTime_ = 0;
+  drawFrames_ = 0;
+}
+
+double World::getScale() const noexcept {
+  return scale_;
+}
+
+void World::setIdling(bool idling) noexcept {
+  idling_ = idling;
+  presented_ = false;
+}
+
+int World::getIdleWait() const noexcept {
+  if (idle()) {
+    return IDLE_WAIT;
+  }
+  if (idling_ && !surface_ && !capture_ && race_ && !visible_) {
+    return THROTTLE_WAIT;
+  }
+  return 0;
+}
+
+int World::getIdleFrames() const noexcept {
+  return idleFrames_;
+}
+
+bool World::paused() const noexcept {
+  return idling_ && !surface_ && !capture_ && !race_ && currentLevel_ > 0 &&
+    (!focused_ || !visible_);
+}
+
+bool World::idle() const noexcept {
+  // a menu screen only changes when the level does, and a paused
+  // level not at all
+  bool menu = currentLevel_ == 0 || currentLevel_ == -1 || currentLevel_ == -2;
+  return idling_ && !surface_ && !capture_ && presented_ && presentedLevel_ == currentLevel_ &&
+    ((menu && !race_) || paused());
+}
+
+int World::getOverlayRebuilds() const noexcept {
+  return overlayRebuilds_;
+}
+
+const Particles& World::getParticles() const noexcept {
+  return particles_;
+}
+
+const Audio& World::getAudio() const noexcept {
+  return audio_;
+}
+
+void World::drawOverlay() {
+
+  // Without render target support there is nothing to cache
+  // the overlay in, so it is drawn directly
+
+  if (!SDL_RenderTargetSupported(renderer_)) {
+    renderOverlay();
+    return;
+  }
+
+  // Create the overlay texture the first time it is needed
+
+  if (!overlay_) {
+    overlay_ = SDL_CreateTexture(renderer_, nativeFormat(true),
+				 SDL_TEXTUREACCESS_TARGET, width_, height_);
+    if (!overlay_) {
+      close();
+      throw domain_error(string("Unable to create the overlay due to: ")
+			 + SDL_GetError());
+    }
+    SDL_SetTextureBlendMode(overlay_, SDL_BLENDMODE_BLEND);
+  }
+
+  // Re-render the overlay only if something it shows has changed
+
+  if (!overlayValid_ || overlayLevel_ != currentLevel_ ||
+      overlayScore_ != score_ || overlayHighScore_ != highScore_ ||
+      overlayTime_ != time_ || overlayLives_ != lives_ ||
+      overlayHealth_ != health_) {
+    if (SDL_SetRenderTarget(renderer_, overlay_) != 0) {
+      close();
+      throw domain_error(string("Unable to render the overlay due to: ")
+			 + SDL_GetError());
+    }
+
+    // Clear to fully transparent so the background shows through
+
+    SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 0);
+    SDL_RenderClear(renderer_);
+    renderOverlay();
+    SDL_SetRenderTarget(renderer_, nullptr);
+
+    overlayLevel_ = currentLevel_;
+    overlayScore_ = score_;
+    overlayHighScore_ = highScore_;
+    overlayTime_ = time_;
+    overlayLives_ = lives_;
+    overlayHealth_ = health_;
+    overlayValid_ = true;
+    ++overlayRebuilds_;
+  }
+
+  ++drawCalls_;
+  if (SDL_RenderCopy(renderer_, overlay_, nullptr, nullptr) != 0) {
+    close();
+    throw domain_error(string("Unable to render the overlay due to: ")
+		       + SDL_GetError());
+  }
+}
+
+bool World::beginScene() {
+
+  // Without render target support there is nothing to draw the
+  // level into, so it is drawn at the window's resolution
+
+  if (scale_ >= 1 || !SDL_RenderTargetSupported(renderer_)) {
+    return false;
+  }
+
+  // Create the scene the first time it is needed, at the window's
+  // size so that any scale fits in it, and smooth it when it is
+  // stretched
+
+  if (!scene_) {
+    const char* quality = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
+    string previous = quality ? quality : "nearest";
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+    scene_ = SDL_CreateTexture(renderer_, nativeFormat(false),
+			       SDL_TEXTUREACCESS_TARGET, width_, height_);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, previous.c_str());
+    if (!scene_) {
+      close();
+      throw domain_error(string("Unable to create the scene due to: ")
+			 + SDL_GetError());
+    }
+  }
+
+  // The scale shrinks everything drawn, so the level is drawn with
+  // the same coordinates into the corner of the scene
+
+  if (SDL_SetRenderTarget(renderer_, scene_) != 0 ||
+      SDL_RenderSetScale(renderer_, static_cast<float>(scale_), static_cast<float>(scale_)) != 0) {
+    close();
+    throw domain_error(string("Unable to render the scene due to: ")
+		       + SDL_GetError());
+  }
+  return true;
+}
+
+void World::endScene() {
+  SDL_Rect source = { 0, 0, static_cast<int>(lround(width_ * scale_)),
+		      static_cast<int>(lround(height_ * scale_)) };
+  ++drawCalls_;
+  if (SDL_SetRenderTarget(renderer_, nullptr) != 0 ||
+      SDL_RenderCopy(renderer_, scene_, &source, nullptr) != 0) {
+    close();
+    throw domain_error(string("Unable to render the scene due to: ")
+		       + SDL_GetError());
+  }
+}
+
+void World::adjustScale() noexcept {
+  if (!autoScale_) {
+    return;
+  }
+  drawTime_ += static_cast<double>(SDL_GetPerformanceCounter() - frameStart_) * 1000
+    / SDL_GetPerformanceFrequency();
+  if (++drawFrames_ < SCALE_FRAMES) {
+    return;
+  }
+  double average = drawTime_ / drawFrames_;
+  drawTime_ = 0;
+  drawFrames_ = 0;
+
+  // The time taken goes roughly with the number of pixels, which
+  // goes with the square of the scale, so an over budget frame 
+  // drops straight to the step that should fit. Coming back up is
+  // a step at a time, and only once there is plenty of room, so 
+  // the scale doesn't flip back and forth
+
+  if (average > frameBudget_) {
+    double wanted = scale_ * sqrt(frameBudget_ / average);
+    scale_ = max(MIN_SCALE, floor(wanted / SCALE_STEP + 1e-6) * SCALE_STEP);
+  } else if (average < frameBudget_ * 0.7 && scale_ < 1) {
+    scale_ = min(1.0, (lround(scale_ / SCALE_STEP) + 1) * SCALE_STEP);
+  }
+}
+
+void World::renderOverlay() {
+  // The text is formatted without allocating, so that no frame the
+  // overlay is rebuilt on allocates
+  char text[32];
+  
+  // if on title screen
+  if(currentLevel_ == 0) {
+    // Draw the title screen
+    
+    draw(0, 0, 1080, 720, TITLE);
+  } // if on game over screen
+  else if(currentLevel_ == -1) {
+    // Draw the game over screen
+    
+    draw(0, 0, 1080, 720, GAME_OVER);
+    // Draw score
+    
+    snprintf(text, sizeof(text), "%d", score_);
+    drawText(635, 590, text, 2);
+    
+  } // if on win screen
+  else if(currentLevel_ == -2) {
+    // Draw the win screen
+    
+    draw(0, 0, 1080, 720, WIN);
+    // Draw score
+    snprintf(text, sizeof(text), "%d", score_);
+    drawText(640, 400, text, 3);
+    
+    // Draw high score
+    snprintf(text, sizeof(text), "High Score: %d", highScore_);
+    drawText(900, 580, text, 2);
+    
+  } else {
+    
+    // Draw time
+    snprintf(text, sizeof(text), "Time: %d", time_);
+    drawText(1040, 10, text, 1);
+    
+    // Draw lives
+    for(int x = lives_; x > 0; --x) {
+      draw((x * 55) - 40, 20, 50, 50, LIVES);
+    }
+    
+    // Draw health
+    for(int x = health_; x > 0; --x) {
+      draw((x * 55) - 18, 70, 50, 50, HEALTH);
+    }
+    
+    // Draw score
+    snprintf(text, sizeof(text), "%d", score_);
+    drawText(1040, 60, text, 1);
+  }
+}
+
+Uint64 World::getFrameHash() const noexcept {
+  return frameHash_;
+}
+
+int World::getFrameCount() const noexcept {
+  return frameCount_;
+}
+
+double World::getFramesPerSecond() const noexcept {
+  // the first frame only marks the start of the measurement
+  if (frameCount_ < 2) {
+    return 0;
+  }
+  double seconds = static_cast<double>(SDL_GetPerformanceCounter() - firstFrame_)
+    / SDL_GetPerformanceFrequency();
+  if (seconds <= 0) {
+    return 0;
+  }
+  return (frameCount_ - 1) / seconds;
+}
+
+void World::captureFrame() noexcept {
+  // Read the frame before it is presented, after which what was
+  // drawn is gone
+
+  Uint8* pixels = capture_->acquire();
+  if (pixels) {
+    SDL_Rect frame = { 0, 0, width_, height_ };
+    capture_->submit(SDL_RenderReadPixels(renderer_, &frame, SDL_PIXELFORMAT_RGBA32,
+					  pixels, width_ * 4) == 0);
+  }
+}
+
+void World::hashFrame() noexcept {
+  if (SDL_MUSTLOCK(surface_) && SDL_LockSurface(surface_) != 0) {
+    frameHash_ = 0;
+    return;
+  }
+
+  // 64 bit FNV-1a over the visible bytes of each row, skipping
+  // any padding at the end of the rows
+  
+  Uint64 hash = 14695981039346656037ULL;
+  const Uint8* row = static_cast<const Uint8*>(surface_->pixels);
+  int rowBytes = surface_->w * surface_->format->BytesPerPixel;
+  for (int y = 0; y < surface_->h; ++y) {
+    for (int x = 0; x < rowBytes; ++x) {
+      hash ^= row[x];
+      hash *= 1099511628211ULL;
+    }
+    row += surface_->pitch;
+  }
+  frameHash_ = hash;
+
+  if (SDL_MUSTLOCK(surface_)) {
+    SDL_UnlockSurface(surface_);
+  }
+}
+
+bool World::findRotation(const Sprite& sprite, SDL_Rect& source,
+			 SDL_Rect& destination) const noexcept {
+  int index = sprite.getImageIndex();
+  if (index < 0 || index >= static_cast<int>(rotations_.size())) {
+    return false;
+  }
+
+  // The frames are only usable at the size they were rendered at
+  
+  const Rotations& rotations = rotations_.at(index);
+  if (!rotations.strip || rotations.width != sprite.getWidth() ||
+      rotations.height != sprite.getHeight()) {
+    return false;
+  }
+
+  // Find the frame for the sprite's angle, if it is one of the steps
+  
+  int angle = ((sprite.getAngle() % 360) + 360) % 360;
+  if (angle % rotations.step != 0) {
+    return false;
+  }
+  int frame = angle / rotations.step;
+  source = { frame * rotations.frameSize, 0, rotations.frameSize, rotations.frameSize };
+
+  // The frame is centred on the sprite
+  
+  destination = { sprite.getXCoordinate() - (rotations.frameSize - rotations.width) / 2,
+		  sprite.getYCoordinate() - (rotations.frameSize - rotations.height) / 2,
+		  rotations.frameSize, rotations.frameSize };
+  return true;
+}
+
+void World::drawTiles(const TileMap& tiles) {
+  // Only the cells on the screen are looked at, however long the level
+
+  SDL_Texture* imageTexture = textures_.get(PLATFORM);
+  for (int row = tiles.getRow(0); row <= tiles.getRow(height_ - 1); ++row) {
+    for (int column = tiles.getColumn(0); column <= tiles.getColumn(width_ - 1); ++column) {
+      if (tiles.at(column, row)) {
+	SDL_Rect destination = { tiles.getX(column), tiles.getY(row),
+				 TileMap::TILE, TileMap::TILE };
+	++drawCalls_;
+	if (SDL_RenderCopy(renderer_, imageTexture, nullptr, &destination) != 0) {
+	  close();
+	  throw domain_error(string("Unable to render a tile due to: ")
+			     + SDL_GetError());
+	}
+      }
+    }
+  }
+}
+
+void World::drawSprite(const Sprite& sprite) {
+  // The location of the sprite is a square
+
+  SDL_Rect destination = { sprite.getXCoordinate(), sprite.getYCoordinate(), 
+			   sprite.getWidth(), sprite.getHeight() };
+
+  // Get the image index and check that it is valid
+
+  unsigned int imageIndex = sprite.getImageIndex();
+  if (imageIndex < static_cast<unsigned int>(textures_.size())) {
+
+    // Get the image for the sprite
+
+    SDL_Texture* imageTexture = textures_.get(imageIndex);
+    if (imageTexture) {
+
+      // Render the pre-rendered frame for the sprite's angle if
+      // there is one, otherwise render the image at the location,
+      // rotated by its angle
+
+      SDL_Rect source;
+      int result;
+      ++drawCalls_;
+      if (findRotation(sprite, source, destination)) {
+	result = SDL_RenderCopy(renderer_, rotations_.at(imageIndex).strip,
+				&source, &destination);
+      } else {
+	result = SDL_RenderCopyEx(renderer_, imageTexture, nullptr,
+				  &destination, sprite.getAngle(), 
+				  nullptr, SDL_FLIP_NONE);
+      }
+      if (result != 0) {
+	close();
+	throw domain_error(string("Unable to render a sprite due to: ")
+			   + SDL_GetError());
+      }
+    } else {
+      close();
+      throw domain_error("Missing image texture at index "
+			 + to_string(imageIndex));          
+    }
+  } else {
+    close();
+    throw domain_error("Invalid image index " 
+		       + to_string(imageIndex));
+  }
+}
+
+void World::setRace(Rollback* race) noexcept {
+  race_ = race;
+  race->setMasks(&masks_);
+
+  // The race starts straight away in its level
+  
+  currentLevel_ = race->getRace().getLevel(race->getPlayer()).getNumber();
+  level_ = Level(currentLevel_);
+  level_.setMasks(&masks_);
+  player_ = level_.getPlayer();
+  left_ = false;
+  right_ = false;
+  jump_ = false;
+  lives_ = 5;
+  health_ = 3;
+  score_ = 0;
+  time_ = 0;
+}
+
+void World::updateParticles(const Level& level) noexcept {
+  for (const shared_ptr<Sprite>& sprite : level.getList()) {
+    if (sprite->getImageIndex() == 5 || sprite->getImageIndex() == 6) {
+      particles_.trail(*sprite);
+    }
+  }
+  particles_.update();
+
+  // Share the average cost about once a second, so it can be read
+  // rather than jumping about every frame
+
+  particleTime_ += particles_.getUpdateTime();
+  if (++particleFrames_ >= 40) {
+    effectsCost_ = static_cast<int>(particleTime_ * 100 / particleFrames_ + 0.5);
+    particleTime_ = 0;
+    particleFrames_ = 0;
+  }
+}
+
+int World::particleBatch(int i) const noexcept {
+  int shade = min(FADES - 1, static_cast<int>(particles_.getLife(i)) * FADES / Particles::LIFE);
+  return particles_.getKind(i) * FADES + shade;
+}
+
+void World::drawParticles() {
+  // Sort the particles into batches: count each batch, then place
+  // each particle after the batches before its own
+
+  const int batches = Particles::KINDS * FADES;
+  int starts[batches + 1] = {};
+  for (int i = 0; i < particles_.size(); ++i) {
+    ++starts[particleBatch(i) + 1];
+  }
+  for (int batch = 0; batch < batches; ++batch) {
+    starts[batch + 1] += starts[batch];
+  }
+  int ends[batches];
+  copy(starts, starts + batches, ends);
+  for (int i = 0; i < particles_.size(); ++i) {
+    SDL_Rect rect = { static_cast<int>(particles_.getX(i)) - 2,
+		      static_cast<int>(particles_.getY(i)) - 2, 4, 4 };
+    particleRects_[ends[particleBatch(i)]++] = rect;
+  }
+
+  // Draw each batch in its color, fading out as the particles die
+
+  static const Uint8 colors[Particles::KINDS][3] = {
+    { 0xff, 0x8c, 0x00 },
+    { 0x50, 0xdc, 0x50 },
+    { 0xff, 0xd7, 0x00 }
+  };
+  SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_BLEND);
+  for (int kind = 0; kind < Particles::KINDS; ++kind) {
+    for (int shade = 0; shade < FADES; ++shade) {
+      int batch = kind * FADES + shade;
+      if (starts[batch] == starts[batch + 1]) {
+	continue;
+      }
+      SDL_SetRenderDrawColor(renderer_, colors[kind][0], colors[kind][1], colors[kind][2],
+			     (shade + 1) * 0xff / FADES);
+      ++drawCalls_;
+      if (SDL_RenderFillRects(renderer_, &particleRects_[starts[batch]],
+			      starts[batch + 1] - starts[batch]) != 0) {
+	close();
+	throw domain_error(string("Unable to render the particles due to: ")
+			   + SDL_GetError());
+      }
+    }
+  }
+  SDL_SetRenderDrawBlendMode(renderer_, SDL_BLENDMODE_NONE);
+}
+
+void World::advanceRace() {
+
+  // Send the held keys, keeping a jump until the race takes it
+
+  Uint8 input = 0;
+  if (left_) {
+    input |= Race::LEFT;
+  } else if (right_) {
+    input |= Race::RIGHT;
+  }
+  if (jump_) {
+    input |= Race::UP;
+  }
+  if (race_->advance(input)) {
+    jump_ = false;
+  }
+
+  // Show the local player's progress
+
+  const Race& race = race_->getRace();
+  const Race::Racer& local = race.getRacer(race_->getPlayer());
+  const Race::Racer& remote = race.getRacer(1 - race_->getPlayer());
+  lives_ = local.lives;
+  health_ = local.health;
+  score_ = local.score;
+
+  // Once the race is over, and that is no longer a prediction, show
+  // the win screen if the local player got to the end or outlasted
+  // the other player, otherwise the game over screen
+
+  if (race.over() && race_->getConfirmedTick() >= race.getTick() - 1) {
+    if (local.finished >= 0 || (remote.lives <= 0 && local.lives > 0)) {
+      currentLevel_ = -2;
+      if (highScore_ < score_) {
+	highScore_ = score_;
+      }
+    } else {
+      currentLevel_ = -1;
+    }
+    level_ = Level(currentLevel_);
+    level_.setMasks(&masks_);
+    player_ = level_.getPlayer();
+    lives_ = 5;
+    health_ = 3;
+  }
+}
+
+void World::drawRace() {
+  const Race& race = race_->getRace();
+  int local = race_->getPlayer();
+  drawTiles(race.getLevel(local).getTiles());
+  for (const shared_ptr<Sprite>& sprite : race.getLevel(local).getList()) {
+    drawSprite(*sprite);
+  }
+
+  // Draw the other player faded over the top
+
+  shared_ptr<Player> other = race.getLevel(1 - local).getPlayer().lock();
+  SDL_Texture* image = textures_.get(other->getImageIndex());
+  SDL_SetTextureAlphaMod(image, 128);
+  drawSprite(*other);
+  SDL_SetTextureAlphaMod(image, 255);
 }
@@ -8,10 +8,21 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include "FramePhase.h"
+#include "History.h"
 #include "RelevantEvent.h"
+#include "RenderMode.h"
 #include "Sprite.h"
+#include "Analytics.h"
+#include "Audio.h"
+#include "Capture.h"
 #include "Level.h"
+#include "Masks.h"
+#include "Particles.h"
 #include "Player.h"
+#include "Rollback.h"
+#include "Telemetry.h"
+#include "TextureCache.h"
 
 class SDL_Window;
 class SDL_Renderer;
@@ -35,9 +46,13 @@ class World {
 public:
 
   /**
-   * Construct the world. 
+   * Construct the world. In the offscreen mode no window is
+   * created and every frame is rendered into a surface with the
+   * software renderer, which works on hosts without a display. 
+   * @throw domain_error if SDL could not be set up
    */
-  World();
+  World(/** Where the world is rendered */
+	RenderMode mode = RenderMode::WINDOW);
 
   /**
    * Destruct the graphical display.  This closes
@@ -52,10 +67,51 @@ public:
   void close() noexcept;
 
   /**
-   * Add an image to the collection.
+   * Add an image to the collection. The image isn't loaded until a 
+   * screen needs it, when it is converted once to a format the 
+   * renderer handles natively, so that drawing it never has to 
+   * convert it. 
    */
   void addImage(/** The location of the file. */
-		const std::string& fileLocation) noexcept;
+		const std::string& fileLocation,
+		/** A color to make transparent, as 0xRRGGBB, or -1 to 
+		    keep the image's own transparency */
+		int colorKey = -1,
+		/** Whether to multiply the colors by their alpha, so 
+		    that the edges stay clean if the image is filtered. 
+		    Ignored where the renderer can't blend that way */
+		bool premultiply = false) noexcept;
+
+  /**
+   * Pre-render every rotation of an image that only ever turns in 
+   * fixed steps into a strip of frames, whenever the image is 
+   * loaded. Sprites using the image at the given size are then 
+   * drawn with a plain copy of the frame for their angle, rather 
+   * than being rotated every frame. 
+   */
+  void addRotations(/** The index of the image */
+		    int index,
+		    /** The number of degrees between rotations, which 
+			must divide 360 */
+		    int step,
+		    /** The width and height the image is drawn at */
+		    int width, int height) noexcept;
+
+  /**
+   * Make the collision mask of an image from the transparency of its
+   * file, and fit it to the size sprites draw it at and to every
+   * angle they turn it to. Sprites using the image then only touch
+   * the player where both are solid. The mask is made straight away
+   * and kept for good, so it is there before any level starts and
+   * doesn't depend on whether the image's texture is loaded. 
+   */
+  void addMask(/** The index of the image */
+	       int index,
+	       /** The width and height the image is drawn at */
+	       int width, int height,
+	       /** The number of degrees between the angles it turns
+		   to, which must divide 360, or 360 if it doesn't turn */
+	       int step = 360) noexcept;
 
   /**
    * Check for relevant events as specified in the
@@ -96,9 +152,189 @@ public:
   void drawText(/** The x and y coordinate to draw the text at */
 		int x, int y,
 		/** The string for the text */
-		std::string text,
+		const char* text,
 		/** size of the text */
 		int size); 
+
+  /**
+   * Race another machine instead of playing alone. The race starts
+   * straight away and the other player is drawn faded over the 
+   * local player's level. Once it is over the world goes to the win
+   * or game over screen, and carries on as normal when the player
+   * leaves it. 
+   */
+  void setRace(/** The local side of the race, which must outlive 
+		   the race */
+	       Rollback* race) noexcept;
+
+  /**
+   * Copies every frame drawn from now on into a capture, just 
+   * before it is shown. 
+   */
+  void setCapture(/** The capture, which must outlive its use by
+		      the world, or nullptr to stop capturing */
+		  Capture* capture) noexcept;
+
+  /**
+   * Shares how the game is running through telemetry at the end of
+   * every frame drawn from now on. 
+   */
+  void setTelemetry(/** The telemetry, which must outlive its use by
+			the world, or nullptr to stop sharing */
+		    Telemetry* telemetry) noexcept;
+
+  /**
+   * Records where the player is on every tick of a level played
+   * from now on, and where they get hurt, heal, score and die. 
+   */
+  void setAnalytics(/** The analytics, which must outlive its use by
+			the world, or nullptr to stop recording */
+		    Analytics* analytics) noexcept;
+
+  /**
+   * Fix the fraction of the window's resolution that levels are 
+   * drawn at before being stretched to fill it, or let it follow 
+   * how long frames take to draw. The overlay is always drawn at 
+   * the window's own resolution. Levels are drawn at the window's
+   * resolution if the renderer can't draw into textures. 
+   */
+  void setScale(/** The fraction, from MIN_SCALE to 1, or 0 to 
+		    lower it when frames take too long to draw and 
+		    raise it again when they are quick */
+		double scale) noexcept;
+
+  /**
+   * Get the fraction of the window's resolution that levels are 
+   * being drawn at. 
+   * @return the scale, from MIN_SCALE to 1
+   */
+  double getScale() const noexcept;
+
+  /**
+   * The lowest fraction of the window's resolution levels are
+   * drawn at. 
+   */
+  static constexpr double MIN_SCALE = 0.5;
+
+  /**
+   * Sets whether to save work while nothing changes. A menu screen
+   * that is already shown isn't drawn again, a level is paused while
+   * the window is in the background, and a race, which can't pause,
+   * is slowed to the frame rate while the window is hidden. Idling
+   * is on by default, but never happens offscreen or while
+   * capturing, where every frame counts. 
+   */
+  void setIdling(/** Whether to idle */
+		 bool idling) noexcept;
+
+  /**
+   * Get how long to wait for an event before refreshing the world 
+   * again, as nothing will change until one arrives. 
+   * @return the milliseconds to wait, or 0 to refresh straight away
+   */
+  int getIdleWait() const noexcept;
+
+  /**
+   * Get the number of refreshes that drew nothing, as nothing had
+   * changed. 
+   * @return the number of refreshes
+   */
+  int getIdleFrames() const noexcept;
+
+  /**
+   * Get the number of times the overlay has been re-rendered. 
+   * Useful for profiling, since in steady state this should 
+   * not change from frame to frame. 
+   * @return the number of overlay rebuilds so far
+   */
+  int getOverlayRebuilds() const noexcept;
+
+  /**
+   * Get the number of heap allocations, including SDL's, made 
+   * during a phase of the last frame. Once a level is under way
+   * none of them should allocate, and an offscreen run fails if 
+   * any do. 
+   * @return the number of allocations
+   */
+  long getAllocations(/** The phase */
+		      FramePhase phase) const noexcept;
+
+  /**
+   * Get the current level, which is 0 on the title screen, -1 on 
+   * the game over screen and -2 on the win screen. 
+   * @return the level
+   */
+  int getLevel() const noexcept;
+
+  /**
+   * Prints the format and size of each texture made from an image,
+   * and whether drawing it is a straight copy to the screen, then
+   * which images are loaded and how well the cache of them did. 
+   */
+  void reportImages(/** Where to print the report */
+		    std::ostream& out) const;
+
+  /**
+   * The memory images can take by default before those no screen 
+   * needs are unloaded, which leaves room for a menu screen or two 
+   * besides a level's. 
+   */
+  static const std::size_t TEXTURE_BUDGET = 8 << 20;
+
+  /**
+   * Set the memory images can take before those no screen needs are
+   * unloaded, those used longest ago first. The images on screen
+   * stay loaded whatever the budget. 
+   */
+  void setTextureBudget(/** The budget in bytes */
+			std::size_t budget) noexcept;
+
+  /**
+   * Get which images are loaded, and how well the cache of them 
+   * has done. 
+   * @return the cache
+   */
+  const TextureCache& getTextures() const noexcept;
+
+  /**
+   * Get the history the level can be run backwards through while 
+   * the rewind key is held. 
+   * @return the history
+   */
+  const History& getHistory() const noexcept;
+
+  /**
+   * Get the particles of the effects being shown. 
+   * @return the particles
+   */
+  const Particles& getParticles() const noexcept;
+
+  /**
+   * Get the sound effects and music. 
+   * @return the audio
+   */
+  const Audio& getAudio() const noexcept;
+
+  /**
+   * Get a hash of the most recently rendered frame. This is only 
+   * computed in the offscreen mode, and can be compared against 
+   * a known good hash to catch visual changes. 
+   * @return the hash of the last frame, or 0 if there is none
+   */
+  Uint64 getFrameHash() const noexcept;
+
+  /**
+   * Get the number of frames rendered so far.
+   * @return the number of rendered frames
+   */
+  int getFrameCount() const noexcept;
+
+  /**
+   * Get the average number of frames rendered per second since
+   * the first frame. 
+   * @return the rendered frames per second
+   */
+  double getFramesPerSecond() const noexcept;
   
 private:
 
@@ -112,6 +348,26 @@ private:
    */
   bool right_ = false;
 
+  /** 
+   * Indicates if player was told to jump since the last tick
+   */
+  bool jump_ = false;
+
+  /** 
+   * Indicates if the level is being run backwards
+   */
+  bool rewind_ = false;
+
+  /**
+   * The last few seconds of the level, to run it backwards through
+   */
+  History history_;
+
+  /**
+   * The level the history is of, or 0 if it isn't of any
+   */
+  int historyLevel_ = 0;
+
   /** 
    * The number of lives the player has
    */
@@ -159,20 +415,181 @@ private:
    */
   std::weak_ptr<Player> player_ = level_.getPlayer(); 
 
+  /** 
+   * The race being played, or nullptr if playing alone
+   */
+  Rollback* race_ = nullptr;
+
+  /** 
+   * The capture frames are copied into, or nullptr
+   */
+  Capture* capture_ = nullptr;
+
   /** 
    * The display window. 
    */
   SDL_Window* window_ = nullptr;
 
+  /** 
+   * The offscreen surface rendered into in the offscreen mode. 
+   */
+  SDL_Surface* surface_ = nullptr;
+
   /** 
    * The display rendering tool. 
    */
   SDL_Renderer* renderer_ = nullptr;
 
   /** 
-   * The collection of images. 
+   * The hash of the last frame rendered offscreen
+   */
+  Uint64 frameHash_ = 0;
+
+  /** 
+   * The number of frames rendered
+   */
+  int frameCount_ = 0;
+
+  /** 
+   * The performance counter value when the first frame was rendered
+   */
+  Uint64 firstFrame_ = 0;
+
+  /**
+   * The images the world draws itself, by index
+   */
+  enum Image {
+    BACKGROUND, TITLE, PLAYER_RIGHT, PLAYER_LEFT, PLATFORM, OBSTACLE, 
+    BALL, HEALTH, COIN, LIVES, GAME_OVER, WIN
+  };
+
+  /**
+   * Where an image comes from, and what is made from it when it is
+   * loaded
+   */
+  struct Asset {
+    /** The location of the file */
+    std::string file;
+    /** The color made transparent, or -1 */
+    int colorKey = -1;
+    /** Whether the colors are multiplied by their alpha */
+    bool premultiply = false;
+    /** Whether its mask has been made */
+    bool masked = false;
+    /** The size and step its mask is fitted to, if it is */
+    int maskWidth = 0;
+    int maskHeight = 0;
+    int maskStep = 0;
+  };
+
+  /** 
+   * The collection of images, by index
+   */
+  std::vector<Asset> assets_;
+
+  /**
+   * The textures of the images loaded
+   */
+  TextureCache textures_;
+
+  /**
+   * The images held for the screen shown, and which screen that is
+   */
+  std::vector<int> held_;
+  int heldLevel_ = 0;
+  bool holding_ = false;
+
+  /**
+   * A strip of pre-rendered rotations of an image. Each frame is a
+   * square large enough to hold the image at any angle. 
+   */
+  struct Rotations {
+    /** The strip of frames, or nullptr if there is none or the 
+	image isn't loaded */
+    SDL_Texture* strip = nullptr;
+    /** The number of degrees between frames */
+    int step = 0;
+    /** The width and height the image was rendered at */
+    int width = 0;
+    int height = 0;
+    /** The width and height of each frame */
+    int frameSize = 0;
+  };
+
+  /**
+   * What an image's texture was made from and into
+   */
+  struct ImageInfo {
+    /** Where the image came from */
+    std::string name;
+    /** The format it was loaded in */
+    Uint32 source = SDL_PIXELFORMAT_UNKNOWN;
+    /** The format of its texture */
+    Uint32 format = SDL_PIXELFORMAT_UNKNOWN;
+    /** The size of its texture */
+    int width = 0;
+    int height = 0;
+    std::size_t bytes = 0;
+    /** How it's blended when drawn */
+    SDL_BlendMode blend = SDL_BLENDMODE_NONE;
+    /** Whether its colors were multiplied by its alpha */
+    bool premultiplied = false;
+  };
+
+  /**
+   * The textures made from images, in the order they were first
+   * made
+   */
+  std::vector<ImageInfo> imageInfo_;
+
+  /**
+   * The collision masks of the images
+   */
+  Masks masks_;
+
+  /**
+   * The format of what the renderer draws into
+   */
+  Uint32 targetFormat_ = SDL_PIXELFORMAT_UNKNOWN;
+
+  /** 
+   * The pre-rendered rotations, by image index. 
+   */
+  std::vector<Rotations> rotations_;
+
+  /**
+   * The number of shades particles fade through as they die
+   */
+  static const int FADES = 4;
+
+  /**
+   * The sound effects and music
+   */
+  Audio audio_;
+
+  /**
+   * The sparks from fireballs and pickups
    */
-  std::vector<SDL_Texture*> images_;
+  Particles particles_;
+
+  /**
+   * The squares to draw the particles with, grouped by kind and 
+   * then shade so that each group is drawn at once
+   */
+  std::vector<SDL_Rect> particleRects_;
+
+  /**
+   * The total time spent updating particles since the effects cost
+   * was last shown, and over how many frames
+   */
+  double particleTime_ = 0;
+  int particleFrames_ = 0;
+
+  /**
+   * The average time taken to update the particles each frame, in
+   * hundredths of a millisecond, as shared through telemetry
+   */
+  int effectsCost_ = 0;
 
   /** 
    * The width of the window. 
@@ -194,10 +611,421 @@ private:
    */
   SDL_Color textColor_;
 
+  /**
+   * The printable characters, from space to tilde
+   */
+  static const char FIRST_GLYPH = ' ';
+  static const int GLYPHS = '~' - ' ' + 1;
+
+  /**
+   * A character rendered in our font
+   */
+  struct Glyph {
+    /** The rendered character */
+    SDL_Texture* texture = nullptr;
+    /** How far along the next character starts */
+    int advance = 0;
+    /** The size of the texture */
+    int width = 0;
+    int height = 0;
+  };
+
+  /**
+   * Each printable character, rendered once so that text can be
+   * drawn without making new surfaces and textures
+   */
+  Glyph glyphs_[GLYPHS];
+
+  /**
+   * The allocation count at the end of the last phase, and the
+   * number made during each phase of the last frame
+   */
+  long allocationMark_ = 0;
+  long allocations_[static_cast<int>(FramePhase::COUNT)] = {};
+
+  /**
+   * When the last phase ended, and how long each phase of the last
+   * frame took in milliseconds
+   */
+  Uint64 phaseMark_ = 0;
+  double phaseTimes_[static_cast<int>(FramePhase::COUNT)] = {};
+
+  /**
+   * The number of times the frame being drawn has drawn something
+   */
+  long drawCalls_ = 0;
+
+  /**
+   * Where telemetry is shared, if anywhere
+   */
+  Telemetry* telemetry_ = nullptr;
+
+  /**
+   * Where what happens to the player is recorded, if anywhere
+   */
+  Analytics* analytics_ = nullptr;
+
+  /**
+   * The number of recent frames whose times telemetry is shared
+   * from
+   */
+  static const int FRAME_TIMES = 256;
+
+  /**
+   * The time between the starts of recent frames in milliseconds,
+   * going round and round, and room to sort them in
+   */
+  double frameTimes_[FRAME_TIMES] = {};
+  double sortedTimes_[FRAME_TIMES] = {};
+
+  /**
+   * The number of frame times noted, and when the last frame
+   * shared started
+   */
+  long frameTimeCount_ = 0;
+  Uint64 sharedStart_ = 0;
+
+  /** 
+   * The cached overlay. In a level this holds the HUD (lives, 
+   * health, time and score), on a menu screen it holds the whole 
+   * screen along with its score text. 
+   */
+  SDL_Texture* overlay_ = nullptr;
+
+  /** 
+   * Whether the overlay holds anything yet
+   */
+  bool overlayValid_ = false;
+
+  /** 
+   * The level, score, high score, time, lives and health the 
+   * overlay was last built from
+   */
+  int overlayLevel_ = 0;
+  int overlayScore_ = 0;
+  int overlayHighScore_ = 0;
+  int overlayTime_ = 0;
+  int overlayLives_ = 0;
+  int overlayHealth_ = 0;
+
+  /** 
+   * The number of times the overlay has been re-rendered
+   */
+  int overlayRebuilds_ = 0;
+
+  /**
+   * The level drawn below the window's resolution, which is
+   * stretched over the window once drawn
+   */
+  SDL_Texture* scene_ = nullptr;
+
+  /**
+   * The fraction of the window's resolution levels are drawn at
+   */
+  double scale_ = 1;
+
+  /**
+   * Whether the scale follows how long frames take to draw
+   */
+  bool autoScale_ = false;
+
+  /**
+   * How long drawing a frame should take at most, in milliseconds,
+   * leaving room to spare before the next vsync
+   */
+  double frameBudget_ = 850.0 / 60;
+
+  /**
+   * When the frame being drawn started
+   */
+  Uint64 frameStart_ = 0;
+
+  /**
+   * The total time taken to draw the frames in a level since the
+   * scale was last looked at, and how many frames that was
+   */
+  double drawTime_ = 0;
+  int drawFrames_ = 0;
+
+  /**
+   * Whether to save work while nothing changes
+   */
+  bool idling_ = true;
+
+  /**
+   * Whether the window has the keyboard, and whether it can be seen
+   */
+  bool focused_ = true;
+  bool visible_ = true;
+
+  /**
+   * Whether the frame last presented still shows the screen, and
+   * the level it showed
+   */
+  bool presented_ = false;
+  int presentedLevel_ = 0;
+
+  /**
+   * The number of refreshes that drew nothing
+   */
+  int idleFrames_ = 0;
+
+  /**
+   * Get whether the level is paused while the window is in the
+   * background. 
+   * @return whether the level is paused
+   */
+  bool paused() const noexcept;
+
+  /**
+   * Get whether nothing on the screen can change until an event
+   * arrives, so the frame last presented still stands. 
+   * @return whether the world is idle
+   */
+  bool idle() const noexcept;
+
   /**
    * Clear the background to opaque white.
    */
   void clearBackground();
+
+  /**
+   * Draws the overlay for the current screen, using the cached 
+   * texture if none of the values it shows have changed. 
+   * @throw domain_error if the overlay could not be rendered
+   */
+  void drawOverlay();
+
+  /**
+   * Renders the overlay for the current screen directly to the 
+   * current render target. 
+   * @throw domain_error if unable to render an image
+   */
+  void renderOverlay();
+
+  /**
+   * Starts drawing a level into the scene rather than the window
+   * if the scale is below 1, so that it is drawn at fewer pixels 
+   * with the same coordinates. 
+   * @return whether the level is being drawn into the scene
+   * @throw domain_error if the scene could not be made
+   */
+  bool beginScene();
+
+  /**
+   * Goes back to drawing into the window, stretching the scene 
+   * over it. 
+   * @throw domain_error if the scene could not be drawn
+   */
+  void endScene();
+
+  /**
+   * Adds how long the frame took to draw to the running total, 
+   * and every SCALE_FRAMES frames moves the scale towards what 
+   * fits the frame budget. 
+   */
+  void adjustScale() noexcept;
+
+  /**
+   * Draws a sprite at its location and angle. 
+   * @throw domain_error if unable to render the sprite
+   */
+  void drawSprite(/** The sprite to draw */
+		  const Sprite& sprite);
+
+  /**
+   * Draws the tiles of a tile map that are on the screen. 
+   * @throw domain_error if unable to render a tile
+   */
+  void drawTiles(/** The tiles to draw */
+		 const TileMap& tiles);
+
+  /**
+   * Get the renderer's own texture format that suits an image, 
+   * preferring the format of what it draws into. 
+   * @return the format
+   */
+  Uint32 nativeFormat(/** Whether the image has transparent parts */
+		      bool alpha) const noexcept;
+
+  /**
+   * Makes a texture from a surface in a format the renderer 
+   * handles natively. 
+   * @return the texture, or nullptr if it could not be made
+   */
+  SDL_Texture* createTexture(/** The surface, which may be given a
+				 color key */
+			     SDL_Surface* surface,
+			     /** A color to make transparent, as 0xRRGGBB, 
+				 or -1 for none */
+			     int colorKey,
+			     /** Whether to premultiply the alpha */
+			     bool premultiply,
+			     /** Filled in with what was made */
+			     ImageInfo& info) noexcept;
+
+  /**
+   * Renders each printable character of our font. 
+   * @throw domain_error if a character could not be rendered
+   */
+  void loadGlyphs();
+
+  /**
+   * Loads an image into a texture, along with its rotations. 
+   * @return the texture, or nullptr if it could not be loaded
+   */
+  SDL_Texture* loadImage(/** The index of the image */
+			 int index,
+			 /** Set to the memory the texture and its 
+			     rotations take */
+			 std::size_t& bytes) noexcept;
+
+  /**
+   * Destroys the texture of an image and its rotations. 
+   */
+  void unloadImage(/** The index of the image */
+		   int index,
+		   /** Its texture */
+		   SDL_Texture* texture) noexcept;
+
+  /**
+   * Pre-renders the rotations asked for of an image just loaded. 
+   * @return the memory they take
+   */
+  std::size_t renderRotations(/** The index of the image */
+			      int index,
+			      /** Its texture */
+			      SDL_Texture* texture) noexcept;
+
+  /**
+   * Makes the mask of an image from its file, whether or not its
+   * texture is loaded. 
+   */
+  void makeMask(/** The index of the image */
+		int index) noexcept;
+
+  /**
+   * Fits the mask of an image as asked for, once it has one. 
+   */
+  void fitMask(/** The index of the image */
+	       int index) noexcept;
+
+  /**
+   * Notes what a texture was made from and into, replacing what was
+   * noted when it was last made. 
+   */
+  void noteImage(/** What was made */
+		 const ImageInfo& info);
+
+  /**
+   * Gets the images a screen needs. 
+   */
+  void screenImages(/** The level, or 0, -1 or -2 for the title, 
+			game over or win screen */
+		    int level,
+		    /** Whether to include the images of the sprites in
+			the level shown, rather than just those every
+			level has */
+		    bool sprites,
+		    /** Set to the images */
+		    std::vector<int>& images) const;
+
+  /**
+   * Remembers the tick the level just ran, starting the history
+   * over if the level is new. 
+   */
+  void recordTick() noexcept;
+
+  /**
+   * Runs the level back a tick, along with the score, health, lives 
+   * and time, if there is any history left. 
+   */
+  void rewindTick() noexcept;
+
+  /**
+   * Records something happening to the player on the tick the level
+   * just ran, if recording analytics. 
+   */
+  void recordEvent(/** What happened */
+		   Analytics::Event event,
+		   /** Where the middle of the player was */
+		   int x, int y) noexcept;
+
+  /**
+   * Holds the images the screen shown needs, once it changes, lets
+   * go of those the last screen needed, and loads those the next
+   * screens are likely to need ahead of time. 
+   */
+  void holdImages();
+
+  /**
+   * Notes the allocations made since the end of the last phase 
+   * as made during a phase. 
+   */
+  void endPhase(/** The phase that just ended */
+		FramePhase phase) noexcept;
+
+  /**
+   * Shares how the frame just drawn went through the telemetry. 
+   */
+  void shareTelemetry() noexcept;
+
+  /**
+   * Emits embers behind each of a level's fireballs, and moves all
+   * of the particles. 
+   */
+  void updateParticles(/** The level being shown */
+		       const Level& level) noexcept;
+
+  /**
+   * Get which batch a particle is drawn in, from its kind and how 
+   * faded it is. 
+   * @return the batch
+   */
+  int particleBatch(/** The particle */
+		    int i) const noexcept;
+
+  /**
+   * Draws the particles as blended squares, one batch per color 
+   * and shade. 
+   * @throw domain_error if unable to render the particles
+   */
+  void drawParticles();
+
+  /**
+   * Advances the race by a tick with the held keys, and ends it 
+   * once either player has won. 
+   */
+  void advanceRace();
+
+  /**
+   * Draws the local player's level and the other player. 
+   * @throw domain_error if unable to render a sprite
+   */
+  void drawRace();
+
+  /**
+   * Finds the pre-rendered frame to draw a sprite with. 
+   * @return whether there is a frame for the sprite's image, size
+   * and angle
+   */
+  bool findRotation(/** The sprite to draw */
+		    const Sprite& sprite,
+		    /** Set to the frame within the strip */
+		    SDL_Rect& source,
+		    /** Set to where to draw the frame */
+		    SDL_Rect& destination) const noexcept;
+
+  /**
+   * Copies the frame drawn into the capture, or drops it if the 
+   * capture has no buffer free. 
+   */
+  void captureFrame() noexcept;
+
+  /**
+   * Hashes the pixels of the offscreen surface into frameHash_.
+   */
+  void hashFrame() noexcept;
 };
 }
 
@@ -0,0 +1,93 @@
+#include "Writer.h"
+
+#include <chrono>
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * How long either side waits before looking again, in case it
+ * missed being woken.
+ */
+static const chrono::milliseconds NAP(5);
+
+Writer::~Writer() {
+  close();
+}
+
+void Writer::start(Write write) {
+  write_ = write;
+  for (int buffer = 0; buffer < BUFFERS; ++buffer) {
+    free_.push(buffer);
+  }
+  thread_ = thread(&Writer::run, this);
+}
+
+void Writer::close() noexcept {
+  if (!thread_.joinable()) {
+    return;
+  }
+  stopping_.store(true, memory_order_release);
+  ready_.notify_one();
+  thread_.join();
+}
+
+int Writer::acquire(bool wait) noexcept {
+  int buffer;
+  if (!thread_.joinable()) {
+    return -1;
+  }
+  if (free_.pop(buffer)) {
+    return buffer;
+  }
+  if (!wait) {
+    return -1;
+  }
+  unique_lock<mutex> lock(mutex_);
+  while (!free_.pop(buffer)) {
+    freed_.wait_for(lock, NAP);
+  }
+  return buffer;
+}
+
+void Writer::submit(int buffer) noexcept {
+  // there are only as many buffers as the ring holds, so there is
+  // always room
+  full_.push(buffer);
+  ready_.notify_one();
+}
+
+long Writer::getWritten() const noexcept {
+  return written_.load(memory_order_relaxed);
+}
+
+bool Writer::failed() const noexcept {
+  return failed_.load(memory_order_relaxed);
+}
+
+void Writer::run() noexcept {
+  for (;;) {
+    // looks at whether to stop before looking for a buffer, so that
+    // every buffer handed over before stopping is written
+    bool stopping = stopping_.load(memory_order_acquire);
+    int buffer;
+    if (!full_.pop(buffer)) {
+      if (stopping) {
+	return;
+      }
+      unique_lock<mutex> lock(mutex_);
+      ready_.wait_for(lock, NAP);
+      continue;
+    }
+    if (!failed_.load(memory_order_relaxed)) {
+      long written = write_(buffer);
+      if (written >= 0) {
+	written_.fetch_add(written, memory_order_relaxed);
+      } else {
+	failed_.store(true, memory_order_relaxed);
+      }
+    }
+    free_.push(buffer);
+    freed_.notify_one();
+  }
+}
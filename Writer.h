@@ -0,0 +1,151 @@
+#ifndef MEDIEVAL_WRITER_H
+#define MEDIEVAL_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "Ring.h"
+
+namespace medieval {
+
+/**
+ * A writer class. This class writes buffers out on a thread of its
+ * own while the game carries on. The buffers themselves belong to
+ * whatever is being written, and are passed around by number: the
+ * game takes a free one, fills it and hands it through a ring to the
+ * writer, which writes it and gives it back through another ring. 
+ * Neither side locks or allocates to pass a buffer, and the writer
+ * wakes up by itself every few milliseconds, so the game never has
+ * to take a lock to wake it. Only one thread may take and hand over
+ * buffers.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+class Writer {
+public:
+
+  /**
+   * The number of buffers, which must be a power of two.
+   */
+  static const int BUFFERS = 8;
+
+  /**
+   * Writes a buffer, given its number, on the writer's thread.
+   * Returns the number of things it wrote, which is added to those
+   * written, or a negative number if writing failed, after which
+   * nothing more is written.
+   */
+  typedef std::function<long(int buffer)> Write;
+
+  /**
+   * Construct a writer that isn't writing yet. 
+   */
+  Writer() = default;
+
+  /**
+   * The thread holds a pointer to the writer, so it can't be copied.
+   */
+  Writer(const Writer&) = delete;
+  Writer& operator=(const Writer&) = delete;
+
+  /**
+   * Close the writer.
+   */
+  ~Writer();
+
+  /**
+   * Starts the thread, with every buffer free.
+   */
+  void start(/** Writes a buffer */
+	     Write write);
+
+  /**
+   * Writes the buffers handed over and stops the thread. Any buffer
+   * handed over after is never written.
+   */
+  void close() noexcept;
+
+  /**
+   * Takes a free buffer to fill.
+   * @return the buffer, or -1 if there is none or the writer is
+   * closed
+   */
+  int acquire(/** Whether to wait for a buffer to be written rather
+		  than go without */
+	      bool wait) noexcept;
+
+  /**
+   * Hands a buffer taken by acquire to the thread to write.
+   */
+  void submit(/** The buffer */
+	      int buffer) noexcept;
+
+  /**
+   * Get the number of things written.
+   * @return the number written
+   */
+  long getWritten() const noexcept;
+
+  /**
+   * Get whether writing a buffer failed.
+   * @return whether the writer failed
+   */
+  bool failed() const noexcept;
+
+private:
+
+  /**
+   * Writes a buffer
+   */
+  Write write_;
+
+  /**
+   * The buffers free to fill, passed back by the thread
+   */
+  Ring<int, BUFFERS> free_;
+
+  /**
+   * The buffers to write, passed on by the game
+   */
+  Ring<int, BUFFERS> full_;
+
+  /**
+   * The things written
+   */
+  std::atomic<long> written_{0};
+
+  /**
+   * Whether writing failed
+   */
+  std::atomic<bool> failed_{false};
+
+  /**
+   * Whether the thread should stop once it has written every buffer
+   */
+  std::atomic<bool> stopping_{false};
+
+  /**
+   * Wakes the thread when there is a buffer to write, and a game
+   * waiting for a buffer when one is free
+   */
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::condition_variable freed_;
+
+  /**
+   * The thread
+   */
+  std::thread thread_;
+
+  /**
+   * Writes buffers until stopped.
+   */
+  void run() noexcept;
+};
+
+}
+
+#endif
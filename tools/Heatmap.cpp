@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../Analytics.h"
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * @file A tool that builds heatmaps of where players are, get hurt
+ * and die in each level, from the analytics of any number of games
+ * recorded with "main --analytics path". Each file is read a column
+ * at a time straight into arrays, then every record is counted into
+ * the cell of a grid over its level that it happened in. Each map is
+ * written as a greyscale PGM image, brighter where more happened on a
+ * logarithmic scale so that rare places still show, and the busiest
+ * cells of each are printed.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+/**
+ * The names of the events, for the files written. 
+ */
+static const char* const NAMES[] = { "time", "damage", "health", "coins", "deaths" };
+
+/**
+ * The number of busiest cells printed for each map. 
+ */
+static const int BUSIEST = 3;
+
+/**
+ * Every record read, a column at a time. 
+ */
+struct Records {
+  vector<int32_t> ticks;
+  vector<int16_t> levels;
+  vector<uint8_t> events;
+  vector<int32_t> xs;
+  vector<int32_t> ys;
+};
+
+/**
+ * Reads some values of a column onto the end of it.
+ * @return whether they were all read
+ */
+template <typename T>
+static bool readColumn(/** The file */
+		       FILE* file,
+		       /** The column */
+		       vector<T>& column,
+		       /** The number of values */
+		       size_t count) {
+  size_t size = column.size();
+  column.resize(size + count);
+  return fread(column.data() + size, sizeof(T), count, file) == count;
+}
+
+/**
+ * Reads every record in a file.
+ * @return the number read
+ * @throw domain_error if the file can't be read or isn't analytics
+ */
+static size_t readFile(/** The path of the file */
+		       const string& path,
+		       /** The records to add to */
+		       Records& records) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    throw domain_error("Unable to open " + path);
+  }
+  uint32_t header[4];
+  if (fread(header, sizeof(header), 1, file) != 1 || header[0] != Analytics::FILE_MAGIC ||
+      header[1] != Analytics::VERSION) {
+    fclose(file);
+    throw domain_error(path + " isn't analytics from this version of the game");
+  }
+
+  // a game that stopped in the middle of writing a block leaves the
+  // blocks before it whole
+  size_t read = 0;
+  uint32_t block[2];
+  while (fread(block, sizeof(block), 1, file) == 1 && block[0] == Analytics::BLOCK_MAGIC &&
+	 block[1] <= static_cast<uint32_t>(Analytics::BLOCK)) {
+    size_t count = block[1];
+    size_t before = records.ticks.size();
+    if (!readColumn(file, records.ticks, count) || !readColumn(file, records.levels, count) ||
+	!readColumn(file, records.events, count) || !readColumn(file, records.xs, count) ||
+	!readColumn(file, records.ys, count)) {
+      records.ticks.resize(before);
+      records.levels.resize(before);
+      records.events.resize(before);
+      records.xs.resize(before);
+      records.ys.resize(before);
+      break;
+    }
+    read += count;
+  }
+  fclose(file);
+  return read;
+}
+
+/**
+ * A heatmap of one kind of event in one level. 
+ */
+struct Heatmap {
+  /** The top left of the area it covers */
+  int left = 0;
+  int top = 0;
+  /** The number of cells across and down */
+  int width = 0;
+  int height = 0;
+  /** The number of events in each cell, row by row */
+  vector<long> cells;
+  /** The number of events */
+  long total = 0;
+};
+
+/**
+ * Writes a heatmap as a PGM image.
+ * @return whether it was written
+ */
+static bool writeImage(/** The path of the image */
+		       const string& path,
+		       /** The heatmap */
+		       const Heatmap& map) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+  long busiest = *max_element(map.cells.begin(), map.cells.end());
+  vector<uint8_t> pixels(map.cells.size());
+  for (size_t i = 0; i < map.cells.size(); ++i) {
+    pixels[i] = static_cast<uint8_t>(lround(255 * log1p(map.cells[i]) / log1p(busiest)));
+  }
+  fprintf(file, "P5\n%d %d\n255\n", map.width, map.height);
+  bool written = fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+  return fclose(file) == 0 && written;
+}
+
+/**
+ * The main program for the tool. Run as "heatmap prefix cell file..."
+ * it reads every file, and writes a heatmap of each kind of event in
+ * each level to prefix-level-kind.pgm, with each pixel a square cell
+ * of the given number of pixels of the level.
+ * @return the exit status, which is 0 if every file was read
+ */
+int main(int argc, char* argv[]) {
+  try {
+    if (argc < 4) {
+      cerr << "Usage: " << argv[0] << " prefix cell file..." << endl;
+      return 1;
+    }
+    string prefix = argv[1];
+    int cell = stoi(argv[2]);
+    if (cell < 1) {
+      cerr << "A cell must be at least a pixel" << endl;
+      return 1;
+    }
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Records records;
+    for (int i = 3; i < argc; ++i) {
+      readFile(argv[i], records);
+    }
+    size_t count = records.ticks.size();
+    double reading = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // finds the area each level's records cover, so that the grid
+    // over it starts at its top left
+    start = chrono::steady_clock::now();
+    map<int, Heatmap> areas;
+    map<int, int> rights;
+    map<int, int> bottoms;
+    for (size_t i = 0; i < count; ++i) {
+      int level = records.levels[i];
+      int x = records.xs[i] / cell * cell - (records.xs[i] < 0 && records.xs[i] % cell ? cell : 0);
+      int y = records.ys[i] / cell * cell - (records.ys[i] < 0 && records.ys[i] % cell ? cell : 0);
+      auto found = areas.find(level);
+      if (found == areas.end()) {
+	Heatmap& area = areas[level];
+	area.left = x;
+	area.top = y;
+	rights[level] = x;
+	bottoms[level] = y;
+      } else {
+	found->second.left = min(found->second.left, x);
+	found->second.top = min(found->second.top, y);
+	rights[level] = max(rights[level], x);
+	bottoms[level] = max(bottoms[level], y);
+      }
+    }
+
+    // counts every record into its level's grid for its event
+    const int events = static_cast<int>(Analytics::Event::COUNT);
+    map<int, vector<Heatmap>> maps;
+    for (auto& area : areas) {
+      Heatmap& grid = area.second;
+      grid.width = (rights[area.first] - grid.left) / cell + 1;
+      grid.height = (bottoms[area.first] - grid.top) / cell + 1;
+      grid.cells.assign(static_cast<size_t>(grid.width) * grid.height, 0);
+      maps[area.first].assign(events, grid);
+    }
+    long unknown = 0;
+    int lastLevel = 0;
+    vector<Heatmap>* levelMaps = nullptr;
+    for (size_t i = 0; i < count; ++i) {
+      if (!levelMaps || records.levels[i] != lastLevel) {
+	lastLevel = records.levels[i];
+	levelMaps = &maps[lastLevel];
+      }
+      if (records.events[i] >= events) {
+	++unknown;
+	continue;
+      }
+      Heatmap& heatmap = (*levelMaps)[records.events[i]];
+      int column = (records.xs[i] - heatmap.left) / cell;
+      int row = (records.ys[i] - heatmap.top) / cell;
+      ++heatmap.cells[static_cast<size_t>(row) * heatmap.width + column];
+      ++heatmap.total;
+    }
+    double counting = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    // writes every map with anything in it, and prints where the
+    // most happened
+    bool written = true;
+    for (auto& level : maps) {
+      for (int event = 0; event < events; ++event) {
+	const Heatmap& heatmap = level.second[event];
+	if (heatmap.total == 0) {
+	  continue;
+	}
+	string path = prefix + "-" + to_string(level.first) + "-" + NAMES[event] + ".pgm";
+	if (!writeImage(path, heatmap)) {
+	  cerr << "Unable to write " << path << endl;
+	  written = false;
+	}
+	vector<size_t> order(heatmap.cells.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+	  order[i] = i;
+	}
+	size_t shown = min(order.size(), static_cast<size_t>(BUSIEST));
+	partial_sort(order.begin(), order.begin() + shown, order.end(), [&](size_t a, size_t b) {
+	    return heatmap.cells[a] > heatmap.cells[b];
+	  });
+	cout << "Level " << level.first << ", " << NAMES[event] << ": " << heatmap.total
+	     << " records over " << heatmap.width << "x" << heatmap.height << " cells in " << path
+	     << ", busiest at";
+	for (size_t i = 0; i < shown && heatmap.cells[order[i]] > 0; ++i) {
+	  cout << (i > 0 ? "," : "") << " (" << heatmap.left + static_cast<int>(order[i] % heatmap.width) * cell
+	       << ", " << heatmap.top + static_cast<int>(order[i] / heatmap.width) * cell << ") "
+	       << heatmap.cells[order[i]];
+	}
+	cout << endl;
+      }
+    }
+    cout << "Read " << count << " records from " << argc - 3 << " files in " << reading * 1000
+	 << " ms and counted them in " << counting * 1000 << " ms ("
+	 << count / max(reading + counting, 1e-9) / 1e6 << " million a second)";
+    if (unknown > 0) {
+      cout << ", " << unknown << " of unknown events skipped";
+    }
+    cout << endl;
+    return written ? 0 : 1;
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
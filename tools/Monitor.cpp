@@ -0,0 +1,109 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../Telemetry.h"
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * @file A monitor that watches a running game through the telemetry
+ * it shares, as started with "main --telemetry name", and prints a
+ * line of its counters every so often. It only reads the shared
+ * memory, so any number of monitors can watch a game without slowing
+ * it down, and it waits for the game to start if it hasn't yet.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+/**
+ * The longest to wait for the game to start, in seconds. 
+ */
+static const int START_WAIT = 10;
+
+/**
+ * Opens the telemetry of a game, waiting for the game to start.
+ * @return the telemetry
+ * @throw domain_error if the game doesn't start in time
+ */
+static Telemetry* open(/** The name of the segment */
+		       const string& name) {
+  for (int tries = 0;; ++tries) {
+    try {
+      return new Telemetry(name, false);
+    } catch (const domain_error&) {
+      if (tries >= START_WAIT * 10) {
+	throw;
+      }
+      this_thread::sleep_for(chrono::milliseconds(100));
+    }
+  }
+}
+
+/**
+ * The main program for the monitor. Run as "monitor name [interval
+ * [samples]]" it prints the counters every interval milliseconds
+ * (1000 by default), as many times as asked or until the game ends.
+ * @return the exit status, which is 1 if the game ended before
+ * every sample asked for was read
+ */
+int main(int argc, char* argv[]) {
+  try {
+    if (argc < 2 || argc > 4) {
+      cerr << "Usage: " << argv[0] << " name [interval [samples]]" << endl;
+      return 1;
+    }
+    string name = argv[1];
+    int interval = argc > 2 ? stoi(argv[2]) : 1000;
+    long samples = argc > 3 ? stol(argv[3]) : -1;
+    unique_ptr<Telemetry> telemetry(open(name));
+
+    printf("%8s %8s %6s %8s %8s %8s %8s %8s %8s %7s %8s %7s %6s %6s %6s %6s %8s\n", "process",
+	   "frames", "level", "fps", "p50 ms", "p90 ms", "p99 ms", "max ms", "sim ms", "draw ms",
+	   "calls", "sprites", "awake", "allocs", "scale", "fx ms", "rewind s");
+    Telemetry::Counters counters;
+    int64_t lastShared = 0;
+    int64_t lastFrames = 0;
+    chrono::steady_clock::time_point lastTime = chrono::steady_clock::now();
+    for (long sample = 0; samples < 0 || sample < samples; ++sample) {
+      this_thread::sleep_for(chrono::milliseconds(interval));
+      int64_t shared = telemetry->read(counters);
+      chrono::steady_clock::time_point now = chrono::steady_clock::now();
+      double seconds = chrono::duration<double>(now - lastTime).count();
+
+      // a game that has ended leaves its last counters behind, so
+      // stop once the segment is gone and nothing new is shared
+      if (shared == lastShared && shared > 0 && sample > 0) {
+	try {
+	  Telemetry(name, false);
+	} catch (const domain_error&) {
+	  cerr << "The game has ended" << endl;
+	  return samples < 0 ? 0 : 1;
+	}
+      }
+      printf("%8lld %8lld %6lld %8.1f %8.2f %8.2f %8.2f %8.2f %8.2f %7.2f %8lld %7lld %6lld %6lld %6.2f"
+	     " %6.2f %8.1f\n",
+	     static_cast<long long>(counters.process), static_cast<long long>(counters.frames),
+	     static_cast<long long>(counters.level),
+	     sample > 0 ? (counters.frames - lastFrames) / seconds : 0.0,
+	     counters.frame50, counters.frame90, counters.frame99, counters.frameMax,
+	     counters.simulate, counters.draw, static_cast<long long>(counters.drawCalls),
+	     static_cast<long long>(counters.sprites), static_cast<long long>(counters.awake),
+	     static_cast<long long>(counters.allocations), counters.scale, counters.effects,
+	     counters.rewind);
+      fflush(stdout);
+      lastShared = shared;
+      lastFrames = counters.frames;
+      lastTime = now;
+    }
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,609 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Jobs.h"
+#include "../Level.h"
+#include "../Race.h"
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * @file A solver that proves a level can be completed and finds the
+ * fastest way through it. The simulation is deterministic, so a state
+ * of the level is fully described by the player, which pickups and
+ * fireballs are left, and how far the moving fireballs are through
+ * their paths. The solver searches sequences of held keys best first
+ * across all cores, always expanding every state with the lowest
+ * estimate of total ticks together. The estimate never overshoots,
+ * since the player moves at most 8 pixels right a tick, so the first
+ * sequence to reach the end is the fastest one. Runs that lose a
+ * life are dropped. If every reachable state is explored without
+ * reaching the end, the level cannot be completed without dying.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+/**
+ * The combinations of held keys tried every tick. 
+ */
+static const uint8_t INPUTS[] = { 0, Race::LEFT, Race::RIGHT, Race::UP,
+				  Race::LEFT | Race::UP, Race::RIGHT | Race::UP };
+
+/**
+ * The number of combinations of held keys. 
+ */
+static const int INPUT_COUNT = sizeof(INPUTS) / sizeof(INPUTS[0]);
+
+/**
+ * The fastest the player moves right in a tick. 
+ */
+static const int TOP_SPEED = 8;
+
+/**
+ * The most states a thread takes from a batch at a time. Smaller
+ * batches are split finer, so that every thread gets some. 
+ */
+static const size_t CHUNK = 256;
+
+/**
+ * A state of the search, along with how it was reached. 
+ */
+struct Node {
+  /** The player's position, vertical momentum and whether it is in the air */
+  int x;
+  int y;
+  int speedV;
+  bool inAir;
+  /** The player's health */
+  int8_t health;
+  /** The input that led here from the parent */
+  uint8_t input;
+  /** One bit for each pickup or fireball that is still present */
+  uint64_t present;
+  /** The tick this state is reached on */
+  int tick;
+  /** The batch the parent was expanded in, and its index there */
+  uint32_t parentBatch;
+  uint32_t parent;
+};
+
+
+/**
+ * Mixes a value into a hash. 
+ */
+static uint64_t mix(uint64_t hash, uint64_t value) {
+  hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+  hash ^= hash >> 31;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 29;
+  return hash;
+}
+
+/**
+ * A set of 64 bit state hashes that any number of threads can add to
+ * at once without locking. Two different states with the same hash
+ * would wrongly be treated as one, but with 64 bits that is
+ * vanishingly unlikely at the sizes searched.
+ */
+class VisitedSet {
+public:
+
+  /**
+   * Construct a set with room for the given number of hashes. 
+   */
+  VisitedSet(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity * 2) {
+      size *= 2;
+    }
+    slots_.reset(new atomic<uint64_t>[size]);
+    for (size_t i = 0; i < size; ++i) {
+      slots_[i].store(0, memory_order_relaxed);
+    }
+    mask_ = size - 1;
+  }
+
+  /**
+   * Adds a hash to the set.
+   * @return whether it was not already in the set
+   */
+  bool insert(uint64_t hash) noexcept {
+    // zero marks an empty slot
+    if (hash == 0) {
+      hash = 1;
+    }
+    for (size_t i = hash & mask_;; i = (i + 1) & mask_) {
+      uint64_t current = slots_[i].load(memory_order_relaxed);
+      if (current == hash) {
+	return false;
+      }
+      if (current == 0) {
+	if (slots_[i].compare_exchange_strong(current, hash, memory_order_relaxed)) {
+	  return true;
+	}
+	if (current == hash) {
+	  return false;
+	}
+      }
+    }
+  }
+
+private:
+
+  /**
+   * The open addressed table of hashes
+   */
+  unique_ptr<atomic<uint64_t>[]> slots_;
+
+  /**
+   * One less than the size of the table
+   */
+  size_t mask_;
+};
+
+/**
+ * What stays the same about a level during the search: its starting
+ * state, which of its sprites can be removed, and where the moving
+ * sprites are at each tick of their shared period. 
+ */
+class Model {
+public:
+
+  /**
+   * Construct the model of a level. 
+   * @throw domain_error if the level cannot be searched
+   */
+  Model(/** The level number */
+	int level) : level_(level) {
+    Level start(level);
+    start.save(base_);
+    end_ = start.getWidth() + 1;
+    if (base_.sprites.empty()) {
+      throw domain_error("Level " + to_string(level) + " has no player");
+    }
+
+    // every sprite after the player that can be picked up or hit is
+    // removable
+    for (size_t i = 1; i < base_.sprites.size(); ++i) {
+      int index = base_.sprites[i].imageIndex;
+      if (index >= 5 && index <= 8) {
+	removable_.push_back(i);
+      }
+    }
+    if (removable_.size() > 64) {
+      throw domain_error("Level " + to_string(level) + " has too many pickups and fireballs");
+    }
+
+    // move everything but the player until it is all back where it
+    // started, noting which sprites ever moved
+    vector<shared_ptr<Sprite>> sprites = start.getList();
+    vector<bool> moves(sprites.size());
+    Level::State state;
+    for (period_ = 1;; ++period_) {
+      if (period_ > (1 << 20)) {
+	throw domain_error("The fireballs in level " + to_string(level) + " never repeat");
+      }
+      for (size_t i = 1; i < sprites.size(); ++i) {
+	sprites[i]->move();
+      }
+      start.save(state);
+      bool repeated = true;
+      for (size_t i = 1; i < sprites.size(); ++i) {
+	const SpriteState& now = state.sprites[i];
+	const SpriteState& then = base_.sprites[i];
+	if (now.x != then.x || now.y != then.y || now.left != then.left) {
+	  moves[i] = true;
+	  repeated = false;
+	}
+      }
+      if (repeated) {
+	break;
+      }
+    }
+    for (size_t i = 1; i < sprites.size(); ++i) {
+      if (moves[i]) {
+	moving_.push_back(i);
+      }
+    }
+
+    // states are told apart by where in the period they are, and two
+    // states told apart that way must always be at least three ticks
+    // apart for the search to find the fastest route, so very short
+    // periods are repeated
+    phases_ = period_;
+    while (phases_ < 3) {
+      phases_ += period_;
+    }
+
+    // record where the moving sprites are at each tick of the period
+    for (int tick = 0; tick < period_; ++tick) {
+      start.save(state);
+      for (int i : moving_) {
+	paths_.push_back(state.sprites[i]);
+      }
+      for (size_t i = 1; i < sprites.size(); ++i) {
+	sprites[i]->move();
+      }
+    }
+  }
+
+  /**
+   * Get the node the search starts from.
+   * @return the starting node
+   */
+  Node start() const noexcept {
+    const SpriteState& player = base_.sprites[0];
+    Node node = { player.x, player.y, player.speedV, player.inAir, 3, 0, 0, 0, 0, 0 };
+    for (size_t bit = 0; bit < removable_.size(); ++bit) {
+      node.present |= uint64_t(1) << bit;
+    }
+    return node;
+  }
+
+  /**
+   * Get the hash of a node at a tick.
+   * @return the hash of everything that affects what can follow
+   */
+  uint64_t hash(const Node& node) const noexcept {
+    uint64_t hash = mix(0, static_cast<uint32_t>(node.x));
+    hash = mix(hash, static_cast<uint32_t>(node.y));
+    hash = mix(hash, static_cast<uint32_t>(node.speedV));
+    hash = mix(hash, node.inAir);
+    hash = mix(hash, static_cast<uint8_t>(node.health));
+    hash = mix(hash, node.present);
+    return mix(hash, node.tick % phases_);
+  }
+
+  /**
+   * Get the level number.
+   * @return the level number
+   */
+  int getLevel() const noexcept {
+    return level_;
+  }
+
+  /**
+   * Get a lower bound on the ticks left before the player can reach
+   * the end from a state. 
+   * @return the lower bound
+   */
+  int estimate(const Node& node) const noexcept {
+    int distance = end_ - node.x;
+    return distance <= 0 ? 0 : (distance + TOP_SPEED - 1) / TOP_SPEED;
+  }
+
+  /**
+   * Get the number of ticks before the moving sprites repeat.
+   * @return the period
+   */
+  int getPeriod() const noexcept {
+    return period_;
+  }
+
+  /**
+   * Get the state to restore for a node at a tick. 
+   */
+  void fill(/** The node */
+	    const Node& node,
+	    /** The tick */
+	    int tick,
+	    /** Where to put the state, which must start as a copy of 
+		the base state */
+	    Level::State& state) const noexcept {
+    SpriteState& player = state.sprites[0];
+    player.x = node.x;
+    player.y = node.y;
+    player.speedV = node.speedV;
+    player.inAir = node.inAir;
+    player.speedH = 0;
+    for (size_t bit = 0; bit < removable_.size(); ++bit) {
+      state.present[removable_[bit]] = (node.present >> bit) & 1;
+    }
+    const SpriteState* path = &paths_[(tick % period_) * moving_.size()];
+    for (size_t i = 0; i < moving_.size(); ++i) {
+      state.sprites[moving_[i]] = path[i];
+    }
+  }
+
+  /**
+   * Reads a node back from a saved state. 
+   */
+  void read(/** The saved state */
+	    const Level::State& state,
+	    /** The node to update */
+	    Node& node) const noexcept {
+    const SpriteState& player = state.sprites[0];
+    node.x = player.x;
+    node.y = player.y;
+    node.speedV = player.speedV;
+    node.inAir = player.inAir;
+    node.present = 0;
+    for (size_t bit = 0; bit < removable_.size(); ++bit) {
+      if (state.present[removable_[bit]]) {
+	node.present |= uint64_t(1) << bit;
+      }
+    }
+  }
+
+  /**
+   * Get the starting state of the level.
+   * @return the state at tick 0
+   */
+  const Level::State& getBase() const noexcept {
+    return base_;
+  }
+
+private:
+
+  /** The level number */
+  int level_;
+
+  /** The x coordinate the player must reach */
+  int end_;
+
+  /** The state of the level at tick 0 */
+  Level::State base_;
+
+  /** The indices of the sprites that can be removed */
+  vector<int> removable_;
+
+  /** The indices of the sprites that move */
+  vector<int> moving_;
+
+  /** The number of ticks before the moving sprites repeat */
+  int period_;
+
+  /** The number of ticks whose states are told apart */
+  int phases_;
+
+  /** The state of each moving sprite at each tick of the period */
+  vector<SpriteState> paths_;
+};
+
+/**
+ * A thread's copy of the level to simulate in. A node is restored
+ * once, and every input tried from it is taken back through the
+ * level's journal, which puts back only the sprites the tick changed
+ * rather than the whole level. 
+ */
+struct Worker {
+  Worker(const Model& model) : level(model.getLevel()), state(model.getBase()) {
+    level.setJournal(true);
+  }
+
+  /**
+   * Puts the level in the state of a node, ready to expand it. 
+   */
+  void load(const Model& model, const Node& node) noexcept {
+    model.fill(node, node.tick, state);
+    level.restore(state);
+    level.clearJournal();
+  }
+
+  /**
+   * Simulates one tick from the node last loaded, then takes it back.
+   * @return 1 if the player reached the end, 0 if the run carries 
+   * on, or -1 if the player lost a life
+   */
+  int expand(const Model& model, const Node& node, uint8_t input, Node& child) {
+    Race::Racer racer;
+    racer.health = node.health;
+    Race::step(level, racer, input, node.tick);
+    int outcome = racer.lives < 5 ? -1 : racer.finished >= 0 ? 1 : 0;
+    if (outcome == 0) {
+      level.save(result);
+      child.health = racer.health;
+      child.tick = node.tick + 1;
+      model.read(result, child);
+    }
+
+    // the last change first, in case a sprite changed more than once
+    const vector<Level::Change>& changes = level.getJournal();
+    for (size_t i = changes.size(); i-- > 0;) {
+      level.undo(changes[i]);
+    }
+    const vector<Hazards::Change>& hazardChanges = level.getHazards().getJournal();
+    for (size_t i = hazardChanges.size(); i-- > 0;) {
+      level.undo(hazardChanges[i]);
+    }
+    level.back();
+    return outcome;
+  }
+
+  /** The level being simulated */
+  Level level;
+  /** The state restored before each tick, which starts as the base */
+  Level::State state;
+  /** The state saved after each tick */
+  Level::State result;
+};
+
+/**
+ * Get a name for a combination of held keys. 
+ * @return the keys, or "-" for none
+ */
+static string name(uint8_t input) {
+  string keys;
+  if (input & Race::LEFT) {
+    keys += "L";
+  }
+  if (input & Race::RIGHT) {
+    keys += "R";
+  }
+  if (input & Race::UP) {
+    keys += "U";
+  }
+  return keys.empty() ? "-" : keys;
+}
+
+/**
+ * Plays a sequence of inputs from the start of a level.
+ * @return whether the player reaches the end without losing a life
+ */
+static bool replay(int levelNumber, const vector<uint8_t>& inputs) {
+  Level level(levelNumber);
+  Race::Racer racer;
+  for (size_t tick = 0; tick < inputs.size(); ++tick) {
+    Race::step(level, racer, inputs[tick], tick);
+  }
+  return racer.finished >= 0 && racer.lives == 5;
+}
+
+/**
+ * The solver. Run as "solver level [threads] [ticks] [states]" to
+ * search the level with the given number of threads, for routes of
+ * up to the given number of ticks, storing up to the given number of
+ * states.
+ * @return 0 if a way through was found, 1 on error and 2 if not
+ */
+int main(int argc, char* argv[]) {
+  try {
+    if (argc < 2 || argc > 5) {
+      cerr << "Usage: " << argv[0] << " level [threads] [ticks] [states]" << endl;
+      return 1;
+    }
+    int levelNumber = stoi(argv[1]);
+    int threads = argc > 2 ? max(1, stoi(argv[2])) : max(1u, thread::hardware_concurrency());
+    int maxTicks = argc > 3 ? stoi(argv[3]) : 3600;
+    size_t maxStates = argc > 4 ? stoul(argv[4]) : 8000000;
+
+    Model model(levelNumber);
+    VisitedSet visited(maxStates);
+    Node first = model.start();
+    visited.insert(model.hash(first));
+
+    // the states waiting to be expanded, by their estimate of total
+    // ticks, and every batch of states expanded so far
+    map<int, vector<Node>> open;
+    open[model.estimate(first)].push_back(first);
+    vector<vector<Node>> batches;
+
+    size_t stored = 1;
+    uint64_t expanded = 0;
+    Jobs jobs(threads);
+    atomic<int> claimed(0);
+    vector<unique_ptr<Worker>> workers;
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back(new Worker(model));
+    }
+    vector<vector<Node>> found(threads);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    // the winning state and input with the lowest index, so the
+    // answer does not depend on which thread finds it first
+    uint64_t winner = UINT64_MAX;
+    mutex winnerLock;
+    string outcome = "exhausted";
+    while (!open.empty()) {
+
+      // take every state with the lowest estimate as the next batch
+      batches.push_back(move(open.begin()->second));
+      open.erase(open.begin());
+      const vector<Node>& batch = batches.back();
+      uint32_t batchIndex = batches.size() - 1;
+
+      // expand the batch in chunks across the threads, each of which
+      // claims its own worker the first time it expands anything
+      for (vector<Node>& nodes : found) {
+	nodes.clear();
+      }
+      size_t grain = max<size_t>(1, min(CHUNK, batch.size() / (threads * 4)));
+      jobs.run(static_cast<int>(batch.size()), static_cast<int>(grain), [&](int begin, int end) {
+	  static thread_local int slot = -1;
+	  if (slot < 0) {
+	    slot = claimed++;
+	  }
+	  Worker& worker = *workers[slot];
+	  Node child;
+	  for (int i = begin; i < end; ++i) {
+	    const Node& node = batch[i];
+	    if (node.tick >= maxTicks) {
+	      continue;
+	    }
+	    worker.load(model, node);
+	    for (int input = 0; input < INPUT_COUNT; ++input) {
+	      // jumping does nothing in the air
+	      if (node.inAir && (INPUTS[input] & Race::UP)) {
+		continue;
+	      }
+	      int result = worker.expand(model, node, INPUTS[input], child);
+	      if (result > 0) {
+		lock_guard<mutex> guard(winnerLock);
+		winner = min(winner, static_cast<uint64_t>(i) * INPUT_COUNT + input);
+	      } else if (result == 0 && visited.insert(model.hash(child))) {
+		child.parentBatch = batchIndex;
+		child.parent = i;
+		child.input = INPUTS[input];
+		found[slot].push_back(child);
+	      }
+	    }
+	  }
+	});
+      expanded += batch.size();
+
+      if (winner != UINT64_MAX) {
+	outcome = "solved";
+	break;
+      }
+      for (vector<Node>& nodes : found) {
+	for (const Node& node : nodes) {
+	  open[node.tick + model.estimate(node)].push_back(node);
+	}
+	stored += nodes.size();
+      }
+      if (stored > maxStates) {
+	outcome = "full";
+	break;
+      }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Level " << levelNumber << ": expanded " << expanded << " states ("
+	 << stored << " distinct) in " << seconds << " s with " << threads
+	 << " threads, " << expanded / max(seconds, 1e-9) << " states per second" << endl;
+    cout << "The moving fireballs repeat every " << model.getPeriod() << " ticks" << endl;
+
+    if (outcome == "solved") {
+      // walk back up through the parents to recover the inputs
+      const Node* node = &batches.back()[winner / INPUT_COUNT];
+      vector<uint8_t> inputs(node->tick + 1);
+      inputs[node->tick] = INPUTS[winner % INPUT_COUNT];
+      for (; node->tick > 0; node = &batches[node->parentBatch][node->parent]) {
+	inputs[node->tick - 1] = node->input;
+      }
+
+      cout << "Completable in " << inputs.size() << " ticks:";
+      for (size_t i = 0; i < inputs.size();) {
+	size_t run = i;
+	while (run < inputs.size() && inputs[run] == inputs[i]) {
+	  ++run;
+	}
+	cout << " " << run - i << "x" << name(inputs[i]);
+	i = run;
+      }
+      cout << endl << (replay(levelNumber, inputs) ? "Verified by replaying from the start"
+		       : "Replaying from the start did not reach the end") << endl;
+      return 0;
+    }
+    if (outcome == "exhausted") {
+      cout << "Not completable within " << maxTicks << " ticks: every state reachable "
+	   << "in that time without losing a life was explored and none reach the end" << endl;
+    } else {
+      cout << "Gave up after storing " << stored << " states" << endl;
+    }
+    return 2;
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
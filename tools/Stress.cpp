@@ -0,0 +1,660 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "../Allocations.h"
+#include "../Balls.h"
+#include "../BoxTree.h"
+#include "../Hazards.h"
+#include "../History.h"
+#include "../Jobs.h"
+#include "../Level.h"
+#include "../Masks.h"
+#include "../Race.h"
+#include "../Particles.h"
+#include "../Patrols.h"
+
+using namespace std;
+using namespace medieval;
+
+/**
+ * @file A stress test that generates a large level and runs the
+ * simulation on it, to see how the engine behaves at scale. It first
+ * times building the built-in levels, then times generating the 
+ * level on one thread and on all of them, checks the two levels are
+ * the same, then times ticks of a player running
+ * right through it and jumping now and then, on one thread and 
+ * spread over a job system, checking both stay the same and that
+ * going back and running again does too, and that the sprites asleep
+ * away from the player end up where they would have, and that going
+ * back a tick at a time through the history of the run does too. Then it times
+ * looking things up in the level, checking what is found against
+ * looking at everything, and times checking what the player touches
+ * by collision masks against by boxes alone. Last it times scripted
+ * hazards against fireballs moving themselves, and against working
+ * out where the fireballs are from the tick, which must agree.
+ *
+ * @author Alex Zilbersher & Ryan Malloney
+ */
+
+/**
+ * The clock used for timing. 
+ */
+typedef chrono::steady_clock Clock;
+
+/**
+ * Get the milliseconds since a time.
+ * @return the elapsed milliseconds
+ */
+static double since(Clock::time_point start) {
+  return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/**
+ * Get whether two saved levels are the same.
+ * @return whether every sprite matches
+ */
+static bool same(const Level::State& a, const Level::State& b) {
+  if (a.sprites.size() != b.sprites.size() || a.present != b.present ||
+      a.hazards.size() != b.hazards.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.sprites.size(); ++i) {
+    const SpriteState& s = a.sprites[i];
+    const SpriteState& t = b.sprites[i];
+    if (s.imageIndex != t.imageIndex || s.x != t.x || s.y != t.y || s.angle != t.angle ||
+	s.speedH != t.speedH || s.speedV != t.speedV || s.inAir != t.inAir || s.left != t.left) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a.hazards.size(); ++i) {
+    const Hazards::Frame& f = a.hazards[i];
+    const Hazards::Frame& g = b.hazards[i];
+    if (f.step != g.step || f.left != g.left || f.phase != g.phase || f.speed != g.speed ||
+	f.wake != g.wake) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Get the kind of thing a sprite is, as the level sees it.
+ * @return the kind, from Hit
+ */
+static unsigned kindOf(const Sprite& s) {
+  static const unsigned kinds[] = {0, 0, Hit::PLAYER, Hit::PLAYER, Hit::TERRAIN, Hit::OBSTACLES,
+				   Hit::OBSTACLES, Hit::HEALTH, Hit::COINS};
+  int image = s.getImageIndex();
+  return image >= 0 && image < 9 ? kinds[image] : 0;
+}
+
+/**
+ * Sweeps a box through a level by looking at every sprite in it and
+ * every tile on the grid near the line.
+ * @return the fraction of the line to the first thing hit, or 2 if
+ * nothing was
+ */
+static double slowSweep(const Level& level, int left, int top, int width, int height,
+			int dx, int dy, unsigned kinds) {
+  double nearest = 2;
+  double enter;
+  const TileMap& tiles = level.getTiles();
+  if (kinds & Hit::TERRAIN) {
+    for (int row = tiles.getRow(min(top, top + dy)); row <= tiles.getRow(max(top, top + dy) + height);
+	 ++row) {
+      for (int column = tiles.getColumn(min(left, left + dx));
+	   column <= tiles.getColumn(max(left, left + dx) + width); ++column) {
+	BoxTree::Box box = {tiles.getX(column), tiles.getY(row), tiles.getX(column) + TileMap::TILE,
+			    tiles.getY(row) + TileMap::TILE};
+	if (tiles.at(column, row) && BoxTree::crosses(box, left, top, dx, dy, width, height, 1, enter)) {
+	  nearest = min(nearest, enter);
+	}
+      }
+    }
+  }
+  for (const shared_ptr<Sprite>& s : level.getList()) {
+    BoxTree::Box box = {s->getXCoordinate(), s->getYCoordinate(),
+			s->getXCoordinate() + s->getWidth(), s->getYCoordinate() + s->getHeight()};
+    if ((kindOf(*s) & kinds) && BoxTree::crosses(box, left, top, dx, dy, width, height, 1, enter)) {
+      nearest = min(nearest, enter);
+    }
+  }
+  return nearest;
+}
+
+/**
+ * Counts what overlaps a box by looking at every sprite in a level
+ * and every tile on the grid in the box.
+ * @return the number overlapping
+ */
+static int slowOverlapping(const Level& level, int left, int top, int width, int height,
+			   unsigned kinds) {
+  int count = 0;
+  const TileMap& tiles = level.getTiles();
+  if (kinds & Hit::TERRAIN) {
+    for (int row = tiles.getRow(top); row <= tiles.getRow(top + height - 1); ++row) {
+      for (int column = tiles.getColumn(left); column <= tiles.getColumn(left + width - 1); ++column) {
+	count += tiles.at(column, row);
+      }
+    }
+  }
+  for (const shared_ptr<Sprite>& s : level.getList()) {
+    count += (kindOf(*s) & kinds) && s->getXCoordinate() < left + width &&
+      s->getXCoordinate() + s->getWidth() > left && s->getYCoordinate() < top + height &&
+      s->getYCoordinate() + s->getHeight() > top;
+  }
+  return count;
+}
+
+/**
+ * The stress test. Run as "stress seed sprites [ticks] [threads]".
+ * @return 0 if the level generated and ran the same way on every 
+ * thread count, otherwise 1
+ */
+int main(int argc, char* argv[]) {
+  try {
+    if (argc < 3 || argc > 5) {
+      cerr << "Usage: " << argv[0] << " seed sprites [ticks] [threads]" << endl;
+      return 1;
+    }
+    unsigned seed = stoul(argv[1]);
+    int sprites = stoi(argv[2]);
+    int ticks = argc > 3 ? stoi(argv[3]) : 600;
+    int threads = argc > 4 ? stoi(argv[4]) : max(1u, thread::hardware_concurrency());
+
+    // build the built-in levels over and over, as starting a game does
+    const int builds = 10000;
+    for (int number = 1; number <= 2; ++number) {
+      long before = Allocations::getCount();
+      Clock::time_point start = Clock::now();
+      for (int i = 0; i < builds; ++i) {
+	Level level(number);
+      }
+      cout << "Built level " << number << " in " << since(start) * 1000 / builds
+	   << " microseconds with " << (Allocations::getCount() - before) / builds
+	   << " allocations" << endl;
+    }
+
+    Clock::time_point start = Clock::now();
+    Level serial(3, seed, sprites, 1);
+    double serialTime = since(start);
+
+    start = Clock::now();
+    Level parallel(3, seed, sprites, threads);
+    double parallelTime = since(start);
+
+    Level::State a;
+    Level::State b;
+    serial.save(a);
+    parallel.save(b);
+    size_t count = a.sprites.size();
+    cout << "Generated " << count << " sprites over " << serial.getWidth() << " pixels in "
+	 << serialTime << " ms on 1 thread and " << parallelTime << " ms on " << threads
+	 << " (" << count / max(parallelTime, 1e-6) * 1000 << " sprites per second)" << endl;
+    const TileMap& tiles = parallel.getTiles();
+    cout << "Stored " << tiles.getCount() << " tiles on the grid in " << tiles.getBytes()
+	 << " bytes" << endl;
+    if (!same(a, b) || tiles.getCount() != serial.getTiles().getCount()) {
+      cout << "The level differs between 1 and " << threads << " threads" << endl;
+      return 1;
+    }
+
+    // run right through the level, jumping every so often, once on
+    // one thread and once spread over the jobs
+    Jobs jobs(threads);
+    parallel.setJobs(&jobs);
+    Race::Racer serialRacer;
+    Race::Racer racer;
+    double serialTotal = 0;
+    double total = 0;
+    double slowest = 0;
+    long allocations = 0;
+    Level::State middle;
+    Race::Racer middleRacer;
+    for (int tick = 0; tick < ticks; ++tick) {
+      uint8_t input = Race::RIGHT | (tick % 40 == 0 ? Race::UP : 0);
+      if (tick == ticks / 2) {
+	serial.save(middle);
+	middleRacer = serialRacer;
+      }
+      start = Clock::now();
+      Race::step(serial, serialRacer, input, tick);
+      serialTotal += since(start);
+
+      long before = Allocations::getCount();
+      start = Clock::now();
+      Race::step(parallel, racer, input, tick);
+      double time = since(start);
+      allocations += Allocations::getCount() - before;
+      total += time;
+      slowest = max(slowest, time);
+
+      serial.save(a);
+      parallel.save(b);
+      if (!same(a, b) || serialRacer.health != racer.health || serialRacer.lives != racer.lives ||
+	  serialRacer.score != racer.score || serialRacer.finished != racer.finished) {
+	cout << "The level ran differently on " << threads << " threads at tick " << tick << endl;
+	return 1;
+      }
+    }
+    // go back to the middle and run the rest again, as a rollback
+    // would, which must end up in the same place
+    serial.restore(middle);
+    for (int tick = ticks / 2; tick < ticks; ++tick) {
+      Race::step(serial, middleRacer, Race::RIGHT | (tick % 40 == 0 ? Race::UP : 0), tick);
+    }
+    serial.save(a);
+    if (!same(a, b) || middleRacer.health != racer.health || middleRacer.score != racer.score) {
+      cout << "Running again from tick " << ticks / 2 << " went differently" << endl;
+      return 1;
+    }
+    cout << "Simulated " << ticks << " ticks at " << serialTotal / max(ticks, 1)
+	 << " ms per tick on 1 thread and " << total / max(ticks, 1) << " ms on " << threads
+	 << " (" << serialTotal / max(total, 1e-6) << " times faster, slowest " << slowest
+	 << " ms, " << jobs.getSteals() << " ranges stolen), the same on both, " << racer.lives
+	 << " lives left, " << allocations << " allocations" << endl;
+    if (allocations > 0) {
+      cout << "Running through the level allocated" << endl;
+      return 1;
+    }
+
+    // run through once more with every sprite awake, against the
+    // sprites sleeping away from the player, which must stay the same
+    Level everything(3, seed, sprites, 1);
+    Level near(3, seed, sprites, 1);
+    everything.setActivation(-1);
+    Race::Racer everythingRacer;
+    Race::Racer nearRacer;
+    double everythingTotal = 0;
+    double nearTotal = 0;
+    long sleeping = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+      uint8_t input = Race::RIGHT | (tick % 40 == 0 ? Race::UP : 0);
+      start = Clock::now();
+      Race::step(everything, everythingRacer, input, tick);
+      everythingTotal += since(start);
+
+      start = Clock::now();
+      Race::step(near, nearRacer, input, tick);
+      nearTotal += since(start);
+      sleeping += near.getAsleep();
+
+      everything.save(a);
+      near.save(b);
+      if (!same(a, b) || everythingRacer.health != nearRacer.health ||
+	  everythingRacer.score != nearRacer.score || everythingRacer.lives != nearRacer.lives) {
+	cout << "The level ran differently with sprites asleep at tick " << tick << endl;
+	return 1;
+      }
+    }
+    cout << "Simulated " << ticks << " ticks at " << everythingTotal / max(ticks, 1)
+	 << " ms per tick with every sprite awake and " << nearTotal / max(ticks, 1)
+	 << " ms with " << near.getAwake() << " awake near the player and "
+	 << sleeping / max(ticks, 1) << " asleep on average, the same on both" << endl;
+
+    // run through again remembering every tick, go back over as many
+    // as the history kept, checking the last second of them against
+    // copies of the whole level, then run forward again from where it
+    // got back to, which must end up where the first run did
+    Level rewound(3, seed, sprites, 1);
+    Race::Racer rewoundRacer;
+    History history;
+    int values[History::VALUES] = {};
+    auto note = [&](const Race::Racer& racer) {
+      values[0] = racer.health;
+      values[1] = racer.lives;
+      values[2] = racer.score;
+      values[3] = racer.finished;
+    };
+    note(rewoundRacer);
+    history.start(rewound, values);
+    const int recent = min(ticks, 60);
+    vector<Level::State> copies(recent);
+    double recordTotal = 0;
+    long recordAllocations = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+      Race::step(rewound, rewoundRacer, Race::RIGHT | (tick % 40 == 0 ? Race::UP : 0), tick);
+      note(rewoundRacer);
+      long before = Allocations::getCount();
+      start = Clock::now();
+      history.record(rewound, values);
+      recordTotal += since(start);
+      recordAllocations += Allocations::getCount() - before;
+      if (tick >= ticks - recent) {
+	rewound.save(copies[tick - (ticks - recent)]);
+      }
+    }
+    Level::State end;
+    rewound.save(end);
+    int kept = history.getTicks();
+    int changes = history.getChanges();
+    double rewindTotal = 0;
+    double slowestRewind = 0;
+    for (int back = 0; back < kept; ++back) {
+      start = Clock::now();
+      history.rewind(rewound, values);
+      double time = since(start);
+      rewindTotal += time;
+      slowestRewind = max(slowestRewind, time);
+
+      // the level is now as it was after an earlier tick
+      int tick = ticks - 2 - back;
+      if (tick >= ticks - recent) {
+	rewound.save(a);
+	if (!same(a, copies[tick - (ticks - recent)])) {
+	  cout << "Going back through the history went wrong at tick " << tick << endl;
+	  return 1;
+	}
+      }
+    }
+    Race::Racer again;
+    again.health = values[0];
+    again.lives = values[1];
+    again.score = values[2];
+    again.finished = values[3];
+    for (int tick = ticks - kept; tick < ticks; ++tick) {
+      Race::step(rewound, again, Race::RIGHT | (tick % 40 == 0 ? Race::UP : 0), tick);
+    }
+    rewound.save(a);
+    if (!same(a, end) || again.health != rewoundRacer.health || again.lives != rewoundRacer.lives ||
+	again.score != rewoundRacer.score) {
+      cout << "Running forward again after going back " << kept << " ticks went differently" << endl;
+      return 1;
+    }
+    start = Clock::now();
+    rewound.restore(end);
+    double restoreTime = since(start);
+    cout << "Remembered " << kept << " of " << ticks << " ticks in " << history.getBytes()
+	 << " bytes, " << changes / max(kept, 1) << " sprite changes a tick, at "
+	 << recordTotal / max(ticks, 1) << " ms per tick with " << recordAllocations
+	 << " allocations, and went back over them at " << rewindTotal / max(kept, 1)
+	 << " ms per tick (slowest " << slowestRewind << " ms, against " << restoreTime
+	 << " ms to restore the whole level), ending up where it was" << endl;
+    if (recordAllocations > 0) {
+      cout << "Remembering the run allocated" << endl;
+      return 1;
+    }
+    if (kept < min(ticks, History::TICKS)) {
+      cout << "The history only kept " << kept << " of " << ticks << " ticks" << endl;
+      return 1;
+    }
+
+    // look along lines from around the player for anything in the
+    // way, sweep its box about, and look for coins near it, checking
+    // against looking at everything in the level with every sprite
+    // awake, which is where the sprites asleep would be
+    mt19937 random(seed);
+    uniform_int_distribution<int> offset(-540, 540);
+    const int queries = 20000;
+    const int checks = 200;
+    vector<Ray> rays(queries);
+    int playerX = near.getPlayer().lock()->getXCoordinate();
+    int playerY = near.getPlayer().lock()->getYCoordinate();
+    for (int i = 0; i < queries; ++i) {
+      Ray& ray = rays[i];
+      ray.x = playerX + offset(random);
+      ray.y = playerY + offset(random) / 2;
+      ray.dx = offset(random);
+      ray.dy = offset(random) / 2;
+      ray.width = i % 2 == 0 ? 0 : 50;
+      ray.height = i % 2 == 0 ? 0 : 50;
+      ray.kinds = i % 3 == 0 ? Hit::EVERYTHING : Hit::TERRAIN | Hit::OBSTACLES;
+    }
+    vector<Hit> hits(queries);
+    vector<Hit> found;
+    found.reserve(1000);
+    long queryBefore = Allocations::getCount();
+    start = Clock::now();
+    int blocked = 0;
+    for (int i = 0; i < queries; i += 2) {
+      blocked += near.raycast(rays[i].x, rays[i].y, rays[i].dx, rays[i].dy, rays[i].kinds, hits[i]);
+    }
+    double raycastTime = since(start);
+    start = Clock::now();
+    for (int i = 1; i < queries; i += 2) {
+      near.sweep(rays[i].x, rays[i].y, rays[i].width, rays[i].height, rays[i].dx, rays[i].dy,
+		 rays[i].kinds, hits[i]);
+    }
+    double sweepTime = since(start);
+    start = Clock::now();
+    long coins = 0;
+    for (int i = 0; i < queries; ++i) {
+      found.clear();
+      coins += near.within(rays[i].x, rays[i].y, 150, Hit::COINS | Hit::HEALTH, found);
+    }
+    double withinTime = since(start);
+    long queryAllocations = Allocations::getCount() - queryBefore;
+    vector<Hit> batch(queries);
+    near.setJobs(&jobs);
+    start = Clock::now();
+    near.cast(rays.data(), queries, batch.data());
+    double castTime = since(start);
+    near.setJobs(nullptr);
+    for (int i = 0; i < queries; ++i) {
+      if (batch[i].kind != hits[i].kind || batch[i].fraction != hits[i].fraction) {
+	cout << "Casting rays together found something else for ray " << i << endl;
+	return 1;
+      }
+      if (i % (queries / checks) == 0) {
+	const Ray& ray = rays[i];
+	double slow = slowSweep(everything, ray.x, ray.y, ray.width, ray.height, ray.dx, ray.dy,
+				ray.kinds);
+	if ((slow <= 1) != (hits[i].kind != 0) || (slow <= 1 && slow != hits[i].fraction)) {
+	  cout << "Ray " << i << " hit something else than looking at everything does" << endl;
+	  return 1;
+	}
+	found.clear();
+	if (near.overlapping(ray.x, ray.y, abs(ray.dx) + 1, abs(ray.dy) + 1, ray.kinds, found) !=
+	    slowOverlapping(everything, ray.x, ray.y, abs(ray.dx) + 1, abs(ray.dy) + 1, ray.kinds)) {
+	  cout << "A box overlapped something else than looking at everything does" << endl;
+	  return 1;
+	}
+      }
+    }
+    cout << "Cast " << queries / 2 << " rays in " << raycastTime * 1000 / (queries / 2)
+	 << " microseconds each (" << blocked << " blocked), swept as many boxes in "
+	 << sweepTime * 1000 / (queries / 2) << ", looked for coins " << queries << " times in "
+	 << withinTime * 1000 / queries << " (" << coins << " found), " << queryAllocations
+	 << " allocations, and cast them all together in " << castTime << " ms on " << threads
+	 << " threads, the same as looking at everything" << endl;
+
+    // check what the player touches by masks, here circles about as
+    // solid as the real images, first checking the masks overlap
+    // exactly where their pixels do
+    Mask round(700, 700);
+    for (int y = 0; y < 700; ++y) {
+      for (int x = 0; x < 700; ++x) {
+	if ((x - 350) * (x - 350) + (y - 350) * (y - 350) < 280 * 280) {
+	  round.set(x, y);
+	}
+      }
+    }
+    Masks masks;
+    for (int image = 2; image <= 8; ++image) {
+      masks.add(image, round);
+    }
+    masks.fit(2, 80, 80);
+    masks.fit(3, 80, 80);
+    masks.fit(5, 50, 50, 30);
+    masks.fit(6, 50, 50, 20);
+    masks.fit(7, 50, 50);
+    masks.fit(8, 50, 50);
+    const int pairs = 100000;
+    vector<Sprite> touching;
+    touching.reserve(pairs);
+    Sprite body(2, 1000, 500, 80, 80);
+    for (int i = 0; i < pairs; ++i) {
+      touching.emplace_back(i % 2 == 0 ? 6 : 8, 1000 + offset(random) % 75, 500 + offset(random) % 75,
+			    50, 50);
+      SpriteState turned;
+      touching.back().save(turned);
+      turned.angle = static_cast<int>(random() % 360);
+      touching.back().restore(turned);
+    }
+    for (int i = 0; i < pairs; i += pairs / checks) {
+      const Sprite& s = touching[i];
+      bool pixels = false;
+      const Mask& a = *masks.find(s);
+      const Mask& b = *masks.find(body);
+      for (int y = 0; y < 50 && !pixels; ++y) {
+	for (int x = 0; x < 50 && !pixels; ++x) {
+	  pixels = a.at(x, y) && b.at(s.getXCoordinate() + x - 1000, s.getYCoordinate() + y - 500);
+	}
+      }
+      if (pixels != masks.hit(s, body)) {
+	cout << "Masks " << i << " overlap differently from their pixels" << endl;
+	return 1;
+      }
+    }
+    int boxHits = 0;
+    start = Clock::now();
+    for (const Sprite& s : touching) {
+      boxHits += s.hits(body);
+    }
+    double boxTime = since(start);
+    int maskHits = 0;
+    start = Clock::now();
+    for (const Sprite& s : touching) {
+      maskHits += s.hits(body) && masks.hit(s, body);
+    }
+    double maskTime = since(start);
+
+    // and run through the level with the masks against without
+    Level boxed(3, seed, sprites, 1);
+    Level masked(3, seed, sprites, 1);
+    masked.setMasks(&masks);
+    Race::Racer boxedRacer;
+    Race::Racer maskedRacer;
+    double boxedTotal = 0;
+    double maskedTotal = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+      uint8_t input = Race::RIGHT | (tick % 40 == 0 ? Race::UP : 0);
+      start = Clock::now();
+      Race::step(boxed, boxedRacer, input, tick);
+      boxedTotal += since(start);
+      start = Clock::now();
+      Race::step(masked, maskedRacer, input, tick);
+      maskedTotal += since(start);
+    }
+    cout << "Checked " << pairs << " sprites whose boxes touch the player by box in "
+	 << boxTime * 1e6 / pairs << " ns each (" << boxHits << " touching) and by mask in "
+	 << maskTime * 1e6 / pairs << " ns (" << maskHits << " touching), the same as their pixels,"
+	 << " and simulated the level at " << boxedTotal / max(ticks, 1) << " ms per tick by box ("
+	 << boxedRacer.lives << " lives, " << boxedRacer.score << " points) and "
+	 << maskedTotal / max(ticks, 1) << " ms by mask (" << maskedRacer.lives << " lives, "
+	 << maskedRacer.score << " points)" << endl;
+
+    // trail embers behind every fireball in the level at once
+    Particles particles;
+    double updates = 0;
+    long live = 0;
+    long particleAllocations = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+      long before = Allocations::getCount();
+      for (const shared_ptr<Sprite>& sprite : parallel.getList()) {
+	if (sprite->getImageIndex() == 5 || sprite->getImageIndex() == 6) {
+	  particles.trail(*sprite);
+	}
+      }
+      particles.update();
+      particleAllocations += Allocations::getCount() - before;
+      updates += particles.getUpdateTime();
+      live += particles.size();
+    }
+    cout << "Updated " << live / max(ticks, 1) << " particles at " << updates / max(ticks, 1)
+	 << " ms per tick, " << particles.getDropped() << " dropped, " << particleAllocations
+	 << " allocations" << endl;
+    if (particleAllocations > 0) {
+      cout << "Trailing and updating particles allocated" << endl;
+      return 1;
+    }
+
+    // resume as many scripted hazards as the level has sprites, and
+    // move the same number of fireballs through their move function
+    const Behavior* behaviors[] = {&Behavior::dasher(), &Behavior::dropper(), &Behavior::orbiter()};
+    vector<shared_ptr<Sprite>> scripted;
+    vector<shared_ptr<Sprite>> balls;
+    Hazards hazards;
+    hazards.reserve(count);
+    Patrols patrols;
+    patrols.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      int x = static_cast<int>(i % 1000) * 10 + 100;
+      int y = static_cast<int>(i / 1000 % 50) * 10 + 300;
+      scripted.push_back(make_shared<Hazard>(Hazard(6, x, y, *behaviors[i % 3])));
+      hazards.add(static_cast<Hazard&>(*scripted.back()));
+      balls.push_back(make_shared<Balls>(Balls(6, x, y, x - 50, x + 50, i % 2 == 0)));
+      patrols.add(static_cast<Balls&>(*balls.back()), 0);
+    }
+    vector<int> patrolX(count);
+    vector<uint8_t> patrolLeft(count);
+    vector<int> patrolAngle(count);
+    double patrolTotal = 0;
+    double scriptedTotal = 0;
+    double movedTotal = 0;
+    long awake = 0;
+    long before = Allocations::getCount();
+    for (int tick = 0; tick < ticks; ++tick) {
+      start = Clock::now();
+      hazards.resume();
+      scriptedTotal += since(start);
+      awake += hazards.getAwake();
+
+      start = Clock::now();
+      for (shared_ptr<Sprite>& sprite : balls) {
+	sprite->move();
+      }
+      movedTotal += since(start);
+
+      start = Clock::now();
+      patrols.at(tick + 1, patrolX.data(), patrolLeft.data(), patrolAngle.data());
+      patrolTotal += since(start);
+      for (size_t i = 0; i < count; ++i) {
+	SpriteState state;
+	balls[i]->save(state);
+	if (state.x != patrolX[i] || state.left != patrolLeft[i] ||
+	    state.angle != patrolAngle[i]) {
+	  cout << "Fireball " << i << " isn't where its patrol puts it at tick " << tick + 1 << endl;
+	  return 1;
+	}
+      }
+    }
+    cout << "Resumed " << count << " scripted hazards at " << scriptedTotal / max(ticks, 1)
+	 << " ms per tick (" << awake / max(ticks, 1) << " awake on average, "
+	 << Allocations::getCount() - before << " allocations), against "
+	 << movedTotal / max(ticks, 1) << " ms moving as many fireballs and "
+	 << patrolTotal / max(ticks, 1) << " ms working out where they are from the tick" << endl;
+
+    // and far ahead, which takes no longer
+    start = Clock::now();
+    patrols.at(1 << 30, patrolX.data(), patrolLeft.data(), patrolAngle.data());
+    double aheadTime = since(start);
+    for (size_t i = 0; i < count; i += 97) {
+      Balls ball = static_cast<Balls&>(*balls[i]);
+      long long moved = ball.getAngle() + static_cast<long long>(ball.getPatrol().spin) * ((1 << 30) - ticks);
+      ball.skip((1 << 30) - ticks);
+      if (ball.getXCoordinate() != patrolX[i] || ball.getAngle() != patrolAngle[i]) {
+	cout << "Fireball " << i << " skipped somewhere else than its patrol puts it" << endl;
+	return 1;
+      }
+
+      // every move turns it the same way, so that many would leave it
+      // at the same point in a turn
+      if (ball.getAngle() != (moved % 360 + 360) % 360) {
+	cout << "Fireball " << i << " skipped to another angle than moving would turn it to" << endl;
+	return 1;
+      }
+    }
+    cout << "Worked out where they all are " << (1 << 30) << " ticks ahead in " << aheadTime
+	 << " ms" << endl;
+    return 0;
+  } catch (const exception& e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}